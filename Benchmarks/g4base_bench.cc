@@ -0,0 +1,422 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  g4base_bench.cc
+/// \brief End-to-end benchmark of the G4Base simulation chain
+///
+/// Builds a G4Helper on the bundled test geometry (g4base_bench.gdml,
+/// liquid argon in a steel cryostat inside a rock hall), registers
+/// UserActions through the UserActionFactory and tracks fixed samples
+/// of primaries handed over as MCTruths through ConvertMCTruthToG4:
+///
+///   muon   single 4 GeV/c mu- through the argon
+///   em     single 2 GeV/c e-, a contained electromagnetic shower
+///   genie  GENIE-like CC events: a mu-, nucleons, pions and a gamma
+///          from a vertex in the argon, with an argon nucleus that is
+///          not tracked
+///
+///   g4base_bench [-g geometry.gdml] [-p physicslist] [-n events]
+///                [-s sample] [-a action,action,...] [-r seed] [-T]
+///                [-e subevents[,workers]]
+///
+/// For every sample it prints events/s, steps/s, resident and peak
+/// memory, and the time spent in each UserAction (wrapped in a timer,
+/// which costs two clock reads per call; -T turns that off to see the
+/// bare throughput).  The default actions are g4b::VoxelEdepAction and
+/// g4b::ThinParticleAction, configured with their default parameters.
+/// Primaries come from TRandom3 seeded with the seed and event number,
+/// so repeated runs track the same events.  There is no magnetic
+/// field and no art service is needed.
+///
+/// -e tracks every event as that many sub-events
+/// (G4Helper::SetSubEventTracking), spread over that many forked worker
+/// processes.  Workers can only be forked from a single threaded
+/// process, so this driver, not an art job, is where sub-events run
+/// concurrently.  Step counts and action times of the workers are
+/// merged back with the sub-events.
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ROOT includes
+#include "TLorentzVector.h"
+#include "TRandom3.h"
+
+// Framework includes
+#include "fhiclcpp/ParameterSet.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+// Geant4 includes
+#include "Geant4/G4UImanager.hh"
+#include "Geant4/G4Step.hh"
+#include "Geant4/G4Track.hh"
+
+// NuTools includes
+#include "SimulationBase/MCTruth.h"
+#include "SimulationBase/MCParticle.h"
+#include "G4Base/G4Helper.h"
+#include "G4Base/UserAction.h"
+#include "G4Base/UserActionManager.h"
+#include "G4Base/UserActionFactory.h"
+#include "G4Base/SubEventBuffer.h"
+
+#ifndef G4BENCH_GDML
+#define G4BENCH_GDML "g4base_bench.gdml"
+#endif
+
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  //......................................................................
+  /// Counts the steps and tracks of the current sample; not timed.
+  /// A sub-event hands over what it added since the last one and takes
+  /// it out of the totals, the merge puts it back.
+  class StepCounter : public g4b::UserAction {
+  public:
+    StepCounter() : fSteps(0), fTracks(0), fSubSteps(0), fSubTracks(0) {}
+    void BeginOfEventAction(const G4Event*) { fSubSteps = fSteps; fSubTracks = fTracks; }
+    void PreTrackingAction(const G4Track*)  { ++fTracks; }
+    void SteppingAction(const G4Step*)      { ++fSteps;  }
+
+    bool ProvidesSubEventMerge() { return true; }
+    void WriteSubEvent(std::string& buffer)
+    {
+      g4b::SubEventWriter out(buffer);
+      out.Put(fSteps  - fSubSteps);
+      out.Put(fTracks - fSubTracks);
+      fSteps  = fSubSteps;
+      fTracks = fSubTracks;
+    }
+    void MergeSubEvent(std::string const& buffer, int)
+    {
+      long steps = 0, tracks = 0;
+      g4b::SubEventReader in(buffer);
+      in.Get(steps);
+      in.Get(tracks);
+      fSteps  += steps;
+      fTracks += tracks;
+    }
+
+    long fSteps;
+    long fTracks;
+    long fSubSteps;   ///< fSteps at the start of the event
+    long fSubTracks;  ///< fTracks at the start of the event
+  };
+
+  //......................................................................
+  /// Forwards every hook to the action it owns and sums the time spent.
+  class TimedAction : public g4b::UserAction {
+  public:
+    explicit TimedAction(g4b::UserAction* action)
+      : fAction(action), fSecs(0.), fCalls(0), fSubSecs(0.), fSubCalls(0)
+    {
+      this->SetName(action->GetName());
+    }
+    ~TimedAction() { delete fAction; }
+
+    void Config(fhicl::ParameterSet const& pset) { fAction->Config(pset);     }
+    void PrintConfig(std::string const& opt)     { fAction->PrintConfig(opt); }
+
+    void BeginOfRunAction  (const G4Run*   r) { Timer t(*this); fAction->BeginOfRunAction(r);   }
+    void EndOfRunAction    (const G4Run*   r) { Timer t(*this); fAction->EndOfRunAction(r);     }
+    void BeginOfEventAction(const G4Event* e) { Timer t(*this); fAction->BeginOfEventAction(e); }
+    void EndOfEventAction  (const G4Event* e) { Timer t(*this); fAction->EndOfEventAction(e);   }
+    void PreTrackingAction (const G4Track* t) { Timer u(*this); fAction->PreTrackingAction(t);  }
+    void PostTrackingAction(const G4Track* t) { Timer u(*this); fAction->PostTrackingAction(t); }
+    void SteppingAction    (const G4Step*  s) { Timer t(*this); fAction->SteppingAction(s);     }
+
+    bool ProvidesStacking() { return fAction->ProvidesStacking(); }
+    G4ClassificationOfNewTrack StackClassifyNewTrack(const G4Track* t)
+    {
+      Timer u(*this);
+      return fAction->StackClassifyNewTrack(t);
+    }
+    void StackNewStage()        { Timer t(*this); fAction->StackNewStage();        }
+    void StackPrepareNewEvent() { Timer t(*this); fAction->StackPrepareNewEvent(); }
+    void EnergySpotAction(const g4b::EnergySpot& s) { Timer t(*this); fAction->EnergySpotAction(s); }
+
+    // the time spent in a sub-event travels with the action's buffer
+    bool ProvidesSubEventMerge() { return fAction->ProvidesSubEventMerge(); }
+    void WriteSubEvent(std::string& buffer)
+    {
+      std::string inner;
+      fAction->WriteSubEvent(inner);
+      g4b::SubEventWriter out(buffer);
+      out.Put(fSecs  - fSubSecs);
+      out.Put(fCalls - fSubCalls);
+      out.Put(inner);
+      fSecs  = fSubSecs;
+      fCalls = fSubCalls;
+    }
+    void ClearSubEvents() { fAction->ClearSubEvents(); fSubSecs = fSecs; fSubCalls = fCalls; }
+    void MergeSubEvent(std::string const& buffer, int trackIDOffset)
+    {
+      double      secs  = 0.;
+      long        calls = 0;
+      std::string inner;
+      g4b::SubEventReader in(buffer);
+      in.Get(secs);
+      in.Get(calls);
+      in.Get(inner);
+      fSecs  += secs;
+      fCalls += calls;
+      fAction->MergeSubEvent(inner, trackIDOffset);
+      fSubSecs  = fSecs;
+      fSubCalls = fCalls;
+    }
+
+    void Reset() { fSecs = fSubSecs = 0.; fCalls = fSubCalls = 0; }
+
+    g4b::UserAction* fAction;
+    double           fSecs;
+    long             fCalls;
+    double           fSubSecs;   ///< fSecs at the start of the sub-event
+    long             fSubCalls;  ///< fCalls at the start of the sub-event
+
+  private:
+    struct Timer {
+      explicit Timer(TimedAction& a) : fA(a), fT0(Clock::now()) {}
+      ~Timer()
+      {
+        fA.fSecs += std::chrono::duration<double>(Clock::now() - fT0).count();
+        ++fA.fCalls;
+      }
+      TimedAction&      fA;
+      Clock::time_point fT0;
+    };
+  };
+
+  //......................................................................
+  /// resident and peak resident memory in MB, from /proc/self/status
+  void Memory(double& rss, double& peak)
+  {
+    rss = peak = 0.;
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+      if      (line.compare(0, 6, "VmRSS:") == 0) rss  = std::atof(line.c_str() + 6)/1024.;
+      else if (line.compare(0, 6, "VmHWM:") == 0) peak = std::atof(line.c_str() + 6)/1024.;
+    }
+  }
+
+  //......................................................................
+  /// a status 1 particle at pos (cm) with momentum p (GeV/c) along dir
+  void AddParticle(simb::MCTruth& truth, int pdg, double mass,
+                   TLorentzVector const& pos, TVector3 dir, double p)
+  {
+    dir.SetMag(p);
+    simb::MCParticle part(truth.NParticles(), pdg, "primary", -1, mass, 1);
+    part.AddTrajectoryPoint(pos, TLorentzVector(dir, std::sqrt(p*p + mass*mass)));
+    truth.Add(part);
+  }
+
+  //......................................................................
+  simb::MCTruth MakeMuon(TRandom3& rand)
+  {
+    simb::MCTruth truth;
+    double tx = rand.Gaus(0., 0.05);
+    double ty = rand.Gaus(0., 0.05);
+    TVector3 dir(tx, ty, 1.);
+    AddParticle(truth, 13, 0.105658, TLorentzVector(0., 0., -240., 0.), dir, 4.);
+    return truth;
+  }
+
+  //......................................................................
+  simb::MCTruth MakeEM(TRandom3& rand)
+  {
+    simb::MCTruth truth;
+    double tx = rand.Gaus(0., 0.05);
+    double ty = rand.Gaus(0., 0.05);
+    TVector3 dir(tx, ty, 1.);
+    AddParticle(truth, 11, 0.000511, TLorentzVector(0., 0., -200., 0.), dir, 2.);
+    return truth;
+  }
+
+  //......................................................................
+  TVector3 Isotropic(TRandom3& rand)
+  {
+    double x, y, z;
+    rand.Sphere(x, y, z, 1.);
+    return TVector3(x, y, z);
+  }
+
+  //......................................................................
+  simb::MCTruth MakeGenieLike(TRandom3& rand)
+  {
+    simb::MCTruth truth;
+    double vx = rand.Uniform( -80.,  80.);
+    double vy = rand.Uniform( -80.,  80.);
+    double vz = rand.Uniform(-200., 100.);
+    TLorentzVector vtx(vx, vy, vz, 0.);
+
+    // the struck nucleus, not tracked
+    simb::MCParticle nucleus(0, 1000180400, "primary", -1, 37.2155, 0);
+    nucleus.AddTrajectoryPoint(vtx, TLorentzVector(0., 0., 0., 37.2155));
+    truth.Add(nucleus);
+
+    // pdg, mass (GeV), momentum range (GeV/c); the muon goes forward,
+    // the hadrons and the gamma in random directions
+    struct Final { int pdg; double mass, pmin, pmax; };
+    const Final finals[] = { {   13, 0.105658, 1.5,  3.  },
+                             { 2212, 0.938272, 0.3,  1.  },
+                             { 2212, 0.938272, 0.2,  0.6 },
+                             { 2112, 0.939565, 0.2,  0.6 },
+                             {  211, 0.139570, 0.1,  0.8 },
+                             {  111, 0.134977, 0.1,  0.8 },
+                             {   22, 0.,       0.01, 0.1 } };
+    for (size_t i = 0; i < sizeof(finals)/sizeof(finals[0]); ++i) {
+      // one draw per statement so the sequence does not depend on the
+      // compiler's order of evaluating arguments
+      TVector3 dir;
+      if (i == 0) {
+        double tx = rand.Gaus(0., 0.3);
+        double ty = rand.Gaus(0., 0.3);
+        dir.SetXYZ(tx, ty, 1.);
+      }
+      else dir = Isotropic(rand);
+      double p = rand.Uniform(finals[i].pmin, finals[i].pmax);
+      AddParticle(truth, finals[i].pdg, finals[i].mass, vtx, dir, p);
+    }
+    return truth;
+  }
+
+  //......................................................................
+  void Usage()
+  {
+    std::fprintf(stderr,
+                 "usage: g4base_bench [-g geometry.gdml] [-p physicslist] [-n events]\n"
+                 "                    [-s sample] [-a action,action,...] [-r seed] [-T]\n"
+                 "                    [-e subevents[,workers]]\n");
+    std::exit(1);
+  }
+
+}
+
+//......................................................................
+int main(int argc, char** argv)
+{
+  std::string gdml    = G4BENCH_GDML;
+  std::string physics = "QGSP_BERT";
+  std::string filter;
+  std::string actions = "g4b::VoxelEdepAction,g4b::ThinParticleAction";
+  int         nevents = 20;
+  unsigned    seed    = 12345;
+  bool        timed   = true;
+  unsigned    nsub    = 0;
+  unsigned    nwork   = 1;
+
+  for (int i = 1; i < argc; ++i) {
+    if      (std::strcmp(argv[i], "-g") == 0 && i+1 < argc) gdml    = argv[++i];
+    else if (std::strcmp(argv[i], "-p") == 0 && i+1 < argc) physics = argv[++i];
+    else if (std::strcmp(argv[i], "-n") == 0 && i+1 < argc) nevents = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "-s") == 0 && i+1 < argc) filter  = argv[++i];
+    else if (std::strcmp(argv[i], "-a") == 0 && i+1 < argc) actions = argv[++i];
+    else if (std::strcmp(argv[i], "-r") == 0 && i+1 < argc) seed    = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "-T") == 0)               timed   = false;
+    else if (std::strcmp(argv[i], "-e") == 0 && i+1 < argc) {
+      if (std::sscanf(argv[++i], "%u,%u", &nsub, &nwork) < 1) Usage();
+    }
+    else                                                    Usage();
+  }
+
+  mf::StartMessageFacility(mf::MessageFacilityService::SingleThread,
+                           mf::MessageFacilityService::logConsole());
+
+  Clock::time_point t0 = Clock::now();
+
+  g4b::G4Helper helper("", physics, gdml);
+  helper.SetValidateGDMLSchema(false);
+  helper.SetUseFieldService(false);
+  helper.InitPhysics();
+
+  // the counter first, then the benchmarked actions in the order given
+  g4b::UserActionManager* uam = g4b::UserActionManager::Instance();
+  StepCounter* counter = new StepCounter;
+  counter->SetName("StepCounter");
+  uam->AddAndAdoptAction(counter);
+
+  std::vector<TimedAction*> timers;
+  std::stringstream as(actions);
+  std::string name;
+  fhicl::ParameterSet defaults;
+  while (std::getline(as, name, ',')) {
+    if (name.empty()) continue;
+    g4b::UserAction* action = g4b::UserActionFactory::Instance().GetUserAction(name);
+    if (!action) {
+      std::fprintf(stderr, "g4base_bench: no UserAction %s\n", name.c_str());
+      return 1;
+    }
+    action->SetName(name);
+    action->Config(defaults);
+    if (timed) {
+      TimedAction* timer = new TimedAction(action);
+      timers.push_back(timer);
+      uam->AddAndAdoptAction(timer);
+    }
+    else uam->AddAndAdoptAction(action);
+  }
+
+  helper.SetUserAction();
+  if (nsub > 0) helper.SetSubEventTracking(nsub, nwork, seed);
+
+  G4UImanager* ui = G4UImanager::GetUIpointer();
+  ui->ApplyCommand("/run/verbose 0");
+  ui->ApplyCommand("/event/verbose 0");
+  ui->ApplyCommand("/tracking/verbose 0");
+
+  double rss, peak;
+  Memory(rss, peak);
+  std::printf("g4base_bench: %s, %s, initialized in %.2f s, %.0f MB resident\n",
+              physics.c_str(), gdml.c_str(),
+              std::chrono::duration<double>(Clock::now() - t0).count(), rss);
+  if (nsub > 0) std::printf("g4base_bench: %u sub-events per event in %u process(es)\n",
+                            nsub, nwork);
+  std::printf("\n");
+
+  typedef simb::MCTruth (*MakeFn)(TRandom3&);
+  const char* names[] = { "muon",   "em",   "genie"       };
+  MakeFn      makers[] = { MakeMuon, MakeEM, MakeGenieLike };
+
+  std::printf("%-8s %7s %10s %12s %12s %10s %10s\n",
+              "sample", "events", "events/s", "steps/event", "steps/s", "RSS MB", "peak MB");
+  for (size_t s = 0; s < sizeof(names)/sizeof(names[0]); ++s) {
+    if (!filter.empty() && std::string(names[s]).find(filter) == std::string::npos) continue;
+
+    // make the events up front so only the simulation is timed
+    std::vector<simb::MCTruth> truths;
+    for (int i = 0; i < nevents; ++i) {
+      TRandom3 rand(seed + 1000003*s + i);
+      truths.push_back(makers[s](rand));
+    }
+
+    // one untimed event for lazily built physics tables
+    helper.G4Run(&truths[0]);
+    counter->fSteps = counter->fTracks = 0;
+    for (size_t i = 0; i < timers.size(); ++i) timers[i]->Reset();
+
+    Clock::time_point ts = Clock::now();
+    for (int i = 0; i < nevents; ++i) helper.G4Run(&truths[i]);
+    double secs = std::chrono::duration<double>(Clock::now() - ts).count();
+
+    Memory(rss, peak);
+    std::printf("%-8s %7d %10.2f %12.0f %12.0f %10.0f %10.0f\n",
+                names[s], nevents, nevents/secs, double(counter->fSteps)/nevents,
+                counter->fSteps/secs, rss, peak);
+    for (size_t i = 0; i < timers.size(); ++i)
+      std::printf("  %-32s %10.3f s %6.1f%% %10.1f ns/step %12ld calls\n",
+                  timers[i]->GetName().c_str(), timers[i]->fSecs,
+                  100.*timers[i]->fSecs/secs,
+                  counter->fSteps > 0 ? 1.e9*timers[i]->fSecs/counter->fSteps : 0.,
+                  timers[i]->fCalls);
+  }
+
+  return 0;
+}
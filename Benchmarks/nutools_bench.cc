@@ -0,0 +1,365 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  nutools_bench.cc
+/// \brief Offline microbenchmarks of nutools data products and kernels
+///
+/// Every benchmark runs on synthetic inputs made in this file, so the
+/// executable needs no flux files, geometry or data directory and can
+/// be run before a release to catch performance regressions:
+///
+///   nutools_bench [substring] [-t seconds]
+///
+/// runs the benchmarks whose name contains the substring (all if none
+/// is given), each for at least the given time (default 0.5 s), and
+/// prints ns/op and heap allocations/op.  Allocations are counted by
+/// replacing the global operator new in this executable, so only C++
+/// allocations are seen, not malloc calls made directly from C code.
+///
+/// bsim::calcEnuWgt is only benchmarked when the build found the dk2nu
+/// tree library (BENCH_WITH_DK2NU).
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+// ROOT includes
+#include "TFile.h"
+#include "TTree.h"
+#include "TH1D.h"
+#include "TH2F.h"
+#include "TSystem.h"
+#include "TROOT.h"
+#include "TLorentzVector.h"
+#include "Cintex/Cintex.h"
+
+// NuTools includes
+#include "SimulationBase/MCTrajectory.h"
+#include "SimulationBase/MCParticle.h"
+#include "SimulationBase/MCTruth.h"
+#include "SimulationBase/MCFlux.h"
+#include "NuBeamWeights/skzpReweight.h"
+#include "EventDisplayBase/ColorScale.h"
+
+#ifdef BENCH_WITH_DK2NU
+#include "dk2nu/tree/dk2nu.h"
+#include "dk2nu/tree/calcLocationWeights.h"
+#endif
+
+//......................................................................
+// allocation counting
+
+static unsigned long gNAlloc = 0;
+
+void* operator new(std::size_t n)
+{
+  ++gNAlloc;
+  void* p = std::malloc(n == 0 ? 1 : n);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void* operator new[](std::size_t n)
+{
+  ++gNAlloc;
+  void* p = std::malloc(n == 0 ? 1 : n);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void operator delete  (void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+
+namespace {
+
+  double gMinTime = 0.5;   ///< seconds per benchmark
+  double gSink    = 0.;    ///< keeps results alive
+
+  //......................................................................
+  /// Run body(i) for i = 0, 1, ... until at least gMinTime has passed,
+  /// doubling the batch each time, and report the cost per call.
+  template <class Body>
+  void Bench(const char* name, const std::string& filter, Body body)
+  {
+    if (!filter.empty() && std::string(name).find(filter) == std::string::npos) return;
+
+    typedef std::chrono::steady_clock clock;
+
+    body(0);  // warm up caches and lazy initialization
+
+    long          nops   = 0;
+    unsigned long allocs = 0;
+    double        secs   = 0.;
+    for (long batch = 1; secs < gMinTime; batch *= 2) {
+      unsigned long a0 = gNAlloc;
+      clock::time_point t0 = clock::now();
+      for (long i = 0; i < batch; ++i) body(nops + i);
+      clock::time_point t1 = clock::now();
+      allocs += gNAlloc - a0;
+      secs   += std::chrono::duration<double>(t1 - t0).count();
+      nops   += batch;
+    }
+
+    std::printf("%-48s %12.1f ns/op %10.2f allocs/op %10ld ops\n",
+                name, 1.e9*secs/nops, double(allocs)/nops, nops);
+  }
+
+  //......................................................................
+  /// a slowly curving helix, like a low energy charged track
+  simb::MCTrajectory MakeTrajectory(int npts)
+  {
+    simb::MCTrajectory traj;
+    for (int i = 0; i < npts; ++i) {
+      double s = 0.1*i;
+      TLorentzVector pos(10.*std::cos(0.05*s), 10.*std::sin(0.05*s), s, 0.03*s);
+      TLorentzVector mom(0.1*std::sin(0.05*s), 0.1*std::cos(0.05*s), 0.5, 0.52);
+      traj.Add(pos, mom);
+    }
+    return traj;
+  }
+
+  //......................................................................
+  simb::MCParticle MakeParticle(int trackID, int npts)
+  {
+    simb::MCParticle part(trackID, 13, "primary", 0, 0.105658);
+    simb::MCTrajectory traj = MakeTrajectory(npts);
+    for (size_t i = 0; i < traj.size(); ++i)
+      part.AddTrajectoryPoint(traj.Position(i), traj.Momentum(i));
+    return part;
+  }
+
+  //......................................................................
+  simb::MCFlux MakeFlux(int ptype)
+  {
+    simb::MCFlux flux;
+    flux.fptype   = ptype;
+    flux.fntype   = 14;
+    flux.fvx      = 1.2;
+    flux.fvy      = -0.8;
+    flux.fvz      = 25000.;
+    flux.fpdpx    = 0.05;
+    flux.fpdpy    = -0.02;
+    flux.fpdpz    = 8.;
+    flux.fppdxdz  = 0.001;
+    flux.fppdydz  = -0.002;
+    flux.fpppz    = 12.;
+    flux.fppenergy= 12.01;
+    flux.fmuparpx = 0.1;
+    flux.fmuparpy = 0.05;
+    flux.fmuparpz = 10.;
+    flux.fmupare  = 10.01;
+    flux.fnecm    = 0.03;
+    flux.fnimpwt  = 1.;
+    flux.ftptype  = 211;
+    flux.ftpx     = 0.2;
+    flux.ftpy     = 0.1;
+    flux.ftpz     = 30.;
+    return flux;
+  }
+
+  //......................................................................
+  /// Write fluka and beam systematic files in the format skzpReweight
+  /// expects (flag 2), filled with smooth synthetic distributions.
+  void MakeSKZPFiles(std::string const& fpath, std::string const& bpath)
+  {
+    TFile ffile(fpath.c_str(), "RECREATE");
+    const char* parts[] = { "PiPlus", "PiMinus", "KPlus", "KMinus", "K0L" };
+    for (int p = 0; p < 5; ++p) {
+      TH2F h(Form("hF05ptxf%s", parts[p]), "", 120, 0., 120., 100, 0., 1.);
+      for (int ix = 1; ix <= 120; ++ix)
+        for (int iy = 1; iy <= 100; ++iy) {
+          double pz = h.GetXaxis()->GetBinCenter(ix);
+          double pt = h.GetYaxis()->GetBinCenter(iy);
+          h.SetBinContent(ix, iy, 1.e4*pt*std::exp(-pz/20. - 3.*pt));
+        }
+      h.Write();
+    }
+    ffile.Close();
+
+    TFile bfile(bpath.c_str(), "RECREATE");
+    const char* nus[]  = { "NuMu", "NuMuBar", "NuE", "NuEBar" };
+    const char* effs[] = { "HornIMiscal", "HornIDist" };
+    for (int n = 0; n < 4; ++n)
+      for (int e = 0; e < 2; ++e) {
+        TH1D h(Form("%s_%s_L_NOvAnd", nus[n], effs[e]), "", 120, 0., 120.);
+        for (int i = 1; i <= 120; ++i) h.SetBinContent(i, 0.01*std::sin(0.1*i));
+        h.Write();
+      }
+    bfile.Close();
+  }
+
+}
+
+//......................................................................
+int main(int argc, char** argv)
+{
+  std::string filter;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "-t") == 0 && i+1 < argc) gMinTime = std::atof(argv[++i]);
+    else filter = argv[i];
+  }
+
+  gROOT->SetBatch(true);
+  ROOT::Cintex::Cintex::Enable();
+  gSystem->Load("libSimulationBase_dict");
+
+  //
+  // MCTrajectory
+  //
+  const int kNPts = 1000;
+
+  Bench("MCTrajectory::Add", filter, [&](long i) {
+      static simb::MCTrajectory traj;
+      if (i % kNPts == 0) traj.clear();
+      traj.Add(TLorentzVector(0.1*i, 0., 0., 0.), TLorentzVector(0., 0., 1., 1.));
+      gSink += traj.size();
+    });
+
+  {
+    const simb::MCTrajectory proto = MakeTrajectory(kNPts);
+    Bench("MCTrajectory::Sparsify (1000 pts, incl. copy)", filter, [&](long i) {
+        simb::MCTrajectory traj(proto);
+        traj.Sparsify();
+        gSink += traj.size() + i;
+      });
+
+    Bench("MCTrajectory::TotalLength (1000 pts)", filter, [&](long) {
+        gSink += proto.TotalLength();
+      });
+  }
+
+  //
+  // MCTruth
+  //
+  Bench("MCTruth construction (10 particles)", filter, [&](long i) {
+      simb::MCTruth truth;
+      truth.SetOrigin(simb::kBeamNeutrino);
+      for (int p = 0; p < 10; ++p) {
+        simb::MCParticle part(p, (p == 0) ? 14 : 2212, "primary", -1, 0.938, (p == 0) ? 0 : 1);
+        part.AddTrajectoryPoint(TLorentzVector(0., 0., 0., 0.), TLorentzVector(0.1*p, 0., 1., 1.5));
+        truth.Add(part);
+      }
+      truth.SetNeutrino(0, 0, 0, 1000180400, 2212, 0, 1., 0.3, 0.4, 0.1);
+      gSink += truth.NParticles() + i;
+    });
+
+  //
+  // MCParticle ROOT I/O
+  //
+  {
+    const int kNPart = 500;
+    const int kNTraj = 20;
+    std::vector<simb::MCParticle> particles;
+    for (int p = 0; p < kNPart; ++p) particles.push_back(MakeParticle(p, kNTraj));
+
+    std::string fname = std::string(gSystem->TempDirectory()) + "/nutools_bench_mcparticle.root";
+
+    {
+      TFile* f = new TFile(fname.c_str(), "RECREATE");
+      TTree* t = new TTree("bench", "bench");
+      std::vector<simb::MCParticle>* pp = &particles;
+      t->Branch("particles", &pp);
+      Bench("MCParticle write (500 x 20 pts)", filter, [&](long) {
+          t->Fill();
+        });
+      t->Write();
+      f->Close();
+      delete f;
+    }
+
+    {
+      TFile* f = new TFile(fname.c_str());
+      TTree* t = (TTree*)f->Get("bench");
+      std::vector<simb::MCParticle>* pp = 0;
+      if (t) {
+        t->SetBranchAddress("particles", &pp);
+        const long nent = t->GetEntries();
+        Bench("MCParticle read (500 x 20 pts)", filter, [&](long i) {
+            t->GetEntry(i % nent);
+            gSink += pp->size();
+          });
+      }
+      f->Close();
+      delete f;
+    }
+    gSystem->Unlink(fname.c_str());
+  }
+
+  //
+  // flux kernels
+  //
+#ifdef BENCH_WITH_DK2NU
+  {
+    bsim::Decay decay;
+    decay.ntype  = 14;
+    decay.ptype  = 211;
+    decay.vx     = 1.2;
+    decay.vy     = -0.8;
+    decay.vz     = 25000.;
+    decay.pdpx   = 0.05;
+    decay.pdpy   = -0.02;
+    decay.pdpz   = 8.;
+    decay.necm   = 0.03;
+    decay.nimpwt = 1.;
+    TVector3 xyz(0., 0., 100000.);
+    Bench("bsim::calcEnuWgt", filter, [&](long i) {
+        double enu = 0., wgt = 0.;
+        xyz.SetX(0.001*(i % 100));
+        bsim::calcEnuWgt(decay, xyz, enu, wgt);
+        gSink += enu + wgt;
+      });
+  }
+#endif
+
+  {
+    simb::MCFlux pion = MakeFlux(211);
+    simb::MCFlux muon = MakeFlux(-13);
+    Bench("MCFlux::ReDecay (pi)", filter, [&](long i) {
+        double e = 0., w = 0.;
+        pion.ReDecay(e, w, 0.001*(i % 100), 0., 100000.);
+        gSink += e + w;
+      });
+    Bench("MCFlux::ReDecay (mu)", filter, [&](long i) {
+        double e = 0., w = 0.;
+        muon.ReDecay(e, w, 0.001*(i % 100), 0., 100000.);
+        gSink += e + w;
+      });
+  }
+
+  {
+    std::string dir   = gSystem->TempDirectory();
+    std::string fpath = dir + "/nutools_bench_fluka.root";
+    std::string bpath = dir + "/nutools_bench_beamsys.root";
+    MakeSKZPFiles(fpath, bpath);
+
+    nbw::skzpReweight skzp(fpath, bpath, 2);
+    simb::MCFlux flux = MakeFlux(211);
+    Bench("skzpReweight::GetWeight", filter, [&](long i) {
+        flux.ftpz = 10. + (i % 100);
+        gSink += skzp.GetWeight(&flux, 0.5 + 0.1*(i % 50), 1, 1);
+      });
+
+    gSystem->Unlink(fpath.c_str());
+    gSystem->Unlink(bpath.c_str());
+  }
+
+  //
+  // event display
+  //
+  {
+    evdb::ColorScale lin(0., 100., evdb::kRainbow, evdb::kLinear, 40);
+    evdb::ColorScale log(1., 100., evdb::kBlueToRed, evdb::kLog, 256);
+    Bench("ColorScale::GetColor (linear)", filter, [&](long i) {
+        gSink += lin.GetColor(0.01*(i % 10000));
+      });
+    Bench("ColorScale::GetColor (log)", filter, [&](long i) {
+        gSink += log.GetColor(1. + 0.01*(i % 10000));
+      });
+  }
+
+  std::printf("(checksum %g)\n", gSink);
+  return 0;
+}
@@ -26,6 +26,7 @@
 
 // NuTools include files
 #include "EventGeneratorBase/evgenbase.h"
+#include "EventGeneratorBase/RNGStream.h"
 #include "EventGeneratorBase/CRY/CRYHelper.h"
 #include "SimulationBase/MCTruth.h"
 #include "SimulationBase/MCParticle.h"
@@ -93,6 +94,14 @@ namespace evgb{
     delete fSetup;
   }
 
+  //......................................................................
+  void CRYHelper::UseRNGStream(evgb::RNGStream& stream)
+  {
+    RNGWrapper<evgb::RNGStream>::set(&stream, &evgb::RNGStream::Flat);
+
+    fSetup->setRandomFunction(RNGWrapper<evgb::RNGStream>::rng);
+  }
+
   //......................................................................
   double CRYHelper::Sample(simb::MCTruth&      mctruth, 
 			   double      const& surfaceY,
@@ -22,6 +22,9 @@ class CRYGenerator;
 class CRYParticle;
 
 namespace evgb {
+
+  class RNGStream;
+
     /// Interface to the CRY cosmic-ray generator
   class CRYHelper {
   public:
@@ -36,6 +39,11 @@ namespace evgb {
 		double       const& detectorLength,
 		double*             w,
 		double              rantime=0);
+
+    /// draw CRY's random numbers from a counter based stream instead of
+    /// the engine given to the constructor; the caller positions the
+    /// stream with RNGStream::SetEvent before each Sample()
+    void UseRNGStream(evgb::RNGStream& stream);
     
   private:
 
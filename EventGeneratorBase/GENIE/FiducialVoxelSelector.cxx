@@ -0,0 +1,284 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  FiducialVoxelSelector.cxx
+/// \brief GeomVolSelectorFiducial with a precomputed voxel classification
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#include <cmath>
+#include <algorithm>
+
+// ROOT includes
+#include "TMath.h"
+
+// GENIE includes
+#include "Geo/ROOTGeomAnalyzer.h"
+#include "Geo/PathSegmentList.h"
+
+// Framework includes
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+// NuTools includes
+#include "EventGeneratorBase/GENIE/FiducialVoxelSelector.h"
+
+namespace evgb {
+
+  // segments whose bounding box covers more voxels than this are
+  // passed to the exact test rather than scanned
+  static const int kMaxVoxelScan = 512;
+
+  //--------------------------------------------------
+  FiducialVoxelSelector::FiducialVoxelSelector()
+    : genie::geometry::GeomVolSelectorFiducial()
+    , fMaster      (false)
+    , fReverseCut  (false)
+    , fRGeom       (0)
+    , fN           (0)
+    , fNFastInside (0)
+    , fNFastOutside(0)
+    , fNExact      (0)
+  {
+  }
+
+  //--------------------------------------------------
+  FiducialVoxelSelector::~FiducialVoxelSelector()
+  {
+    if(fN > 0)
+      mf::LogInfo("FiducialVoxelSelector") << "segments kept by voxel: "     << fNFastInside
+					   << ", dropped by voxel: "         << fNFastOutside
+					   << ", passed to exact test: "     << fNExact;
+  }
+
+  //--------------------------------------------------
+  void FiducialVoxelSelector::BuildVoxels(std::string                         const& shape,
+					  std::vector<double>                 const& vals,
+					  bool                                       master,
+					  bool                                       reverse,
+					  genie::geometry::ROOTGeomAnalyzer   const* rgeom,
+					  TVector3                            const& lo,
+					  TVector3                            const& hi,
+					  int                                        nvoxels)
+  {
+    fShape      = shape;
+    fVals       = vals;
+    fMaster     = master;
+    fReverseCut = reverse;
+    fRGeom      = rgeom;
+    fLo         = lo;
+    fHi         = hi;
+    fN          = nvoxels;
+    fClass.clear();
+
+    if(fN <= 0) return;
+
+    if(fShape != "zcyl" && fShape != "box" && fShape != "zpoly" && fShape != "sphere"){
+      mf::LogWarning("FiducialVoxelSelector") << "no voxel acceleration for shape "
+					      << fShape << ", using exact test only";
+      fN = 0;
+      return;
+    }
+
+    fStep.SetXYZ((fHi.X() - fLo.X())/fN,
+		 (fHi.Y() - fLo.Y())/fN,
+		 (fHi.Z() - fLo.Z())/fN);
+
+    // bounding box of the shape in the coordinates it was given in
+    double smin[3] = {0., 0., 0.};
+    double smax[3] = {0., 0., 0.};
+    if(fShape == "zcyl"){
+      smin[0] = fVals[0] - fVals[2]; smax[0] = fVals[0] + fVals[2];
+      smin[1] = fVals[1] - fVals[2]; smax[1] = fVals[1] + fVals[2];
+      smin[2] = fVals[3];            smax[2] = fVals[4];
+    }
+    else if(fShape == "box"){
+      for(int i = 0; i < 3; ++i){
+	smin[i] = std::min(fVals[i], fVals[i+3]);
+	smax[i] = std::max(fVals[i], fVals[i+3]);
+      }
+    }
+    else if(fShape == "zpoly"){
+      // circumscribed radius of the polygon
+      double rout = fVals[3]/std::cos(TMath::Pi()/fVals[0]);
+      smin[0] = fVals[1] - rout; smax[0] = fVals[1] + rout;
+      smin[1] = fVals[2] - rout; smax[1] = fVals[2] + rout;
+      smin[2] = fVals[5];        smax[2] = fVals[6];
+    }
+    else if(fShape == "sphere"){
+      for(int i = 0; i < 3; ++i){
+	smin[i] = fVals[i] - fVals[3];
+	smax[i] = fVals[i] + fVals[3];
+      }
+    }
+
+    // move it to the top volume system, the transformation is rigid so
+    // the box around the transformed corners still bounds the shape
+    TVector3 tmin( 1.e30,  1.e30,  1.e30);
+    TVector3 tmax(-1.e30, -1.e30, -1.e30);
+    for(int c = 0; c < 8; ++c){
+      TVector3 corner((c & 1) ? smax[0] : smin[0],
+		      (c & 2) ? smax[1] : smin[1],
+		      (c & 4) ? smax[2] : smin[2]);
+      if(fMaster) fRGeom->Master2Top(corner);
+      for(int i = 0; i < 3; ++i){
+	tmin[i] = std::min(tmin[i], corner[i]);
+	tmax[i] = std::max(tmax[i], corner[i]);
+      }
+    }
+
+    fClass.resize(fN*fN*fN, kBoundary);
+    long ncount[3] = {0, 0, 0};
+
+    for(int iz = 0; iz < fN; ++iz){
+      for(int iy = 0; iy < fN; ++iy){
+	for(int ix = 0; ix < fN; ++ix){
+	  TVector3 vlo(fLo.X() + ix*fStep.X(), fLo.Y() + iy*fStep.Y(), fLo.Z() + iz*fStep.Z());
+	  TVector3 vhi = vlo + fStep;
+
+	  VoxelClass_t vc = kBoundary;
+
+	  // no overlap with the bounding box means no overlap with the shape
+	  bool overlap = true;
+	  for(int i = 0; i < 3; ++i)
+	    if(vhi[i] < tmin[i] || vlo[i] > tmax[i]) overlap = false;
+
+	  if(!overlap) vc = kOutside;
+	  else{
+	    // a convex shape containing all 8 corners contains the voxel
+	    bool allIn = true;
+	    for(int c = 0; c < 8 && allIn; ++c){
+	      TVector3 corner((c & 1) ? vhi.X() : vlo.X(),
+			      (c & 2) ? vhi.Y() : vlo.Y(),
+			      (c & 4) ? vhi.Z() : vlo.Z());
+	      allIn = this->ShapeContains(corner);
+	    }
+	    if(allIn) vc = kInside;
+	  }
+
+	  fClass[this->Index(ix, iy, iz)] = vc;
+	  ++ncount[vc];
+	}
+      }
+    }
+
+    mf::LogInfo("FiducialVoxelSelector") << fN << "^3 voxels for " << fShape
+					 << " fiducial cut: " << ncount[kInside]   << " inside, "
+					 << ncount[kOutside]  << " outside, "
+					 << ncount[kBoundary] << " boundary";
+
+    return;
+  }
+
+  //--------------------------------------------------
+  // exact containment test, used only while classifying voxels.  The
+  // shape is shrunk by a small tolerance so that voxels touching the
+  // surface are always treated as boundary voxels.
+  bool FiducialVoxelSelector::ShapeContains(TVector3 const& top) const
+  {
+    const double tol = 1.e-6*fStep.Mag();
+
+    TVector3 p(top);
+    if(fMaster) fRGeom->Top2Master(p);
+
+    if(fShape == "zcyl"){
+      double dx = p.X() - fVals[0];
+      double dy = p.Y() - fVals[1];
+      double r  = fVals[2] - tol;
+      return (dx*dx + dy*dy < r*r &&
+	      p.Z() > fVals[3] + tol && p.Z() < fVals[4] - tol);
+    }
+    else if(fShape == "box"){
+      for(int i = 0; i < 3; ++i){
+	double lo = std::min(fVals[i], fVals[i+3]);
+	double hi = std::max(fVals[i], fVals[i+3]);
+	if(p[i] <= lo + tol || p[i] >= hi - tol) return false;
+      }
+      return true;
+    }
+    else if(fShape == "zpoly"){
+      if(p.Z() <= fVals[5] + tol || p.Z() >= fVals[6] - tol) return false;
+      int    nfaces = (int)fVals[0];
+      double dphi   = 2.*TMath::Pi()/nfaces;
+      double phi0   = fVals[4]*TMath::DegToRad();
+      for(int f = 0; f < nfaces; ++f){
+	double phi = phi0 + f*dphi;
+	double d   = (p.X() - fVals[1])*std::cos(phi) + (p.Y() - fVals[2])*std::sin(phi);
+	if(d >= fVals[3] - tol) return false;
+      }
+      return true;
+    }
+    else if(fShape == "sphere"){
+      TVector3 c(fVals[0], fVals[1], fVals[2]);
+      double   r = fVals[3] - tol;
+      return ((p - c).Mag2() < r*r);
+    }
+
+    return false;
+  }
+
+  //--------------------------------------------------
+  bool FiducialVoxelSelector::VoxelIndex(TVector3 const& pos, int& ix, int& iy, int& iz) const
+  {
+    if(pos.X() < fLo.X() || pos.X() >= fHi.X() ||
+       pos.Y() < fLo.Y() || pos.Y() >= fHi.Y() ||
+       pos.Z() < fLo.Z() || pos.Z() >= fHi.Z()) return false;
+
+    ix = std::min(fN - 1, (int)((pos.X() - fLo.X())/fStep.X()));
+    iy = std::min(fN - 1, (int)((pos.Y() - fLo.Y())/fStep.Y()));
+    iz = std::min(fN - 1, (int)((pos.Z() - fLo.Z())/fStep.Z()));
+
+    return true;
+  }
+
+  //--------------------------------------------------
+  void FiducialVoxelSelector::TrimSegment(genie::geometry::PathSegment& segment) const
+  {
+    int a[3] = {0, 0, 0};
+    int b[3] = {0, 0, 0};
+    if(fN <= 0 ||
+       !this->VoxelIndex(segment.fEnter, a[0], a[1], a[2]) ||
+       !this->VoxelIndex(segment.fExit,  b[0], b[1], b[2])){
+      ++fNExact;
+      genie::geometry::GeomVolSelectorFiducial::TrimSegment(segment);
+      return;
+    }
+
+    // both ends in inside voxels: the shape is convex so the whole
+    // segment is inside
+    if(fClass[this->Index(a[0], a[1], a[2])] == kInside &&
+       fClass[this->Index(b[0], b[1], b[2])] == kInside){
+      ++fNFastInside;
+      genie::geometry::GeomVolSelectorBasic::TrimSegment(segment);
+      if(fReverseCut) segment.fStepRangeSet.clear();
+      return;
+    }
+
+    // every voxel touched by the bounding box of the segment is outside
+    int lo[3], hi[3];
+    long nscan = 1;
+    for(int i = 0; i < 3; ++i){
+      lo[i] = std::min(a[i], b[i]);
+      hi[i] = std::max(a[i], b[i]);
+      nscan *= (hi[i] - lo[i] + 1);
+    }
+
+    if(nscan <= kMaxVoxelScan){
+      bool allOut = true;
+      for(int iz = lo[2]; iz <= hi[2] && allOut; ++iz)
+	for(int iy = lo[1]; iy <= hi[1] && allOut; ++iy)
+	  for(int ix = lo[0]; ix <= hi[0] && allOut; ++ix)
+	    allOut = (fClass[this->Index(ix, iy, iz)] == kOutside);
+
+      if(allOut){
+	++fNFastOutside;
+	genie::geometry::GeomVolSelectorBasic::TrimSegment(segment);
+	if(!fReverseCut) segment.fStepRangeSet.clear();
+	return;
+      }
+    }
+
+    ++fNExact;
+    genie::geometry::GeomVolSelectorFiducial::TrimSegment(segment);
+
+    return;
+  }
+
+}// namespace
@@ -0,0 +1,91 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  FiducialVoxelSelector.h
+/// \brief GeomVolSelectorFiducial with a precomputed voxel classification
+///
+/// The fiducial shapes GENIEHelper supports (zcyl, box, zpoly, sphere)
+/// are all convex.  At initialization the bounding box of the top
+/// volume is divided into voxels and each voxel is classified as
+/// fully inside the shape, fully outside of it, or on the boundary.
+/// A path segment whose end points both fall in inside voxels lies
+/// entirely within the shape; a segment whose bounding box only
+/// touches outside voxels misses it entirely.  Those segments are kept
+/// or dropped directly, only the remaining ones are handed to the
+/// exact GeomVolSelectorFiducial::TrimSegment, so the selection is
+/// unchanged.
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#ifndef EVGB_FIDUCIALVOXELSELECTOR_H
+#define EVGB_FIDUCIALVOXELSELECTOR_H
+
+#include <string>
+#include <vector>
+
+#include "TVector3.h"
+
+#include "Geo/GeomVolSelectorFiducial.h"
+
+namespace genie {
+  namespace geometry {
+    class ROOTGeomAnalyzer;
+    class PathSegment;
+  }
+}
+
+namespace evgb {
+
+  class FiducialVoxelSelector : public genie::geometry::GeomVolSelectorFiducial {
+  public:
+    FiducialVoxelSelector();
+    virtual ~FiducialVoxelSelector();
+
+    /// classify the voxels, call after the shape has been made and the
+    /// master/reverse options applied to the base class
+    ///   shape  - one of "zcyl" "box" "zpoly" "sphere"
+    ///   vals   - the values passed to the matching Make* method
+    ///   master - true if vals are in the master coordinate system
+    ///   lo, hi - corners of the voxelized region in top volume coordinates
+    void BuildVoxels(std::string                         const& shape,
+		     std::vector<double>                 const& vals,
+		     bool                                       master,
+		     bool                                       reverse,
+		     genie::geometry::ROOTGeomAnalyzer   const* rgeom,
+		     TVector3                            const& lo,
+		     TVector3                            const& hi,
+		     int                                        nvoxels);
+
+    virtual void TrimSegment(genie::geometry::PathSegment& segment) const;
+
+    long NFastInside()  const { return fNFastInside;  }
+    long NFastOutside() const { return fNFastOutside; }
+    long NExact()       const { return fNExact;       }
+
+  private:
+
+    typedef enum _voxel_class {
+      kOutside  = 0,
+      kInside   = 1,
+      kBoundary = 2
+    } VoxelClass_t;
+
+    bool   ShapeContains(TVector3 const& top) const;
+    bool   VoxelIndex(TVector3 const& pos, int& ix, int& iy, int& iz) const;
+    int    Index(int ix, int iy, int iz) const { return (iz*fN + iy)*fN + ix; }
+
+    std::string                               fShape;        ///< shape name
+    std::vector<double>                       fVals;         ///< shape parameters
+    bool                                      fMaster;       ///< shape given in master coordinates
+    bool                                      fReverseCut;   ///< keep the outside instead of the inside
+    genie::geometry::ROOTGeomAnalyzer const*  fRGeom;        ///< for top -> master conversion
+    TVector3                                  fLo;           ///< low corner of voxel grid (top coords)
+    TVector3                                  fHi;           ///< high corner of voxel grid (top coords)
+    TVector3                                  fStep;         ///< voxel size in each dimension
+    int                                       fN;            ///< voxels per dimension, 0 = disabled
+    std::vector<unsigned char>                fClass;        ///< voxel classification
+    mutable long                              fNFastInside;  ///< segments kept without the exact test
+    mutable long                              fNFastOutside; ///< segments dropped without the exact test
+    mutable long                              fNExact;       ///< segments given to the exact test
+  };
+
+}
+#endif //EVGB_FIDUCIALVOXELSELECTOR_H
@@ -0,0 +1,370 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  FluxMaterializer.cxx
+/// \brief Fill simb::MCFlux from flux ntuple records, on demand
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+// ROOT includes
+#include "TChain.h"
+#include "TChainElement.h"
+#include "TMath.h"
+
+// GENIE includes
+#include "FluxDrivers/GNuMIFlux.h"
+#include "FluxDrivers/GSimpleNtpFlux.h"
+#include "FluxDrivers/GNuMINtuple/g3numi.h"
+#include "FluxDrivers/GNuMINtuple/g4numi.h"
+#include "FluxDrivers/GNuMINtuple/flugg.h"
+
+// Framework includes
+#include "messagefacility/MessageLogger/MessageLogger.h"
+#include "cetlib/exception.h"
+
+// NuTools includes
+#include "EventGeneratorBase/GENIE/FluxMaterializer.h"
+#include "SimulationBase/MCFlux.h"
+
+namespace evgb {
+
+  //--------------------------------------------------
+  void FillNuMIFlux(genie::flux::GNuMIFluxPassThroughInfo const& nflux,
+                    simb::MCFlux&                                 flux)
+  {
+    // maintained variable names from gnumi ntuples
+    // see http://www.hep.utexas.edu/~zarko/wwwgnumi/v19/[/v19/output_gnumi.html]
+
+    flux.frun      = nflux.run;
+    flux.fevtno    = nflux.evtno;
+    flux.fndxdz    = nflux.ndxdz;
+    flux.fndydz    = nflux.ndydz;
+    flux.fnpz      = nflux.npz;
+    flux.fnenergy  = nflux.nenergy;
+    flux.fndxdznea = nflux.ndxdznea;
+    flux.fndydznea = nflux.ndydznea;
+    flux.fnenergyn = nflux.nenergyn;
+    flux.fnwtnear  = nflux.nwtnear;
+    flux.fndxdzfar = nflux.ndxdzfar;
+    flux.fndydzfar = nflux.ndydzfar;
+    flux.fnenergyf = nflux.nenergyf;
+    flux.fnwtfar   = nflux.nwtfar;
+    flux.fnorig    = nflux.norig;
+    flux.fndecay   = nflux.ndecay;
+    flux.fntype    = nflux.ntype;
+    flux.fvx       = nflux.vx;
+    flux.fvy       = nflux.vy;
+    flux.fvz       = nflux.vz;
+    flux.fpdpx     = nflux.pdpx;
+    flux.fpdpy     = nflux.pdpy;
+    flux.fpdpz     = nflux.pdpz;
+    flux.fppdxdz   = nflux.ppdxdz;
+    flux.fppdydz   = nflux.ppdydz;
+    flux.fpppz     = nflux.pppz;
+    flux.fppenergy = nflux.ppenergy;
+    flux.fppmedium = nflux.ppmedium;
+    flux.fptype    = nflux.ptype;     // converted to PDG
+    flux.fppvx     = nflux.ppvx;
+    flux.fppvy     = nflux.ppvy;
+    flux.fppvz     = nflux.ppvz;
+    flux.fmuparpx  = nflux.muparpx;
+    flux.fmuparpy  = nflux.muparpy;
+    flux.fmuparpz  = nflux.muparpz;
+    flux.fmupare   = nflux.mupare;
+    flux.fnecm     = nflux.necm;
+    flux.fnimpwt   = nflux.nimpwt;
+    flux.fxpoint   = nflux.xpoint;
+    flux.fypoint   = nflux.ypoint;
+    flux.fzpoint   = nflux.zpoint;
+    flux.ftvx      = nflux.tvx;
+    flux.ftvy      = nflux.tvy;
+    flux.ftvz      = nflux.tvz;
+    flux.ftpx      = nflux.tpx;
+    flux.ftpy      = nflux.tpy;
+    flux.ftpz      = nflux.tpz;
+    flux.ftptype   = nflux.tptype;   // converted to PDG
+    flux.ftgen     = nflux.tgen;
+    flux.ftgptype  = nflux.tgptype;  // converted to PDG
+    flux.ftgppx    = nflux.tgppx;
+    flux.ftgppy    = nflux.tgppy;
+    flux.ftgppz    = nflux.tgppz;
+    flux.ftprivx   = nflux.tprivx;
+    flux.ftprivy   = nflux.tprivy;
+    flux.ftprivz   = nflux.tprivz;
+    flux.fbeamx    = nflux.beamx;
+    flux.fbeamy    = nflux.beamy;
+    flux.fbeamz    = nflux.beamz;
+    flux.fbeampx   = nflux.beampx;
+    flux.fbeampy   = nflux.beampy;
+    flux.fbeampz   = nflux.beampz;    
+
+    return;
+  }
+
+  //--------------------------------------------------
+  void FillSimpleFlux(genie::flux::GSimpleNtpEntry const* nflux_entry,
+                      genie::flux::GSimpleNtpNuMI  const* nflux_numi,
+                      genie::flux::GSimpleNtpAux   const* nflux_aux,
+                      genie::flux::GSimpleNtpMeta  const* nflux_meta,
+                      simb::MCFlux&                       flux)
+  {
+    flux.fntype  = nflux_entry->pdg;
+    flux.fnimpwt = nflux_entry->wgt;
+    flux.fdk2gen = nflux_entry->dist;
+    flux.fnenergyn = flux.fnenergyf = nflux_entry->E;
+
+    if ( nflux_numi ) {
+      flux.frun      = nflux_numi->run;
+      flux.fevtno    = nflux_numi->evtno;
+      flux.ftpx      = nflux_numi->tpx;
+      flux.ftpy      = nflux_numi->tpy;
+      flux.ftpz      = nflux_numi->tpz;
+      flux.ftptype   = nflux_numi->tptype;   // converted to PDG
+      flux.fvx       = nflux_numi->vx;
+      flux.fvy       = nflux_numi->vy;
+      flux.fvz       = nflux_numi->vz;
+
+      flux.fndecay   = nflux_numi->ndecay;
+      flux.fppmedium = nflux_numi->ppmedium;
+
+      flux.fpdpx     = nflux_numi->pdpx;
+      flux.fpdpy     = nflux_numi->pdpy;
+      flux.fpdpz     = nflux_numi->pdpz;
+
+      double apppz = nflux_numi->pppz;
+      if ( TMath::Abs(nflux_numi->pppz) < 1.0e-30 ) apppz = 1.0e-30;
+      flux.fppdxdz   = nflux_numi->pppx / apppz;
+      flux.fppdydz   = nflux_numi->pppy / apppz;
+      flux.fpppz     = nflux_numi->pppz;
+
+      flux.fptype    = nflux_numi->ptype;
+
+    }
+    
+    // anything useful stuffed into vdbl or vint?
+    // need to check the metadata  auxintname, auxdblname
+
+    if ( nflux_aux && nflux_meta ) {
+
+      // references just for reducing complexity
+      const std::vector<std::string>& auxdblname = nflux_meta->auxdblname;
+      const std::vector<std::string>& auxintname = nflux_meta->auxintname;
+      const std::vector<int>&    auxint = nflux_aux->auxint;
+      const std::vector<double>& auxdbl = nflux_aux->auxdbl;
+
+      for (size_t id=0; id<auxdblname.size(); ++id) {
+        if ("muparpx"   == auxdblname[id]) flux.fmuparpx  = auxdbl[id];
+        if ("muparpy"   == auxdblname[id]) flux.fmuparpy  = auxdbl[id];
+        if ("muparpz"   == auxdblname[id]) flux.fmuparpz  = auxdbl[id];
+        if ("mupare"    == auxdblname[id]) flux.fmupare   = auxdbl[id];
+        if ("necm"      == auxdblname[id]) flux.fnecm     = auxdbl[id];
+        if ("nimpwt"    == auxdblname[id]) flux.fnimpwt   = auxdbl[id];
+        if ("fgXYWgt"   == auxdblname[id]) {
+          flux.fnwtnear = flux.fnwtfar = auxdbl[id]; 
+        }
+      }
+      for (size_t ii=0; ii<auxintname.size(); ++ii) {
+        if ("tgen"      == auxintname[ii]) flux.ftgen     = auxint[ii];
+        if ("tgptype"   == auxintname[ii]) flux.ftgptype  = auxint[ii];
+      }
+
+    }
+
+    return;
+  }
+
+  //--------------------------------------------------
+  // same tree names, in the same order, as GNuMIFlux::LoadBeamSimData;
+  // a chain is used so that the first file may be a wildcard pattern
+  static std::string NuMITreeName(std::string const& file)
+  {
+    const char* treenames[] = { "h10", "nudata", "h3" };
+    for ( int i = 0; i < 3; ++i ) {
+      TChain chain(treenames[i]);
+      chain.Add(file.c_str());
+      if ( chain.GetEntries() > 0 ) return treenames[i];
+    }
+
+    throw cet::exception("FluxMaterializer") << "no gnumi/flugg tree in " << file;
+  }
+
+  //--------------------------------------------------
+  simb::MCFluxFiles MakeFluxFileList(std::string              const& fluxType,
+                                     std::vector<std::string> const& files)
+  {
+    if ( files.empty() )
+      throw cet::exception("FluxMaterializer") << "no flux files given";
+
+    std::string treename;
+    if      ( fluxType.compare("ntuple")      == 0 ) treename = NuMITreeName(files[0]);
+    else if ( fluxType.compare("simple_flux") == 0 ) treename = "flux";
+    else
+      // dk2nu included: there is no dk2nu driver or MCFlux filler here
+      // to rebuild a record from its reference
+      throw cet::exception("FluxMaterializer") << "flux references are not supported for "
+                                               << fluxType << " fluxes, only for ntuple"
+                                               << " and simple_flux";
+
+    // chain the files the way the flux drivers do, which also expands
+    // any wildcards, and read back the entries of each file
+    TChain chain(treename.c_str());
+    for ( size_t i = 0; i < files.size(); ++i ) chain.Add(files[i].c_str());
+    chain.GetEntries();
+
+    simb::MCFluxFiles list(fluxType);
+    const Long64_t* offset = chain.GetTreeOffset();
+    TObjArray*      elements = chain.GetListOfFiles();
+    for ( int i = 0; i < chain.GetNtrees(); ++i ) {
+      TChainElement* element = dynamic_cast<TChainElement*>(elements->At(i));
+      list.Add(element->GetTitle(), offset[i+1] - offset[i]);
+    }
+
+    return list;
+  }
+
+  //--------------------------------------------------
+  FluxMaterializer::FluxMaterializer(simb::MCFluxFiles        const& fileList,
+                                     std::vector<std::string> const& files)
+    : fFileList (fileList)
+    , fFiles    (files)
+    , fChain    (0)
+    , fMetaChain(0)
+    , fG3NuMI   (0)
+    , fG4NuMI   (0)
+    , fFlugg    (0)
+    , fEntry    (0)
+    , fNuMI     (0)
+    , fAux      (0)
+    , fMeta     (0)
+  {
+    // the references are only meaningful for the files they were made
+    // from, so check the files are the same, in the same order, before
+    // reading anything
+    simb::MCFluxFiles found = MakeFluxFileList(fFileList.FluxType(), fFiles);
+    if ( ! found.SameFiles(fFileList) )
+      throw cet::exception("FluxMaterializer") << "flux files do not match the files the "
+                                               << "MCFlux references were made from\n"
+                                               << "expected: " << fFileList
+                                               << "found: "    << found;
+
+    // read the expanded list so a wildcard can not pick up files in
+    // another order than the one checked above
+    fFiles.clear();
+    for ( unsigned int i = 0; i < found.NFiles(); ++i ) fFiles.push_back(found.File(i));
+
+    if ( fFileList.FluxType().compare("ntuple") == 0 ) OpenNuMI();
+    else                                               OpenSimple();
+  }
+
+  //--------------------------------------------------
+  FluxMaterializer::~FluxMaterializer()
+  {
+    delete fG3NuMI;
+    delete fG4NuMI;
+    delete fFlugg;
+    delete fChain;
+    delete fMetaChain;
+  }
+
+  //--------------------------------------------------
+  void FluxMaterializer::OpenNuMI()
+  {
+    std::string treename = NuMITreeName(fFiles[0]);
+
+    fChain = new TChain(treename.c_str());
+    for ( size_t i = 0; i < fFiles.size(); ++i ) fChain->Add(fFiles[i].c_str());
+
+    if      ( treename == "h10"    ) fG3NuMI = new g3numi(fChain);
+    else if ( treename == "nudata" ) fG4NuMI = new g4numi(fChain);
+    else                             fFlugg  = new flugg(fChain);
+
+    mf::LogInfo("FluxMaterializer") << "reading " << treename << " from "
+                                    << fFiles.size() << " files, "
+                                    << fChain->GetEntries() << " entries";
+  }
+
+  //--------------------------------------------------
+  // same branches as GSimpleNtpFlux::LoadBeamSimData
+  void FluxMaterializer::OpenSimple()
+  {
+    fChain     = new TChain("flux");
+    fMetaChain = new TChain("meta");
+    for ( size_t i = 0; i < fFiles.size(); ++i ) {
+      fChain    ->Add(fFiles[i].c_str());
+      fMetaChain->Add(fFiles[i].c_str());
+    }
+
+    fEntry = new genie::flux::GSimpleNtpEntry;
+    fChain->SetBranchAddress("entry", &fEntry);
+    if ( fChain->GetBranch("numi") ) {
+      fNuMI = new genie::flux::GSimpleNtpNuMI;
+      fChain->SetBranchAddress("numi", &fNuMI);
+    }
+    if ( fChain->GetBranch("aux") ) {
+      fAux = new genie::flux::GSimpleNtpAux;
+      fChain->SetBranchAddress("aux", &fAux);
+    }
+
+    fMeta = new genie::flux::GSimpleNtpMeta;
+    fMetaChain->SetBranchAddress("meta", &fMeta);
+    fMetaChain->BuildIndex("metakey");
+
+    mf::LogInfo("FluxMaterializer") << "reading gsimple flux from "
+                                    << fFiles.size() << " files, "
+                                    << fChain->GetEntries() << " entries";
+  }
+
+  //--------------------------------------------------
+  bool FluxMaterializer::Materialize(simb::MCFlux& flux)
+  {
+    if ( ! flux.fIsFluxRef ) return true;
+
+    // the chain holds the files of fFileList in order
+    long long entry = fFileList.ChainEntry(flux.fFluxFile, flux.fFluxEntry);
+    if ( entry < 0 ) {
+      mf::LogWarning("FluxMaterializer") << "flux file " << flux.fFluxFile
+                                         << " entry " << flux.fFluxEntry
+                                         << " is not in the flux files";
+      return false;
+    }
+
+    // these come from the flux driver and GMCJDriver at generation
+    // time, not from the ntuple, so keep the stored values
+    double genx    = flux.fgenx;
+    double geny    = flux.fgeny;
+    double genz    = flux.fgenz;
+    double dk2gen  = flux.fdk2gen;
+    double gen2vtx = flux.fgen2vtx;
+    int       file  = flux.fFluxFile;
+    long long local = flux.fFluxEntry;
+
+    flux.Reset();
+
+    if ( fMetaChain ) {
+      if ( fChain->GetEntry(entry) <= 0 ) return false;
+      if ( fMetaChain->GetEntryWithIndex(fEntry->metakey) <= 0 ) {
+        mf::LogWarning("FluxMaterializer") << "no metadata for key " << fEntry->metakey;
+      }
+      FillSimpleFlux(fEntry, fNuMI, fAux, fMeta, flux);
+    }
+    else {
+      genie::flux::GNuMIFluxPassThroughInfo nflux;
+      if      ( fG3NuMI ) { if ( fG3NuMI->GetEntry(entry) <= 0 ) return false; nflux.MakeCopy(fG3NuMI); }
+      else if ( fG4NuMI ) { if ( fG4NuMI->GetEntry(entry) <= 0 ) return false; nflux.MakeCopy(fG4NuMI); }
+      else                { if ( fFlugg ->GetEntry(entry) <= 0 ) return false; nflux.MakeCopy(fFlugg);  }
+      nflux.ConvertPartCodes();
+      FillNuMIFlux(nflux, flux);
+    }
+
+    flux.fgenx      = genx;
+    flux.fgeny      = geny;
+    flux.fgenz      = genz;
+    flux.fdk2gen    = dk2gen;
+    flux.fgen2vtx   = gen2vtx;
+    flux.fFluxFile  = file;
+    flux.fFluxEntry = local;
+    flux.fIsFluxRef = false;
+
+    return true;
+  }
+
+}// namespace
@@ -0,0 +1,105 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  FluxMaterializer.h
+/// \brief Fill simb::MCFlux from flux ntuple records, on demand
+///
+/// When GENIEHelper runs with FluxRefMode set, the simb::MCFlux it
+/// produces only carries the flux file (MCFlux::fFluxFile) and the
+/// entry of that file (MCFlux::fFluxEntry) the neutrino came from, and
+/// a handful of commonly used fields (flavor, parent type, decay mode,
+/// energy and weights).  The files are listed, in order, in the
+/// simb::MCFluxFiles from GENIEHelper::FluxFileList() that the
+/// generating module stores in the SubRun.  The FluxMaterializer is
+/// given that list and the paths of the files to read; it refuses to
+/// run unless they hold the same files, and then fills in the full
+/// record when downstream code asks for it.
+///
+/// The Fill* functions are also what GENIEHelper uses to pack the full
+/// record at generation time, so both paths produce identical objects.
+///
+/// Only the "ntuple" (gnumi, g4numi, flugg) and "simple_flux" fluxes
+/// can be referenced.  dk2nu files are not supported: GENIEHelper has
+/// no dk2nu flux driver and no code that fills an MCFlux from a
+/// bsim::Dk2Nu entry, so there is no full record here to rebuild from
+/// a reference.  MakeFluxFileList, and with it FluxRefMode, throws for
+/// them.
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#ifndef EVGB_FLUXMATERIALIZER_H
+#define EVGB_FLUXMATERIALIZER_H
+
+#include <string>
+#include <vector>
+
+class TChain;
+
+#include "SimulationBase/MCFluxFiles.h"
+
+namespace simb { class MCFlux; }
+
+namespace genie {
+  namespace flux {
+    class GNuMIFluxPassThroughInfo;
+    class GSimpleNtpEntry;
+    class GSimpleNtpNuMI;
+    class GSimpleNtpAux;
+    class GSimpleNtpMeta;
+  }
+}
+
+class g3numi;
+class g4numi;
+class flugg;
+
+namespace evgb {
+
+  /// copy the gnumi-style pass through information into the MCFlux
+  void FillNuMIFlux(genie::flux::GNuMIFluxPassThroughInfo const& nflux,
+		    simb::MCFlux&                                 flux);
+
+  /// copy the gsimple entry (and optional numi/aux blocks) into the MCFlux
+  void FillSimpleFlux(genie::flux::GSimpleNtpEntry const* nflux_entry,
+		      genie::flux::GSimpleNtpNuMI  const* nflux_numi,
+		      genie::flux::GSimpleNtpAux   const* nflux_aux,
+		      genie::flux::GSimpleNtpMeta  const* nflux_meta,
+		      simb::MCFlux&                       flux);
+
+  /// list the files, and their entries, that a flux driver of the given
+  /// GENIEHelper FluxType ("ntuple" or "simple_flux") chains when given
+  /// these files or patterns; throws for any other type, dk2nu included
+  simb::MCFluxFiles MakeFluxFileList(std::string              const& fluxType,
+				     std::vector<std::string> const& files);
+
+  class FluxMaterializer {
+  public:
+    /// fileList is the list stored with the events, files are the paths
+    /// to read them from now; throws unless files holds the same files,
+    /// in the same order
+    FluxMaterializer(simb::MCFluxFiles        const& fileList,
+		     std::vector<std::string> const& files);
+    ~FluxMaterializer();
+
+    /// fill the full record of a reference MCFlux, leaves complete
+    /// records untouched; returns false if the entry can't be read
+    bool Materialize(simb::MCFlux& flux);
+
+  private:
+
+    void OpenNuMI();
+    void OpenSimple();
+
+    simb::MCFluxFiles                    fFileList;  ///< referenced files, checked against fFiles
+    std::vector<std::string>             fFiles;     ///< ordered list of flux files
+    TChain*                              fChain;     ///< flux entries
+    TChain*                              fMetaChain; ///< gsimple metadata
+    g3numi*                              fG3NuMI;    ///< gnumi geant3 ntuple reader
+    g4numi*                              fG4NuMI;    ///< gnumi geant4 ntuple reader
+    flugg*                               fFlugg;     ///< flugg ntuple reader
+    genie::flux::GSimpleNtpEntry*        fEntry;     ///< gsimple entry buffer
+    genie::flux::GSimpleNtpNuMI*         fNuMI;      ///< gsimple numi buffer
+    genie::flux::GSimpleNtpAux*          fAux;       ///< gsimple aux buffer
+    genie::flux::GSimpleNtpMeta*         fMeta;      ///< gsimple metadata buffer
+  };
+
+}
+#endif //EVGB_FLUXMATERIALIZER_H
@@ -0,0 +1,153 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  FluxPreselector.cxx
+/// \brief GFluxI adapter that drops flux neutrinos before GMCJDriver sees them
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#include <cmath>
+#include <algorithm>
+
+// GENIE includes
+#include "FluxDrivers/GNuMIFlux.h"
+#include "FluxDrivers/GSimpleNtpFlux.h"
+
+// Framework includes
+#include "fhiclcpp/ParameterSet.h"
+#include "cetlib/exception.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+// NuTools includes
+#include "EventGeneratorBase/GENIE/FluxPreselector.h"
+
+namespace evgb {
+
+  //--------------------------------------------------
+  FluxPreselector::FluxPreselector(genie::GFluxI*             flux,
+				   genie::GFluxI*             realFlux,
+				   fhicl::ParameterSet const& pset)
+    : fFlux      (flux)
+    , fNuMIFlux  (dynamic_cast<genie::flux::GNuMIFlux*>(realFlux))
+    , fSimpleFlux(dynamic_cast<genie::flux::GSimpleNtpFlux*>(realFlux))
+    , fEnuMin    (pset.get< double >("EnuMin",          0.) )
+    , fEnuMax    (pset.get< double >("EnuMax",      1.e30 ) )
+    , fUseRegion (false)
+    , fMaxTries  (pset.get< long   >("MaxTries", 100000000) )
+    , fNThrown   (0)
+    , fNAccepted (0)
+  {
+    std::vector<int> flavors = pset.get< std::vector<int> >("Flavors", std::vector<int>());
+    const genie::PDGCodeList& all = fFlux->FluxParticles();
+    for(genie::PDGCodeList::const_iterator itr = all.begin(); itr != all.end(); ++itr){
+      if(flavors.empty() || std::find(flavors.begin(), flavors.end(), *itr) != flavors.end())
+	fFluxParticles.push_back(*itr);
+    }
+    if(fFluxParticles.empty())
+      throw cet::exception("FluxPreselector") << "none of the flux flavors pass the Flavors selection";
+
+    std::vector<int> ptypes = pset.get< std::vector<int> >("ParentTypes", std::vector<int>());
+    fParentTypes.insert(ptypes.begin(), ptypes.end());
+    if(!fParentTypes.empty() && !fNuMIFlux && !fSimpleFlux)
+      throw cet::exception("FluxPreselector") << "ParentTypes needs an ntuple or simple_flux driver";
+
+    std::vector<double> lo = pset.get< std::vector<double> >("RegionLo", std::vector<double>());
+    std::vector<double> hi = pset.get< std::vector<double> >("RegionHi", std::vector<double>());
+    if(lo.size() == 3 && hi.size() == 3){
+      fUseRegion = true;
+      fRegionLo.SetXYZ(std::min(lo[0], hi[0]), std::min(lo[1], hi[1]), std::min(lo[2], hi[2]));
+      fRegionHi.SetXYZ(std::max(lo[0], hi[0]), std::max(lo[1], hi[1]), std::max(lo[2], hi[2]));
+    }
+    else if(!lo.empty() || !hi.empty())
+      throw cet::exception("FluxPreselector") << "RegionLo and RegionHi need 3 values each";
+
+    mf::LogInfo("FluxPreselector") << "flux preselection: " << fFluxParticles.size() << " flavors"
+				   << ", " << fEnuMin << " <= Enu < " << fEnuMax << " GeV"
+				   << ", " << fParentTypes.size() << " parent types (0 = any)"
+				   << ( fUseRegion ? ", region box" : "" );
+  }
+
+  //--------------------------------------------------
+  FluxPreselector::~FluxPreselector()
+  {
+    if(fNThrown > 0)
+      mf::LogInfo("FluxPreselector") << "flux neutrinos passed to GMCJDriver: " << fNAccepted
+				     << " of " << fNThrown;
+  }
+
+  //--------------------------------------------------
+  // Tighter maximum energy also lowers GMCJDriver's maximum interaction
+  // probability, so fewer of the kept neutrinos are rejected
+  double FluxPreselector::MaxEnergy()
+  {
+    return std::min(fFlux->MaxEnergy(), fEnuMax);
+  }
+
+  //--------------------------------------------------
+  bool FluxPreselector::GenerateNext()
+  {
+    for(long itry = 0; itry < fMaxTries; ++itry){
+      if(!fFlux->GenerateNext()) return false;
+      ++fNThrown;
+      if(this->Accept()){
+	++fNAccepted;
+	return true;
+      }
+      if(fFlux->End()) return false;
+    }
+
+    mf::LogWarning("FluxPreselector") << fMaxTries << " flux neutrinos in a row failed the preselection";
+    return false;
+  }
+
+  //--------------------------------------------------
+  // cheapest tests first
+  bool FluxPreselector::Accept()
+  {
+    int pdg = fFlux->PdgCode();
+    if(std::find(fFluxParticles.begin(), fFluxParticles.end(), pdg) == fFluxParticles.end()) return false;
+
+    const TLorentzVector& p4 = fFlux->Momentum();
+    if(p4.E() < fEnuMin || p4.E() >= fEnuMax) return false;
+
+    if(!fParentTypes.empty() && fParentTypes.find(this->ParentType()) == fParentTypes.end()) return false;
+
+    if(fUseRegion && !this->CrossesRegion(fFlux->Position(), p4)) return false;
+
+    return true;
+  }
+
+  //--------------------------------------------------
+  // slab test of the ray x + t p, t >= 0, against the box
+  bool FluxPreselector::CrossesRegion(TLorentzVector const& x4, TLorentzVector const& p4) const
+  {
+    double tmin = 0.;
+    double tmax = 1.e30;
+    for(int i = 0; i < 3; ++i){
+      double x  = x4[i];
+      double p  = p4[i];
+      double lo = fRegionLo[i];
+      double hi = fRegionHi[i];
+      if(std::abs(p) < 1.e-30){
+	if(x < lo || x > hi) return false;
+	continue;
+      }
+      double t1 = (lo - x)/p;
+      double t2 = (hi - x)/p;
+      if(t1 > t2) std::swap(t1, t2);
+      tmin = std::max(tmin, t1);
+      tmax = std::min(tmax, t2);
+      if(tmin > tmax) return false;
+    }
+    return true;
+  }
+
+  //--------------------------------------------------
+  int FluxPreselector::ParentType() const
+  {
+    if(fNuMIFlux) return fNuMIFlux->PassThroughInfo().ptype;
+
+    if(fSimpleFlux && fSimpleFlux->GetCurrentNuMI()) return fSimpleFlux->GetCurrentNuMI()->ptype;
+
+    return 0;
+  }
+
+}
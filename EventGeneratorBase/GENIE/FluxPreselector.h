@@ -0,0 +1,99 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  FluxPreselector.h
+/// \brief GFluxI adapter that drops flux neutrinos before GMCJDriver sees them
+///
+/// Samples that only keep, say, nue CC or a window in neutrino energy
+/// are often filtered after generation, so every rejected neutrino has
+/// already cost its path lengths, cross sections and hadronization.
+/// FluxPreselector sits between the flux driver and GMCJDriver and
+/// skips flux entries that fail cuts on flux quantities only:
+///   flavor        - PDG code of the neutrino (after any flavor mixing)
+///   energy        - EnuMin <= E < EnuMax (GeV)
+///   parent type   - PDG code of the decaying parent, ntuple and
+///                   simple_flux drivers only
+///   region        - the neutrino ray must cross the box RegionLo..RegionHi,
+///                   in the coordinates and units of the flux driver
+/// Skipped entries are still counted by the underlying driver's POT
+/// accounting, so GENIEHelper's TotalExposure() and SpillExposure()
+/// stay those of the full flux, and the kept sample is exactly the
+/// subset a post-generation filter on the same quantities would keep.
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#ifndef EVGB_FLUXPRESELECTOR_H
+#define EVGB_FLUXPRESELECTOR_H
+
+#include <set>
+#include <vector>
+
+#include "TVector3.h"
+#include "TLorentzVector.h"
+
+#include "EVGDrivers/GFluxI.h"
+#include "PDG/PDGCodeList.h"
+
+namespace fhicl {
+  class ParameterSet;
+}
+
+namespace genie {
+  namespace flux {
+    class GNuMIFlux;
+    class GSimpleNtpFlux;
+  }
+}
+
+namespace evgb {
+
+  class FluxPreselector : public genie::GFluxI {
+  public:
+    /// flux     - the driver GMCJDriver would otherwise use (not owned)
+    /// realFlux - the underlying ntuple driver, for the parent type
+    FluxPreselector(genie::GFluxI*             flux,
+		    genie::GFluxI*             realFlux,
+		    fhicl::ParameterSet const& pset);
+    virtual ~FluxPreselector();
+
+    // implement the GFluxI interface
+    virtual const genie::PDGCodeList& FluxParticles()    { return fFluxParticles;       }
+    virtual double                    MaxEnergy();
+    virtual bool                      GenerateNext();
+    virtual int                       PdgCode()          { return fFlux->PdgCode();     }
+    virtual double                    Weight()           { return fFlux->Weight();      }
+    virtual const TLorentzVector&     Momentum()         { return fFlux->Momentum();    }
+    virtual const TLorentzVector&     Position()         { return fFlux->Position();    }
+    virtual bool                      End()              { return fFlux->End();         }
+    virtual long int                  Index()            { return fFlux->Index();       }
+    virtual void                      Clear(Option_t* opt)            { fFlux->Clear(opt);         }
+    virtual void                      GenerateWeighted(bool weighted) { fFlux->GenerateWeighted(weighted); }
+
+    /// the driver being filtered
+    genie::GFluxI* Filtered() const { return fFlux; }
+
+    long NThrown()   const { return fNThrown;   }
+    long NAccepted() const { return fNAccepted; }
+
+  private:
+
+    bool Accept();
+    bool CrossesRegion(TLorentzVector const& x4, TLorentzVector const& p4) const;
+    int  ParentType() const;
+
+    genie::GFluxI*     fFlux;           ///< driver being filtered
+    genie::flux::GNuMIFlux*      fNuMIFlux;    ///< underlying driver if "ntuple", for the parent type
+    genie::flux::GSimpleNtpFlux* fSimpleFlux;  ///< underlying driver if "simple_flux"
+    genie::PDGCodeList fFluxParticles;  ///< flavors that can pass
+    std::set<int>      fParentTypes;    ///< empty = any parent
+    double             fEnuMin;         ///< GeV
+    double             fEnuMax;         ///< GeV
+    bool               fUseRegion;      ///< RegionLo/RegionHi given
+    TVector3           fRegionLo;
+    TVector3           fRegionHi;
+    long               fMaxTries;       ///< give up after this many rejections in a row
+    long               fNThrown;
+    long               fNAccepted;
+  };
+
+}
+
+#endif // EVGB_FLUXPRESELECTOR_H
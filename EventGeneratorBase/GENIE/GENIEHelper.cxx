@@ -17,6 +17,8 @@
 #include <sstream>
 #include <glob.h>
 #include <cstdlib>  // for unsetenv()
+#include <fcntl.h>
+#include <unistd.h>
 
 //ROOT includes
 #include "TH1.h"
@@ -32,9 +34,16 @@
 #include "TRegexp.h"
 #include "TMath.h"
 #include "TStopwatch.h"
+#include "TGeoManager.h"
+#include "TGeoVolume.h"
+#include "TGeoBBox.h"
+#include "TUrl.h"
+#include "TROOT.h"
+#include "TBufferFile.h"
 
 //GENIE includes
 #include "Conventions/Units.h"
+#include "Conventions/GVersion.h"
 #include "EVGCore/EventRecord.h"
 #include "EVGDrivers/GMCJDriver.h"
 #include "GHEP/GHepUtils.h"
@@ -64,6 +73,7 @@
 #include "Interaction/XclsTag.h"
 #include "GHEP/GHepParticle.h"
 #include "PDG/PDGCodeList.h"
+#include "Numerical/RandomGen.h"
 
 // assumes in GENIE
 #include "FluxDrivers/GFluxBlender.h"
@@ -73,10 +83,16 @@
 
 //NuTools includes
 #include "EventGeneratorBase/evgenbase.h"
+#include "EventGeneratorBase/RNGStream.h"
 #include "EventGeneratorBase/GENIE/GENIEHelper.h"
+#include "EventGeneratorBase/GENIE/FiducialVoxelSelector.h"
+#include "EventGeneratorBase/GENIE/FluxMaterializer.h"
+#include "EventGeneratorBase/GENIE/FluxPreselector.h"
+#include "EventGeneratorBase/GENIE/XSecSplineTrimmer.h"
 #include "SimulationBase/MCTruth.h"
 #include "SimulationBase/MCFlux.h"
 #include "SimulationBase/GTruth.h"
+#include "SimulationBase/GHEPRecord.h"
 #include "SimulationBase/MCParticle.h"
 #include "SimulationBase/MCNeutrino.h"
 
@@ -144,6 +160,10 @@ namespace evgb {
   static const int kNuTau    = 4;
   static const int kNuTauBar = 5;
 
+  // with UseRNGStreams, the GENIEHelper that last seeded the process wide
+  // genie::RandomGen in SetEventID()
+  static const GENIEHelper* gRandomGenOwner = 0;
+
   //--------------------------------------------------
   GENIEHelper::GENIEHelper(fhicl::ParameterSet const& pset,
 			   TGeoManager*               geoManager,
@@ -155,16 +175,21 @@ namespace evgb {
     , fGeomD             (0)
     , fFluxD             (0)
     , fFluxD2GMCJD       (0)
+    , fFluxPreselector   (0)
+    , fFluxPreselection  (pset.get< fhicl::ParameterSet      >("FluxPreselection", fhicl::ParameterSet()) )
     , fDriver            (0)
     , fIFDH              (0)
     , fHelperRandom      (0)
     , fUseHelperRndGen4GENIE(pset.get< bool                  >("UseHelperRndGen4GENIE",true))
+    , fRNGStream         (0)
     , fFluxType          (pset.get< std::string              >("FluxType")               )
     , fFluxSearchPaths   (pset.get< std::string              >("FluxSearchPaths","")     )
     , fFluxFilePatterns  (pset.get< std::vector<std::string> >("FluxFiles")              )
     , fMaxFluxFileMB     (pset.get< int                      >("MaxFluxFileMB",    2000) ) // 2GB max default
     , fFluxCopyMethod    (pset.get< std::string              >("FluxCopyMethod","DIRECT")) // "DIRECT" = old direct access method
     , fFluxCleanup       (pset.get< std::string              >("FluxCleanup","/var/tmp") ) // "ALWAYS", "NEVER", "/var/tmp"
+    , fFluxRefMode       (pset.get< bool                     >("FluxRefMode",     false) )
+    , fWeightedEvents    (pset.get< bool                     >("WeightedEvents",  false) )
     , fBeamName          (pset.get< std::string              >("BeamName")               )
     , fTopVolume         (pset.get< std::string              >("TopVolume")              )
     , fWorldVolume       ("volWorld")         
@@ -189,6 +214,7 @@ namespace evgb {
     , fAtmoRt            (pset.get< double                   >("Rt",               20.0) )
     , fEnvironment       (pset.get< std::vector<std::string> >("Environment")            )
     , fXSecTable         (pset.get< std::string              >("XSecTable",          "") ) //e.g. "gxspl-NuMIsmall.xml"
+    , fXSecTrimCache     (pset.get< std::string              >("XSecTrimCache",      "") ) // directory for trimmed splines, "" = use full file
     , fEventGeneratorList(pset.get< std::string              >("EventGeneratorList", "") ) // "Default"
     , fGXMLPATH          (pset.get< std::string              >("GXMLPATH",           "") )
     , fGMSGLAYOUT        (pset.get< std::string              >("GMSGLAYOUT",         "") ) // [BASIC] or SIMPLE
@@ -197,9 +223,15 @@ namespace evgb {
     , fMixerConfig       (pset.get< std::string              >("MixerConfig",    "none") )
     , fMixerBaseline     (pset.get< double                   >("MixerBaseline",      0.) )
     , fFiducialCut       (pset.get< std::string              >("FiducialCut",    "none") )
+    , fFiducialVoxels    (pset.get< int                      >("FiducialVoxels",     32) ) // per dimension, 0 = exact test only
     , fGeomScan          (pset.get< std::string              >("GeomScan",    "default") )
     , fDebugFlags        (pset.get< unsigned int             >("DebugFlags",          0) ) 
+    , fConcurrentInit    (pset.get< bool                     >("ConcurrentInit",  false) )
+    , fInitWallTime      (0.)
+    , fRandomSeed        (0)
   {
+    TStopwatch ctorTime;
+    ctorTime.Start();
 
     std::vector<double> beamCenter   (pset.get< std::vector<double> >("BeamCenter")   );
     std::vector<double> beamDirection(pset.get< std::vector<double> >("BeamDirection"));
@@ -218,10 +250,29 @@ namespace evgb {
       dfltseed = evgb::GetRandomNumberSeed();
     }
     int seedval = pset.get< int >("RandomSeed", dfltseed);
+    fRandomSeed = seedval;
     // initialize random # generator for use within GENIEHelper
     mf::LogInfo("GENIEHelper") << "Init HelperRandom with seed " << seedval; 
     fHelperRandom = new TRandom3(seedval);
 
+    // optionally tie all of the random numbers for an event to its id
+    if ( pset.get< bool >("UseRNGStreams", false) ) {
+      // GNuMIFlux and GSimpleNtpFlux walk their files from one start
+      // entry, so the flux neutrinos of an event depend on how many
+      // entries the events before it used, whatever the seed.  There is
+      // no dk2nu driver here; GDk2NuFlux::SetRandomEntries() is for
+      // generators that set it up themselves
+      if ( fFluxType.compare("ntuple")      == 0 ||
+           fFluxType.compare("simple_flux") == 0 ||
+           fFluxType.compare("dk2nu")       == 0    )
+        throw cet::exception("GENIEHelper")
+          << "UseRNGStreams can not make \"" << fFluxType << "\" fluxes reproducible"
+          << " out of order: the flux driver reads its entries sequentially";
+      mf::LogInfo("GENIEHelper") << "Reseed from RNGStream " << kGENIEStream
+                                 << " for each event, base seed " << seedval;
+      fRNGStream = new evgb::RNGStream(seedval, kGENIEStream);
+    }
+
     /// Determine which flux files to use
     /// Do this after random number seed initialization for stability
 
@@ -239,10 +290,6 @@ namespace evgb {
       std::copy(fluxpattset.begin(),fluxpattset.end(),
                 std::back_inserter(fFluxFilePatterns));
     }
-    ExpandFluxPaths();
-    if (fFluxCopyMethod == "DIRECT") ExpandFluxFilePatternsDirect();
-    else                             ExpandFluxFilePatternsIFDH();
-
     /// Set the GENIE environment
     /// if using entries in the fEnvironment vector
     //    they should come in pairs of variable name key, then value
@@ -263,9 +310,34 @@ namespace evgb {
     // Determine EventGeneratorList to use
     FindEventGeneratorList();
 
+    // Select (and possibly copy) the flux files.  With ConcurrentInit the
+    // IFDH lookup and copy runs on its own thread while the splines are
+    // read, and is joined before the ctor returns.  It does not touch
+    // GENIE.  Of ROOT it uses fHelperRandom to shuffle the files, which
+    // nothing else draws from before the join (gRandom is only swapped
+    // for it in Sample()), and TMath::Sort, which keeps no state
+    ExpandFluxPaths();
+    std::thread*       stageThread = 0;
+    std::exception_ptr stageError;
+    if (fFluxCopyMethod == "DIRECT")
+      RunInitPhase("flux files", [this]() { ExpandFluxFilePatternsDirect(); });
+    else
+      RunInitPhase("flux files", [this]() { ExpandFluxFilePatternsIFDH(); },
+                   fConcurrentInit ? &stageThread : 0, &stageError);
+
     // Figure out which cross section file to use
     // post R-2_8_0 this actually triggers reading the file
-    ReadXSecTable();
+    try {
+      ReadXSecTable();
+    }
+    catch (...) {
+      if ( stageThread ) {
+        stageThread->join();
+        delete stageThread;
+      }
+      throw;
+    }
+    JoinInitPhase(stageThread, stageError);
 
 #ifndef GENIE_USE_ENVVAR
     // In case we're printing the event record, how verbose should it be
@@ -404,6 +476,9 @@ namespace evgb {
     else
       mf::LogInfo("GENIEHelper") << "Using " << fPOTPerSpill << " pot for each spill";
 
+    ctorTime.Stop();
+    fInitWallTime += ctorTime.RealTime();
+
     return;
   }
 
@@ -443,7 +518,7 @@ namespace evgb {
         << ( (fDriver) ? " genie::GMCJDriver":"" )
         << ( (fFluxD)  ? " genie::GFluxI":"" );
     } else {
-      double probscale = fDriver->GlobProbScale();
+      double probscale = ExposureScale();
       double rawpots   = 0;
       if      ( fFluxType.compare("ntuple")==0 ) {
         genie::flux::GNuMIFlux* numiFlux = dynamic_cast<genie::flux::GNuMIFlux *>(fFluxD);
@@ -455,8 +530,13 @@ namespace evgb {
         rawpots = simpleFlux->UsedPOTs();
         simpleFlux->PrintConfig();
       }
+      if ( fFluxPreselector )
+        mf::LogInfo("GENIEHelper") 
+          << "FluxPreselection kept " << fFluxPreselector->NAccepted()
+          << " of " << fFluxPreselector->NThrown() << " flux neutrinos";
       mf::LogInfo("GENIEHelper") 
         << " Total Exposure " << fTotalExposure
+        << ( fWeightedEvents ? " (weighted events)" : "" )
         << " GMCJDriver GlobProbScale " << probscale 
         << " FluxDriver base pots " << rawpots
         << " corrected POTS " << rawpots/TMath::Max(probscale,1.0e-100);
@@ -466,6 +546,8 @@ namespace evgb {
     delete fGenieEventRecord;
     delete fDriver;
     delete fHelperRandom;
+    delete fRNGStream;
+    if ( gRandomGenOwner == this ) gRandomGenOwner = 0;
 
     if ( fIFDH ) {
       if        ( fFluxCleanup.find("ALWAYS")   == 0 ) {
@@ -485,6 +567,16 @@ namespace evgb {
     }
   }
 
+  //--------------------------------------------------
+  // Factor to divide the flux driver's POT by to get the exposure:
+  // unweighted events are accepted with probability P/Pmax, weighted
+  // events always interact and carry P themselves
+  double GENIEHelper::ExposureScale() const
+  {
+    if ( fWeightedEvents ) return 1.;
+    return fDriver->GlobProbScale();
+  }
+
   //--------------------------------------------------
   double GENIEHelper::TotalHistFlux() 
   {
@@ -505,19 +597,45 @@ namespace evgb {
     fDriver->SetEventGeneratorList(fEventGeneratorList);
 #endif
 
-    // initialize the Geometry and Flux drivers
-    InitializeGeometry();
-    InitializeFluxDriver();
+    TStopwatch initTime;
+    initTime.Start();
+
+    // initialize the Geometry and Flux drivers; both use the GENIE
+    // singletons (RandomGen, PDGLibrary, ...) and ROOT, so one at a time
+    RunInitPhase("flux driver", [this]() { InitializeFluxDriver(); });
+    RunInitPhase("geometry",    [this]() { InitializeGeometry();   });
 
     fDriver->UseFluxDriver(fFluxD2GMCJD);
     fDriver->UseGeomAnalyzer(fGeomD);
 
+    if ( fWeightedEvents ) {
+      // every flux neutrino crossing the geometry interacts and the event
+      // carries its interaction probability as weight, so the exposure is
+      // the POT thrown (no GlobProbScale); this needs a flux driver that
+      // counts POT
+      if ( fFluxType.compare("ntuple")      != 0 &&
+           fFluxType.compare("simple_flux") != 0    ) {
+        throw cet::exception("GENIEHelper")
+          << "WeightedEvents needs an \"ntuple\" or \"simple_flux\" flux, not \""
+          << fFluxType << "\"";
+      }
+      fDriver->ForceInteraction();
+      mf::LogInfo("GENIEHelper") 
+        << "weighted event generation: every flux neutrino crossing the "
+        << "geometry interacts, weight in GTruth::fweight";
+    }
+
     // must come after creation of Geom, Flux and GMCJDriver
-    ConfigGeomScan();  // could trigger fDriver->UseMaxPathLengths(*xmlfile*)
+    RunInitPhase("max path lengths", [this]() {
+        ConfigGeomScan();  // could trigger fDriver->UseMaxPathLengths(*xmlfile*)
+        fDriver->Configure();  // trigger GeomDriver::ComputeMaxPathLengths() 
+        fDriver->UseSplines();
+        if ( ! fWeightedEvents ) fDriver->ForceSingleProbScale();
+      });
 
-    fDriver->Configure();  // trigger GeomDriver::ComputeMaxPathLengths() 
-    fDriver->UseSplines();
-    fDriver->ForceSingleProbScale();
+    initTime.Stop();
+    fInitWallTime += initTime.RealTime();
+    ReportInitPhases();
 
     if ( fFluxType.compare("histogram") == 0 && fEventsPerSpill < 0.01 ) {
       // fluxes are assumed to be given in units of neutrinos/cm^2/1e20POT/energy 
@@ -570,7 +688,7 @@ namespace evgb {
       }
     }
     if ( doprintpre ) {
-      double probscale = fDriver->GlobProbScale();
+      double probscale = ExposureScale();
       mf::LogInfo("GENIEHelper") 
         << "Pre-Event Generation: " 
         << " FluxDriver base " << preUsedFluxPOTs
@@ -679,8 +797,9 @@ namespace evgb {
     mf::LogInfo("GENIEHelper") << "fiducial cut: " << fidcut;
 
     // for now, only fiducial no "rock box"
-    genie::geometry::GeomVolSelectorFiducial* fidsel =
-      new genie::geometry::GeomVolSelectorFiducial();
+    // the voxel selector gives the same answers as GeomVolSelectorFiducial
+    // but skips the exact test for segments well inside or outside the cut
+    evgb::FiducialVoxelSelector* fidsel = new evgb::FiducialVoxelSelector();
 
     fidsel->SetRemoveEntries(true);  // drop segments that won't be considered
 
@@ -721,7 +840,9 @@ namespace evgb {
     
     // std::vector elements are required to be adjacent so we can treat address as ptr
     
+    string shape = "";
     if        ( stype.find("zcyl")   != string::npos ) {
+      shape = "zcyl";
       // cylinder along z direction at (x0,y0) radius zmin zmax
       if ( nvals < 5 ) 
         mf::LogError("GENIEHelper") << "MakeZCylinder needs 5 values, not " << nvals
@@ -729,6 +850,7 @@ namespace evgb {
       fidsel->MakeZCylinder(vals[0],vals[1],vals[2],vals[3],vals[4]);
 
     } else if ( stype.find("box")    != string::npos ) {
+      shape = "box";
       // box (xmin,ymin,zmin) (xmax,ymax,zmax)
       if ( nvals < 6 ) 
         mf::LogError("GENIEHelper") << "MakeBox needs 6 values, not " << nvals
@@ -738,6 +860,7 @@ namespace evgb {
       fidsel->MakeBox(xyzmin,xyzmax);
 
     } else if ( stype.find("zpoly")  != string::npos ) {
+      shape = "zpoly";
       // polygon along z direction nfaces at (x0,y0) radius phi zmin zmax
       if ( nvals < 7 ) 
         mf::LogError("GENIEHelper") << "MakeZPolygon needs 7 values, not " << nvals
@@ -749,6 +872,7 @@ namespace evgb {
       fidsel->MakeZPolygon(nfaces,vals[1],vals[2],vals[3],vals[4],vals[5],vals[6]);
 
     } else if ( stype.find("sphere") != string::npos ) {
+      shape = "sphere";
       // sphere at (x0,y0,z0) radius 
       if ( nvals < 4 ) 
         mf::LogError("GENIEHelper") << "MakeZSphere needs 4 values, not " << nvals
@@ -768,6 +892,19 @@ namespace evgb {
       fidsel->SetReverseFiducial(true);
       mf::LogInfo("GENIEHelper") << "Reverse sense of fiducial volume cut";
     }
+
+    // voxelize the bounding box of the top volume, in its own coordinates
+    if ( fFiducialVoxels > 0 && shape != "" ) {
+      TGeoVolume* topvol = fGeoManager->FindVolumeFast(fTopVolume.c_str());
+      if ( ! topvol ) topvol = fGeoManager->GetTopVolume();
+      TGeoBBox* bbox = dynamic_cast<TGeoBBox*>(topvol->GetShape());
+      if ( bbox ) {
+        const double* origin = bbox->GetOrigin();
+        TVector3 lo(origin[0] - bbox->GetDX(), origin[1] - bbox->GetDY(), origin[2] - bbox->GetDZ());
+        TVector3 hi(origin[0] + bbox->GetDX(), origin[1] + bbox->GetDY(), origin[2] + bbox->GetDZ());
+        fidsel->BuildVoxels(shape, vals, master, reverse, rgeom, lo, hi, fFiducialVoxels);
+      }
+    }
     
     rgeom->AdoptGeomVolSelector(fidsel);
 
@@ -1069,6 +1206,27 @@ namespace evgb {
       }
     }
 
+    // Optionally drop flux neutrinos that fail cuts on flux quantities
+    // before GMCJDriver spends any time on them; the real driver still
+    // counts their POT
+    if ( ! fFluxPreselection.is_empty() ) {
+      // POT per spill with histogram fluxes sets the number of events
+      // from the unfiltered flux integral, which would no longer hold
+      if ( fFluxType.compare("histogram") == 0 && fEventsPerSpill < 0.01 )
+        throw cet::exception("GENIEHelper")
+          << "FluxPreselection with a histogram flux needs EventsPerSpill";
+      fFluxPreselector = new evgb::FluxPreselector(fFluxD2GMCJD, fFluxD, fFluxPreselection);
+      fFluxD2GMCJD = fFluxPreselector;
+    }
+
+    // record the files, in the order the driver chained them, so the
+    // references in the MCFlux can be checked against them later
+    if ( fFluxRefMode ) {
+      fFluxFileList = evgb::MakeFluxFileList(fFluxType, fSelectedFluxFiles);
+      if ( fFluxFileList.TotalEntries() == 0 )
+        throw cet::exception("GENIEHelper") << "FluxRefMode found no entries in the flux files";
+    }
+
     return;
   }
 
@@ -1251,9 +1409,116 @@ namespace evgb {
     return true;
   }
 
+  //--------------------------------------------------
+  void GENIEHelper::SetEventID(unsigned int run,
+                               unsigned int subrun,
+                               unsigned int event)
+  {
+    if ( ! fRNGStream ) return;
+
+    // every generator that keeps its own state is reseeded from the
+    // stream, so the event depends only on (run, subrun, event)
+    fRNGStream->SetEvent(run, subrun, event);
+    fHelperRandom->SetSeed(fRNGStream->DerivedSeed());
+    genie::RandomGen::Instance()->SetSeed(fRNGStream->DerivedSeed());
+    gRandomGenOwner = this;
+
+    LOG_DEBUG("GENIEHelper") << "reseeded for run " << run << " subrun " << subrun
+                             << " event " << event;
+
+    return;
+  }
+
+  //--------------------------------------------------
+  void GENIEHelper::InitializeWorker(unsigned int iworker, unsigned int nworkers)
+  {
+    // a forked child shares the open file descriptions, and with them the
+    // file offsets, of the parent and its siblings; TFile seeks and reads
+    // separately, so point each local file at a fresh description of its own
+    TIter next(gROOT->GetListOfFiles());
+    while ( TFile* file = dynamic_cast<TFile*>(next()) ) {
+      int fd = file->GetFd();
+      if ( fd < 0 ) continue;  // not a local file
+      const char* path = file->GetEndpointUrl()->GetFile();
+      int newfd = open(path, O_RDONLY);
+      if ( newfd < 0 || dup2(newfd, fd) < 0 ) {
+        throw cet::exception("GENIEHelper")
+          << "worker " << iworker << " could not reopen " << path;
+      }
+      close(newfd);
+    }
+
+    if ( ! fRNGStream ) {
+      // a seed per worker, from a stream position no event uses
+      RNGStream workerStream(fRandomSeed, kGENIEStream);
+      workerStream.SetEvent(0xffffffff, 0xffffffff, iworker);
+      UInt_t seed = workerStream.DerivedSeed();
+      fHelperRandom->SetSeed(seed);
+      genie::RandomGen::Instance()->SetSeed(seed);
+      mf::LogInfo("GENIEHelper") << "worker " << iworker << " reseeded with " << seed;
+    }
+
+    // the ntuple drivers read their chain sequentially from a start entry
+    // they picked in Initialize(), i.e. before the fork, so every worker
+    // would walk the same entries.  Hand each worker a contiguous block of
+    // the selected files instead; the driver object stays the same (the
+    // GMCJDriver and any blender or preselector keep pointing at it) and
+    // only reloads its chain from that block
+    if ( nworkers > 1 && ( fFluxType.compare("ntuple")      == 0 ||
+                           fFluxType.compare("simple_flux") == 0    ) ) {
+#ifdef GFLUX_MISSING_SETORVECTOR
+      throw cet::exception("GENIEHelper")
+        << "this GENIE version takes a single flux file pattern, so "
+        << nworkers << " workers can not be given separate flux files";
+#else
+      if ( fSelectedFluxFiles.size() < nworkers )
+        throw cet::exception("GENIEHelper")
+          << "only " << fSelectedFluxFiles.size() << " flux files for " << nworkers
+          << " workers; every worker needs files of its own so that no two"
+          << " read the same flux entries";
+
+      size_t nfiles = fSelectedFluxFiles.size();
+      std::vector<std::string> workerFiles(fSelectedFluxFiles.begin() + nfiles*iworker/nworkers,
+                                           fSelectedFluxFiles.begin() + nfiles*(iworker+1)/nworkers);
+      fSelectedFluxFiles.swap(workerFiles);
+
+      if ( fFluxType.compare("ntuple") == 0 ) {
+        genie::flux::GNuMIFlux* numiFlux = dynamic_cast<genie::flux::GNuMIFlux *>(fFluxD);
+        numiFlux->LoadBeamSimData(fSelectedFluxFiles, fDetLocation);
+        if ( TMath::Abs(fFluxUpstreamZ) < 1.0e30 ) numiFlux->SetUpstreamZ(fFluxUpstreamZ);
+        numiFlux->Clear("CycleHistory");
+      }
+      else {
+        genie::flux::GSimpleNtpFlux* simpleFlux = dynamic_cast<genie::flux::GSimpleNtpFlux *>(fFluxD);
+        simpleFlux->LoadBeamSimData(fSelectedFluxFiles, fDetLocation);
+        if ( TMath::Abs(fFluxUpstreamZ) < 1.0e30 ) simpleFlux->SetUpstreamZ(fFluxUpstreamZ);
+        simpleFlux->Clear("CycleHistory");
+      }
+      fTotalExposure = 0.;
+      fSpillExposure = 0.;
+
+      // the MCFlux references now point into this worker's chain
+      if ( fFluxRefMode ) fFluxFileList = evgb::MakeFluxFileList(fFluxType, fSelectedFluxFiles);
+
+      mf::LogInfo("GENIEHelper") << "worker " << iworker << " reads flux files "
+                                 << nfiles*iworker/nworkers << " to "
+                                 << nfiles*(iworker+1)/nworkers - 1 << " of " << nfiles;
+#endif
+    }
+
+    return;
+  }
+
   //--------------------------------------------------
   bool GENIEHelper::Sample(simb::MCTruth &truth, simb::MCFlux  &flux, simb::GTruth &gtruth)
   {
+    // genie::RandomGen is one per process; if another GENIEHelper reseeded
+    // it since our SetEventID() this event's numbers are not our own
+    if ( fRNGStream && gRandomGenOwner != this )
+      throw cet::exception("GENIEHelper")
+        << "UseRNGStreams: genie::RandomGen was not seeded for this event by this"
+        << " GENIEHelper; call SetEventID() before sampling each event";
+
     // set the top volume for the geometry
     fGeoManager->SetTopVolume(fGeoManager->FindVolumeFast(fTopVolume.c_str()));
     
@@ -1276,13 +1541,13 @@ namespace evgb {
 
     // pack the flux information
     if(fFluxType.compare("ntuple") == 0){
-      fSpillExposure = (dynamic_cast<genie::flux::GNuMIFlux *>(fFluxD)->UsedPOTs()/fDriver->GlobProbScale() - fTotalExposure);
+      fSpillExposure = (dynamic_cast<genie::flux::GNuMIFlux *>(fFluxD)->UsedPOTs()/ExposureScale() - fTotalExposure);
       flux.fFluxType = simb::kNtuple;
       PackNuMIFlux(flux);
     }
     else if ( fFluxType.compare("simple_flux")==0 ) { 
       // pack the flux information
-      fSpillExposure = (dynamic_cast<genie::flux::GSimpleNtpFlux *>(fFluxD)->UsedPOTs()/fDriver->GlobProbScale() - fTotalExposure);
+      fSpillExposure = (dynamic_cast<genie::flux::GSimpleNtpFlux *>(fFluxD)->UsedPOTs()/ExposureScale() - fTotalExposure);
       flux.fFluxType = simb::kSimple_Flux;
       PackSimpleFlux(flux);
     }
@@ -1353,8 +1618,9 @@ namespace evgb {
     flux.fgenz    = nuray_pos.Z();
     flux.fgen2vtx = ray2vtx.Mag();
 
+    genie::GFluxI* mixed = ( fFluxPreselector ) ? fFluxPreselector->Filtered() : fFluxD2GMCJD;
     genie::flux::GFluxBlender* blender = 
-      dynamic_cast<genie::flux::GFluxBlender*>(fFluxD2GMCJD);
+      dynamic_cast<genie::flux::GFluxBlender*>(mixed);
     if ( blender ) { 
       flux.fdk2gen = blender->TravelDist();
       // / if mixing flavors print the state of the blender
@@ -1379,6 +1645,21 @@ namespace evgb {
     return true;
   }
 
+  //--------------------------------------------------
+  // convert the flux driver's chain entry into a file of fFluxFileList
+  // and an entry of that file
+  void GENIEHelper::SetFluxReference(long long chainEntry, simb::MCFlux &flux)
+  {
+    int       file  = -1;
+    long long entry = -1;
+    if ( ! fFluxFileList.Locate(chainEntry, file, entry) )
+      throw cet::exception("GENIEHelper") << "flux driver entry " << chainEntry
+                                          << " is not in the " << fFluxFileList.TotalEntries()
+                                          << " entries of the flux file list";
+    flux.fFluxFile  = file;
+    flux.fFluxEntry = entry;
+  }
+
   //--------------------------------------------------
   void GENIEHelper::PackNuMIFlux(simb::MCFlux &flux)
   {
@@ -1398,68 +1679,21 @@ namespace evgb {
     // maintained variable names from gnumi ntuples
     // see http://www.hep.utexas.edu/~zarko/wwwgnumi/v19/[/v19/output_gnumi.html]
 
-    flux.frun      = nflux.run;
-    flux.fevtno    = nflux.evtno;
-    flux.fndxdz    = nflux.ndxdz;
-    flux.fndydz    = nflux.ndydz;
-    flux.fnpz      = nflux.npz;
-    flux.fnenergy  = nflux.nenergy;
-    flux.fndxdznea = nflux.ndxdznea;
-    flux.fndydznea = nflux.ndydznea;
-    flux.fnenergyn = nflux.nenergyn;
-    flux.fnwtnear  = nflux.nwtnear;
-    flux.fndxdzfar = nflux.ndxdzfar;
-    flux.fndydzfar = nflux.ndydzfar;
-    flux.fnenergyf = nflux.nenergyf;
-    flux.fnwtfar   = nflux.nwtfar;
-    flux.fnorig    = nflux.norig;
-    flux.fndecay   = nflux.ndecay;
-    flux.fntype    = nflux.ntype;
-    flux.fvx       = nflux.vx;
-    flux.fvy       = nflux.vy;
-    flux.fvz       = nflux.vz;
-    flux.fpdpx     = nflux.pdpx;
-    flux.fpdpy     = nflux.pdpy;
-    flux.fpdpz     = nflux.pdpz;
-    flux.fppdxdz   = nflux.ppdxdz;
-    flux.fppdydz   = nflux.ppdydz;
-    flux.fpppz     = nflux.pppz;
-    flux.fppenergy = nflux.ppenergy;
-    flux.fppmedium = nflux.ppmedium;
-    flux.fptype    = nflux.ptype;     // converted to PDG
-    flux.fppvx     = nflux.ppvx;
-    flux.fppvy     = nflux.ppvy;
-    flux.fppvz     = nflux.ppvz;
-    flux.fmuparpx  = nflux.muparpx;
-    flux.fmuparpy  = nflux.muparpy;
-    flux.fmuparpz  = nflux.muparpz;
-    flux.fmupare   = nflux.mupare;
-    flux.fnecm     = nflux.necm;
-    flux.fnimpwt   = nflux.nimpwt;
-    flux.fxpoint   = nflux.xpoint;
-    flux.fypoint   = nflux.ypoint;
-    flux.fzpoint   = nflux.zpoint;
-    flux.ftvx      = nflux.tvx;
-    flux.ftvy      = nflux.tvy;
-    flux.ftvz      = nflux.tvz;
-    flux.ftpx      = nflux.tpx;
-    flux.ftpy      = nflux.tpy;
-    flux.ftpz      = nflux.tpz;
-    flux.ftptype   = nflux.tptype;   // converted to PDG
-    flux.ftgen     = nflux.tgen;
-    flux.ftgptype  = nflux.tgptype;  // converted to PDG
-    flux.ftgppx    = nflux.tgppx;
-    flux.ftgppy    = nflux.tgppy;
-    flux.ftgppz    = nflux.tgppz;
-    flux.ftprivx   = nflux.tprivx;
-    flux.ftprivy   = nflux.tprivy;
-    flux.ftprivz   = nflux.tprivz;
-    flux.fbeamx    = nflux.beamx;
-    flux.fbeamy    = nflux.beamy;
-    flux.fbeamz    = nflux.beamz;
-    flux.fbeampx   = nflux.beampx;
-    flux.fbeampy   = nflux.beampy;
-    flux.fbeampz   = nflux.beampz;    
+    if ( fFluxRefMode ) {
+      this->SetFluxReference(gnf->GetEntryNumber(), flux);
+      // only the reference and the commonly used fields, the rest can be
+      // filled later by evgb::FluxMaterializer
+      flux.fIsFluxRef = true;
+      flux.fntype     = nflux.ntype;
+      flux.fptype     = nflux.ptype;
+      flux.fndecay    = nflux.ndecay;
+      flux.fnimpwt    = nflux.nimpwt;
+      flux.fnenergyn  = nflux.nenergyn;
+      flux.fnwtnear   = nflux.nwtnear;
+      flux.fnenergyf  = nflux.nenergyf;
+      flux.fnwtfar    = nflux.nwtfar;
+    }
+    else FillNuMIFlux(nflux, flux);
 
     flux.fdk2gen   = gnf->GetDecayDist();
 
@@ -1644,6 +1878,26 @@ namespace evgb {
 
   }
 
+  //--------------------------------------------------
+  // Stream the last generated genie::EventRecord into ghep so that
+  // reweighting can read it back as it was generated instead of
+  // rebuilding it from MCTruth and GTruth.  Call after a successful
+  // Sample(); returns false if there is no record.
+  bool GENIEHelper::PackGHEPRecord(simb::GHEPRecord &ghep)
+  {
+    ghep.Clear();
+    if ( ! fGenieEventRecord ) return false;
+
+    TBufferFile buf(TBuffer::kWrite, 16*1024);
+    fGenieEventRecord->Streamer(buf);
+    ghep.SetBuffer(buf.Buffer(), buf.Length());
+#ifdef __GENIE_RELEASE_CODE__
+    ghep.SetGENIEVersion(__GENIE_RELEASE_CODE__);
+#endif
+
+    return true;
+  }
+
   //----------------------------------------------------------------------
   void GENIEHelper::PackSimpleFlux(simb::MCFlux &flux)
   {
@@ -1658,69 +1912,23 @@ namespace evgb {
     const genie::flux::GSimpleNtpEntry* nflux_entry = gsf->GetCurrentEntry();
     const genie::flux::GSimpleNtpNuMI*  nflux_numi  = gsf->GetCurrentNuMI();
   
-    flux.fntype  = nflux_entry->pdg;
-    flux.fnimpwt = nflux_entry->wgt;
-    flux.fdk2gen = nflux_entry->dist;
-    flux.fnenergyn = flux.fnenergyf = nflux_entry->E;
-
-    if ( nflux_numi ) {
-      flux.frun      = nflux_numi->run;
-      flux.fevtno    = nflux_numi->evtno;
-      flux.ftpx      = nflux_numi->tpx;
-      flux.ftpy      = nflux_numi->tpy;
-      flux.ftpz      = nflux_numi->tpz;
-      flux.ftptype   = nflux_numi->tptype;   // converted to PDG
-      flux.fvx       = nflux_numi->vx;
-      flux.fvy       = nflux_numi->vy;
-      flux.fvz       = nflux_numi->vz;
-
-      flux.fndecay   = nflux_numi->ndecay;
-      flux.fppmedium = nflux_numi->ppmedium;
-
-      flux.fpdpx     = nflux_numi->pdpx;
-      flux.fpdpy     = nflux_numi->pdpy;
-      flux.fpdpz     = nflux_numi->pdpz;
-
-      double apppz = nflux_numi->pppz;
-      if ( TMath::Abs(nflux_numi->pppz) < 1.0e-30 ) apppz = 1.0e-30;
-      flux.fppdxdz   = nflux_numi->pppx / apppz;
-      flux.fppdydz   = nflux_numi->pppy / apppz;
-      flux.fpppz     = nflux_numi->pppz;
-
-      flux.fptype    = nflux_numi->ptype;
-
-    }
-    
-    // anything useful stuffed into vdbl or vint?
-    // need to check the metadata  auxintname, auxdblname
-
     const genie::flux::GSimpleNtpAux*   nflux_aux  = gsf->GetCurrentAux();
     const genie::flux::GSimpleNtpMeta*  nflux_meta  = gsf->GetCurrentMeta();
-    if ( nflux_aux && nflux_meta ) {
-
-      // references just for reducing complexity
-      const std::vector<std::string>& auxdblname = nflux_meta->auxdblname;
-      const std::vector<std::string>& auxintname = nflux_meta->auxintname;
-      const std::vector<int>&    auxint = nflux_aux->auxint;
-      const std::vector<double>& auxdbl = nflux_aux->auxdbl;
-
-      for (size_t id=0; id<auxdblname.size(); ++id) {
-        if ("muparpx"   == auxdblname[id]) flux.fmuparpx  = auxdbl[id];
-        if ("muparpy"   == auxdblname[id]) flux.fmuparpy  = auxdbl[id];
-        if ("muparpz"   == auxdblname[id]) flux.fmuparpz  = auxdbl[id];
-        if ("mupare"    == auxdblname[id]) flux.fmupare   = auxdbl[id];
-        if ("necm"      == auxdblname[id]) flux.fnecm     = auxdbl[id];
-        if ("nimpwt"    == auxdblname[id]) flux.fnimpwt   = auxdbl[id];
-        if ("fgXYWgt"   == auxdblname[id]) {
-          flux.fnwtnear = flux.fnwtfar = auxdbl[id]; 
-        }
-      }
-      for (size_t ii=0; ii<auxintname.size(); ++ii) {
-        if ("tgen"      == auxintname[ii]) flux.ftgen     = auxint[ii];
-        if ("tgptype"   == auxintname[ii]) flux.ftgptype  = auxint[ii];
-      }
 
+    if ( fFluxRefMode ) {
+      this->SetFluxReference(gsf->GetEntryNumber(), flux);
+      // only the reference and the commonly used fields, the rest can be
+      // filled later by evgb::FluxMaterializer
+      flux.fIsFluxRef = true;
+      flux.fntype     = nflux_entry->pdg;
+      flux.fnimpwt    = nflux_entry->wgt;
+      flux.fnenergyn  = flux.fnenergyf = nflux_entry->E;
+      if ( nflux_numi ) {
+        flux.fptype   = nflux_numi->ptype;
+        flux.fndecay  = nflux_numi->ndecay;
+      }
     }
+    else FillSimpleFlux(nflux_entry, nflux_numi, nflux_aux, nflux_meta, flux);
 
 #define RWH_TEST
 #ifdef RWH_TEST
@@ -2424,12 +2632,34 @@ namespace evgb {
     mf::LogInfo("GENIEHelper") 
       << "XSecTable/GSPLOAD full path \"" << fXSecTable << "\"";
 
+    if ( fXSecTrimCache != "" ) {
+      // load only the splines for the nuclei in the geometry and the
+      // processes of the generator list, trimmed once into the cache
+      RunInitPhase("xsec trim", [this]() {
+          XSecSplineTrimmer trimmer(fEventGeneratorList, fGenFlavors);
+          trimmer.AddTargets(fGeoManager);
+          fXSecTable = trimmer.TrimToCache(fXSecTable, fXSecTrimCache);
+        });
+      fEnvironment[indxGSPLOAD+1] = fXSecTable;
+    }
+
 #ifndef GENIE_USE_ENVVAR
+    // can't use gSystem->Unsetenv() as it is really gSystem->Setenv(name,"")
+    unsetenv("GSPLOAD");  // MUST!!! ensure that it isn't set externally
+    RunInitPhase("xsec splines", [this]() { LoadXSecTable(); });
+#else
+    // pre R-2_8_0 uses $GSPLOAD to indicate x-sec table
+    gSystem->Setenv("GSPLOAD", fXSecTable.c_str());
+#endif
+
+  }
+
+  //--------------------------------------------------
+  void GENIEHelper::LoadXSecTable()
+  {
     TStopwatch xtime;
     xtime.Start();
 
-    // can't use gSystem->Unsetenv() as it is really gSystem->Setenv(name,"")
-    unsetenv("GSPLOAD");  // MUST!!! ensure that it isn't set externally
     genie::utils::app_init::XSecTable(fXSecTable,true);
 
     xtime.Stop();
@@ -2438,11 +2668,70 @@ namespace evgb {
       << " Real " << xtime.RealTime() << " s,"
       << " CPU " << xtime.CpuTime() << " s"
       << " from " << fXSecTable;
-#else
-    // pre R-2_8_0 uses $GSPLOAD to indicate x-sec table
-    gSystem->Setenv("GSPLOAD", fXSecTable.c_str());
-#endif
+  }
+
+  //--------------------------------------------------
+  template <class F>
+  void GENIEHelper::RunInitPhase(std::string const& name, F fn,
+                                 std::thread** thread,
+                                 std::exception_ptr* error)
+  {
+    auto timed = [this, name, fn, error]() {
+      TStopwatch ptime;
+      ptime.Start();
+      try {
+        fn();
+      }
+      catch (...) {
+        // rethrown on the calling thread by JoinInitPhase()
+        if ( ! error ) throw;
+        *error = std::current_exception();
+      }
+      ptime.Stop();
+      std::lock_guard<std::mutex> lock(fInitPhaseMutex);
+      fInitPhases.push_back(std::make_pair(name, ptime.RealTime()));
+    };
+
+    if ( thread ) *thread = new std::thread(timed);
+    else          timed();
+  }
+
+  //--------------------------------------------------
+  void GENIEHelper::JoinInitPhase(std::thread*& thread, std::exception_ptr& error)
+  {
+    if ( thread ) {
+      thread->join();
+      delete thread;
+      thread = 0;
+    }
+    if ( error ) {
+      std::exception_ptr e = error;
+      error = std::exception_ptr();
+      std::rethrow_exception(e);
+    }
+  }
+
+  //--------------------------------------------------
+  void GENIEHelper::ReportInitPhases()
+  {
+    std::lock_guard<std::mutex> lock(fInitPhaseMutex);
+
+    double sum = 0.;
+    std::ostringstream phases;
+    for ( size_t i = 0; i < fInitPhases.size(); ++i ) {
+      phases << "\n   " << std::setw(18) << std::left << fInitPhases[i].first
+             << std::right << std::fixed << std::setprecision(2)
+             << std::setw(9) << fInitPhases[i].second << " s";
+      sum += fInitPhases[i].second;
+    }
+    mf::LogInfo("GENIEHelper") 
+      << "Startup phases (" << ( fConcurrentInit ? "concurrent" : "sequential" ) << "):"
+      << phases.str()
+      << "\n   sum of phases " << std::fixed << std::setprecision(2) << sum << " s,"
+      << " wall time in GENIEHelper " << fInitWallTime << " s";
 
+    fInitPhases.clear();
+    fInitWallTime = 0.;
   }
 
   //---------------------------------------------------------
@@ -10,22 +10,25 @@
 
 #include <vector>
 #include <set>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <exception>
 
 #include "TGeoManager.h"
 
+#include "fhiclcpp/ParameterSet.h"
+
 #include "EVGDrivers/GFluxI.h"
 #include "EVGDrivers/GeomAnalyzerI.h"
 #include "EVGDrivers/GMCJDriver.h"
 
+#include "SimulationBase/MCFluxFiles.h"
+
 class TH1D;
 class TH2D;
 class TRandom3;
 
-///parameter set interface
-namespace fhicl {
-  class ParameterSet;
-}
-
 /// IFDH interface (data handling)
 namespace ifdh_ns {
   class ifdh;
@@ -35,6 +38,7 @@ namespace simb {
   class MCTruth;     
   class MCFlux;      
   class GTruth;
+  class GHEPRecord;
 }
 
 ///GENIE neutrino interaction simulation
@@ -42,6 +46,9 @@ namespace genie { class EventRecord; }
 
 namespace evgb{
 
+  class RNGStream;
+  class FluxPreselector;
+
   class GENIEHelper {
     
   public:
@@ -57,6 +64,34 @@ namespace evgb{
     bool                   Sample(simb::MCTruth &truth, 
 				  simb::MCFlux  &flux,
 				  simb::GTruth  &gtruth);
+
+    // Optional: serialize the genie::EventRecord of the last Sample()
+    // for reweighting without reconstruction (see simb::GHEPRecord)
+    bool                   PackGHEPRecord(simb::GHEPRecord &ghep);
+
+    // Pre-fork worker mode: call in each child process forked after
+    // Initialize().  Gives the worker its own file offsets for the open
+    // files and, unless UseRNGStreams is set (the per event seeds then
+    // already differ), a random seed of its own.  With ntuple or
+    // simple_flux fluxes worker iworker of nworkers reloads the driver
+    // with its own block of SelectedFluxFiles(), so no two workers read
+    // the same flux entries; throws if there are fewer files than workers
+    void                   InitializeWorker(unsigned int iworker,
+					    unsigned int nworkers);
+
+    // Reseed GENIEHelper and GENIE (including the flux drivers that use
+    // genie::RandomGen) from the counter based stream for this event.
+    // Only has an effect if UseRNGStreams is set.  The generator module
+    // must call it with the art event's run, subrun and event numbers
+    // before every Sample(); genieforkgen does so for its workers.
+    // genie::RandomGen is one per process, so Sample() throws if another
+    // GENIEHelper reseeded it in between, or if it was never called.
+    // UseRNGStreams covers the histogram, mono and atmospheric fluxes;
+    // it is refused for ntuple and simple_flux, whose drivers read their
+    // entries in sequence (see RNGStream.h)
+    void                   SetEventID(unsigned int run,
+				      unsigned int subrun,
+				      unsigned int event);
      
     double                 TotalHistFlux();
     double                 TotalExposure()    const { return fTotalExposure;  }
@@ -65,7 +100,20 @@ namespace evgb{
     // will be reset to 0
     double                 SpillExposure()    const { return fSpillExposure;  }
     std::string            FluxType()         const { return fFluxType;       }
+    // with WeightedEvents every interaction carries its probability in
+    // GTruth::fweight; the sum of weights per exposure is the rate
+    bool                   WeightedEvents()   const { return fWeightedEvents; }
     std::string            DetectorLocation() const { return fDetLocation;    }
+
+    // ordered list of flux files given to the flux driver, needed to
+    // build an evgb::FluxMaterializer when running with FluxRefMode
+    const std::vector<std::string>& SelectedFluxFiles() const { return fSelectedFluxFiles; }
+
+    // with FluxRefMode the MCFlux objects refer to entries of these files;
+    // put a copy in the SubRun so the references can be resolved later.
+    // FluxRefMode is for ntuple and simple_flux fluxes only (see
+    // FluxMaterializer.h)
+    const simb::MCFluxFiles&        FluxFileList()      const { return fFluxFileList;      }
     
     // methods for checking the various algorithms in GENIEHelper - please
     // do not use these in your code!!!!!
@@ -82,6 +130,8 @@ namespace evgb{
     void InitializeFluxDriver();
     void ConfigGeomScan();
     void SetMaxPathOutInfo();
+    double ExposureScale() const;
+    void SetFluxReference(long long chainEntry, simb::MCFlux &flux);
     void PackNuMIFlux(simb::MCFlux &flux);
     void PackSimpleFlux(simb::MCFlux &flux);
     void PackMCTruth(genie::EventRecord *record, simb::MCTruth &truth);
@@ -97,6 +147,15 @@ namespace evgb{
     void StartGENIEMessenger(std::string prodmode);
     void FindEventGeneratorList();
     void ReadXSecTable();
+    void LoadXSecTable();
+
+    // startup phases: run fn as phase "name", on its own thread if
+    // thread is non-null, recording its wall time
+    template <class F> void RunInitPhase(std::string const& name, F fn,
+                                         std::thread** thread = 0,
+                                         std::exception_ptr* error = 0);
+    void JoinInitPhase(std::thread*& thread, std::exception_ptr& error);
+    void ReportInitPhases();
 
     TGeoManager*             fGeoManager;        ///< pointer to ROOT TGeoManager
     std::string              fGeoFile;           ///< name of file containing the Geometry description
@@ -105,12 +164,16 @@ namespace evgb{
     genie::GeomAnalyzerI*    fGeomD;       
     genie::GFluxI*           fFluxD;             ///< real flux driver
     genie::GFluxI*           fFluxD2GMCJD;       ///< flux driver passed to genie GMCJDriver, might be GFluxBlender
+                                                 ///< or FluxPreselector
+    FluxPreselector*         fFluxPreselector;   ///< cuts on flux quantities before GMCJDriver, null if none
+    fhicl::ParameterSet      fFluxPreselection;  ///< configuration of fFluxPreselector, empty if none
     genie::GMCJDriver*       fDriver;
 
     ifdh_ns::ifdh*           fIFDH;              ///< (optional) flux file handling
 
     TRandom3*                fHelperRandom;      ///< random # generator for GENIEHelper
     bool                     fUseHelperRndGen4GENIE;   ///< use fHelperRandom for gRandom during Sample()
+    RNGStream*               fRNGStream;         ///< per event reseeding stream, null unless UseRNGStreams
 
     std::string              fFluxType;          ///< histogram or ntuple or atmo_FLUKA or atmo_BARTOL
     std::string              fFluxSearchPaths;   ///< colon separated set of path stems
@@ -119,6 +182,9 @@ namespace evgb{
     int                      fMaxFluxFileMB;     ///< maximum size of flux files (MB)
     std::string              fFluxCopyMethod;    ///< "DIRECT" = old direct access method, otherwise = ifdh approach schema ("" okay)
     std::string              fFluxCleanup;       ///< "ALWAYS", "/var/tmp", "NEVER"
+    bool                     fFluxRefMode;       ///< store only a reference to the flux entry in MCFlux
+    simb::MCFluxFiles        fFluxFileList;      ///< files the FluxRefMode references point into
+    bool                     fWeightedEvents;    ///< force every flux neutrino to interact, weight = probability
     std::string              fBeamName;          ///< name of the beam we are simulating
     std::string              fTopVolume;         ///< top volume in the ROOT geometry in which to generate events
     std::string              fWorldVolume;       ///< name of the world volume in the ROOT geometry
@@ -152,6 +218,7 @@ namespace evgb{
                                                  ///< where the neutrinos are generated
     std::vector<std::string> fEnvironment;       ///< environmental variables and settings used by genie
     std::string              fXSecTable;         ///< cross section file (was $GSPLOAD)
+    std::string              fXSecTrimCache;     ///< directory of spline files trimmed to the geometry and generator list
     std::string              fEventGeneratorList;///< control over event topologies, was $GEVGL [Default]
     std::string              fGXMLPATH;          ///< locations for GENIE XML files
     std::string              fGMSGLAYOUT;        ///< format for GENIE log message [BASIC]|SIMPLE (SIMPLE=no timestamps)
@@ -160,9 +227,15 @@ namespace evgb{
     std::string              fMixerConfig;       ///< configuration string for genie GFlavorMixerI
     double                   fMixerBaseline;     ///< baseline distance if genie flux can't calculate it
     std::string              fFiducialCut;       ///< configuration for geometry selector
+    int                      fFiducialVoxels;    ///< voxels per dimension used to accelerate the fiducial cut
     std::string              fGeomScan;          ///< configuration for geometry scan to determine max pathlengths
     std::string              fMaxPathOutInfo;    ///< output info if writing PathLengthList from GeomScan
     unsigned int             fDebugFlags;        ///< set bits to enable debug info
+    bool                     fConcurrentInit;    ///< stage the flux files with IFDH while the splines are read
+    std::mutex               fInitPhaseMutex;    ///< guards fInitPhases
+    std::vector< std::pair<std::string,double> > fInitPhases; ///< wall time (s) of each startup phase
+    double                   fInitWallTime;      ///< wall time (s) spent in the ctor and Initialize()
+    int                      fRandomSeed;        ///< seed of fHelperRandom and GENIE, base for worker seeds
   };
 }
 #endif //EVGB_GENIEHELPER_H
@@ -0,0 +1,203 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  XSecSplineTrimmer.cxx
+/// \brief Extract the cross section splines a detector actually needs
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <functional>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// ROOT includes
+#include "TGeoManager.h"
+#include "TGeoMaterial.h"
+#include "TMath.h"
+#include "TStopwatch.h"
+
+// GENIE includes
+#include "EVGCore/EventGeneratorI.h"
+#include "EVGCore/InteractionList.h"
+#include "EVGCore/XSecSplineList.h"
+#include "EVGDrivers/GEVGDriver.h"
+#include "Interaction/InitialState.h"
+#include "Interaction/Interaction.h"
+#include "PDG/PDGUtils.h"
+
+// Framework includes
+#include "cetlib/exception.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+// NuTools includes
+#include "EventGeneratorBase/GENIE/XSecSplineTrimmer.h"
+
+namespace evgb {
+
+  //--------------------------------------------------
+  XSecSplineTrimmer::XSecSplineTrimmer(std::string      const& eventGeneratorList,
+				       std::vector<int> const& flavors)
+    : fEventGeneratorList(eventGeneratorList)
+    , fFlavors(flavors.begin(), flavors.end())
+  {
+  }
+
+  //--------------------------------------------------
+  void XSecSplineTrimmer::AddTargets(TGeoManager* geom)
+  {
+    // same A, Z rounding as ROOTGeomAnalyzer::GetTargetPdgCode()
+    TIter next(geom->GetListOfMaterials());
+    while ( TGeoMaterial* mat = dynamic_cast<TGeoMaterial*>(next()) ) {
+      if ( mat->IsMixture() ) {
+	TGeoMixture* mix = dynamic_cast<TGeoMixture*>(mat);
+	for ( int i = 0; i < mix->GetNelements(); ++i ) {
+	  int A = TMath::Nint(mix->GetAmixt()[i]);
+	  int Z = TMath::Nint(mix->GetZmixt()[i]);
+	  if ( Z > 0 ) fTargets.insert(genie::pdg::IonPdgCode(A, Z));
+	}
+      }
+      else {
+	int A = TMath::Nint(mat->GetA());
+	int Z = TMath::Nint(mat->GetZ());
+	if ( Z > 0 ) fTargets.insert(genie::pdg::IonPdgCode(A, Z));
+      }
+    }
+  }
+
+  //--------------------------------------------------
+  std::set<std::string> XSecSplineTrimmer::SplineKeys() const
+  {
+    // the interactions and cross section algorithms GMCJDriver will use
+    // come from one GEVGDriver per initial state, configured the same way
+    genie::XSecSplineList* xsl = genie::XSecSplineList::Instance();
+    std::set<std::string> keys;
+    for ( std::set<int>::const_iterator nu = fFlavors.begin(); nu != fFlavors.end(); ++nu ) {
+      for ( std::set<int>::const_iterator tgt = fTargets.begin(); tgt != fTargets.end(); ++tgt ) {
+	genie::InitialState init(*tgt, *nu);
+	genie::GEVGDriver driver;
+	driver.SetEventGeneratorList(fEventGeneratorList);
+	driver.Configure(init);
+
+	const genie::InteractionList* ilist = driver.Interactions();
+	if ( !ilist ) continue;
+	genie::InteractionList::const_iterator iitr = ilist->begin();
+	for ( ; iitr != ilist->end(); ++iitr ) {
+	  const genie::EventGeneratorI* evgen = driver.FindGenerator(*iitr);
+	  if ( !evgen ) continue;
+	  keys.insert(xsl->BuildSplineKey(evgen->CrossSectionAlg(), *iitr));
+	}
+      }
+    }
+    return keys;
+  }
+
+  //--------------------------------------------------
+  int XSecSplineTrimmer::Trim(std::string const& splineFile,
+			      std::string const& trimmedFile) const
+  {
+    TStopwatch ttime;
+    ttime.Start();
+
+    std::set<std::string> keys = this->SplineKeys();
+
+    std::ifstream in(splineFile.c_str());
+    if ( !in )
+      throw cet::exception("XSecSplineTrimmer") << "can't read spline file " << splineFile;
+    std::ofstream out(trimmedFile.c_str());
+    if ( !out )
+      throw cet::exception("XSecSplineTrimmer") << "can't write trimmed spline file " << trimmedFile;
+
+    // GENIE writes one <spline name="..." nknots="..."> per line,
+    // followed by its knots and a closing </spline>; everything outside
+    // the spline elements is copied as is
+    int nkept = 0, ndropped = 0;
+    bool inSpline = false, keep = true;
+    std::set<std::string> found;
+    std::string line;
+    while ( std::getline(in, line) ) {
+      if ( !inSpline && line.find("<spline ") != std::string::npos ) {
+	inSpline = true;
+	size_t b = line.find("name=\"");
+	std::string name;
+	if ( b != std::string::npos ) {
+	  b += 6;
+	  name = line.substr(b, line.find('"', b) - b);
+	}
+	keep = ( keys.count(name) > 0 );
+	if ( keep ) { ++nkept; found.insert(name); }
+	else        ++ndropped;
+      }
+      if ( !inSpline || keep ) out << line << '\n';
+      if ( inSpline && line.find("</spline>") != std::string::npos ) inSpline = false;
+    }
+    out.close();
+    if ( !out )
+      throw cet::exception("XSecSplineTrimmer") << "failed writing " << trimmedFile;
+
+    ttime.Stop();
+    mf::LogInfo("XSecSplineTrimmer")
+      << "kept " << nkept << " of " << nkept + ndropped << " splines of "
+      << splineFile << " for " << fFlavors.size() << " flavors, "
+      << fTargets.size() << " nuclei and EventGeneratorList \""
+      << fEventGeneratorList << "\" -> " << trimmedFile
+      << " (" << ttime.RealTime() << " s)";
+    if ( found.size() < keys.size() ) {
+      // GEVGDriver::UseSplines() then falls back to computing these
+      mf::LogWarning("XSecSplineTrimmer")
+	<< keys.size() - found.size() << " of the " << keys.size()
+	<< " needed splines are not in " << splineFile;
+    }
+    return nkept;
+  }
+
+  //--------------------------------------------------
+  std::string XSecSplineTrimmer::CacheFileName(std::string const& splineFile,
+					       std::string const& cacheDir) const
+  {
+    std::ostringstream inputs;
+    inputs << splineFile;
+    struct stat st;
+    if ( stat(splineFile.c_str(), &st) == 0 )
+      inputs << ' ' << st.st_size << ' ' << st.st_mtime;
+    inputs << ' ' << fEventGeneratorList << " nu";
+    for ( std::set<int>::const_iterator i = fFlavors.begin(); i != fFlavors.end(); ++i ) inputs << ' ' << *i;
+    inputs << " tgt";
+    for ( std::set<int>::const_iterator i = fTargets.begin(); i != fTargets.end(); ++i ) inputs << ' ' << *i;
+
+    std::string base = splineFile.substr(splineFile.find_last_of('/') + 1);
+    if ( base.size() > 4 && base.compare(base.size() - 4, 4, ".xml") == 0 )
+      base.erase(base.size() - 4);
+
+    std::ostringstream name;
+    name << cacheDir << "/" << base << ".trim."
+	 << std::hex << std::setw(16) << std::setfill('0')
+	 << std::hash<std::string>()(inputs.str()) << ".xml";
+    return name.str();
+  }
+
+  //--------------------------------------------------
+  std::string XSecSplineTrimmer::TrimToCache(std::string const& splineFile,
+					     std::string const& cacheDir) const
+  {
+    std::string trimmed = this->CacheFileName(splineFile, cacheDir);
+    if ( access(trimmed.c_str(), R_OK) == 0 ) {
+      mf::LogInfo("XSecSplineTrimmer") << "using cached trimmed splines " << trimmed;
+      return trimmed;
+    }
+
+    // write under a private name and rename, so concurrent jobs sharing
+    // the cache never read a partial file
+    std::ostringstream tmp;
+    tmp << trimmed << ".tmp" << getpid();
+    this->Trim(splineFile, tmp.str());
+    if ( std::rename(tmp.str().c_str(), trimmed.c_str()) != 0 ) {
+      std::remove(tmp.str().c_str());
+      throw cet::exception("XSecSplineTrimmer")
+	<< "can't move trimmed splines to " << trimmed;
+    }
+    return trimmed;
+  }
+
+}
@@ -0,0 +1,67 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  XSecSplineTrimmer.h
+/// \brief Extract the cross section splines a detector actually needs
+///
+/// A GENIE spline file covers every nucleus and every process of a
+/// tune, but a job only ever asks for the splines of the (neutrino,
+/// target) pairs of its flux and geometry and the processes of its
+/// EventGeneratorList.  XSecSplineTrimmer collects the target nuclei
+/// from the TGeoManager materials (as genie::geometry::ROOTGeomAnalyzer
+/// does), configures a genie::GEVGDriver for every (flavor, nucleus)
+/// pair to learn the spline keys GMCJDriver will look up, and copies
+/// just those <spline> elements of the full file into a trimmed one.
+///
+/// TrimToCache() names the trimmed file after a hash of its inputs
+/// (spline file, its size and time stamp, generator list, flavors and
+/// nuclei), so it is written once and reused by later jobs with the
+/// same configuration.
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#ifndef EVGB_XSECSPLINETRIMMER_H
+#define EVGB_XSECSPLINETRIMMER_H
+
+#include <set>
+#include <string>
+#include <vector>
+
+class TGeoManager;
+
+namespace evgb {
+
+  class XSecSplineTrimmer {
+  public:
+    XSecSplineTrimmer(std::string      const& eventGeneratorList,
+		      std::vector<int> const& flavors);
+
+    /// add the nuclei of all materials of the geometry
+    void                         AddTargets(TGeoManager* geom);
+    void                         AddTarget(int pdg) { fTargets.insert(pdg); }
+    const std::set<int>&         Targets() const    { return fTargets;      }
+
+    /// keys (genie::XSecSplineList::BuildSplineKey) of the splines needed
+    std::set<std::string>        SplineKeys() const;
+
+    /// copy the needed splines of splineFile into trimmedFile,
+    /// returns the number of splines copied
+    int                          Trim(std::string const& splineFile,
+				      std::string const& trimmedFile) const;
+
+    /// name of the trimmed file for splineFile in cacheDir
+    std::string                  CacheFileName(std::string const& splineFile,
+					       std::string const& cacheDir) const;
+
+    /// trim splineFile into cacheDir unless already there, returns the
+    /// name of the trimmed file
+    std::string                  TrimToCache(std::string const& splineFile,
+					     std::string const& cacheDir) const;
+
+  private:
+
+    std::string      fEventGeneratorList;  ///< GENIE EventGeneratorList
+    std::set<int>    fFlavors;             ///< neutrino pdg codes
+    std::set<int>    fTargets;             ///< nucleus pdg codes
+  };
+
+}
+#endif // EVGB_XSECSPLINETRIMMER_H
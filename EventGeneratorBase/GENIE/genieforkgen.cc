@@ -0,0 +1,285 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  genieforkgen.cc
+/// \brief Pre-fork GENIE generation: initialize once, generate in N workers
+///
+/// Every GENIE job on a node normally repeats GENIEHelper's startup and
+/// holds its own copy of the splines, geometry and flux chains.  This
+/// driver builds one evgb::GENIEHelper, runs Initialize() and then
+/// forks the workers, so the (read only) splines, geometry and flux
+/// tables are shared between them copy-on-write:
+///
+///   genieforkgen -c genie.fcl -g detector.gdml -o out [-n nworkers]
+///                [-r run] [-s firstsubrun] [-S nsubruns] [-e spills]
+///                [-m detectormass_kg] [-t table]
+///
+/// The GENIEHelper parameters are the table (default "generator") of the
+/// fcl file, found along FHICL_FILE_PATH.  The nsubruns subruns starting
+/// at firstsubrun are divided into contiguous blocks, one per worker,
+/// and worker i writes out.w<i>.root with the trees
+///   gen       : one entry per spill (run, subrun, event, MCTruth, MCFlux,
+///               GTruth vectors)
+///   subruns   : one entry per subrun with its exposure (POT)
+///   fluxfiles : the flux files the worker read
+/// Each worker calls GENIEHelper::InitializeWorker() to get its own file
+/// offsets, random seed and, for ntuple fluxes, its own block of flux
+/// files; with UseRNGStreams every spill is reseeded from its (run,
+/// subrun, event).  Once all workers are done the fluxfiles trees are
+/// compared and the job fails if two workers read the same flux file.
+///
+/// GENIEHelper joins its startup thread before its constructor returns
+/// and the message facility runs single threaded here, so no thread is
+/// running when the workers are forked.
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+// ROOT includes
+#include "TFile.h"
+#include "TTree.h"
+#include "TGeoManager.h"
+#include "TSystem.h"
+#include "TROOT.h"
+#include "Cintex/Cintex.h"
+
+// Framework includes
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/make_ParameterSet.h"
+#include "cetlib/filepath_maker.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+// NuTools includes
+#include "SimulationBase/MCTruth.h"
+#include "SimulationBase/MCFlux.h"
+#include "SimulationBase/GTruth.h"
+#include "EventGeneratorBase/GENIE/GENIEHelper.h"
+
+namespace {
+
+  //......................................................................
+  void Usage()
+  {
+    std::cerr << "usage: genieforkgen -c genie.fcl -g geometry.gdml -o out [-n nworkers]\n"
+              << "                    [-r run] [-s firstsubrun] [-S nsubruns] [-e spills]\n"
+              << "                    [-m detectormass_kg] [-t table]"
+              << std::endl;
+    std::exit(1);
+  }
+
+  //......................................................................
+  /// Generate the subruns [first, last) into outname
+  void Generate(evgb::GENIEHelper& helper, std::string const& outname,
+                unsigned int run, unsigned int first, unsigned int last,
+                unsigned int spills)
+  {
+    TFile out(outname.c_str(), "RECREATE");
+    TTree* gen     = new TTree("gen",     "GENIE interactions per spill");
+    TTree* subruns = new TTree("subruns", "exposure per subrun");
+
+    UInt_t   brun = run, bsubrun = 0, bevent = 0;
+    Double_t pot  = 0.;
+    std::vector<simb::MCTruth>* truths = new std::vector<simb::MCTruth>;
+    std::vector<simb::MCFlux>*  fluxes = new std::vector<simb::MCFlux>;
+    std::vector<simb::GTruth>*  gtruths = new std::vector<simb::GTruth>;
+
+    gen->Branch("run",    &brun,    "run/i");
+    gen->Branch("subrun", &bsubrun, "subrun/i");
+    gen->Branch("event",  &bevent,  "event/i");
+    gen->Branch("truth",  &truths);
+    gen->Branch("flux",   &fluxes);
+    gen->Branch("gtruth", &gtruths);
+    subruns->Branch("run",    &brun,    "run/i");
+    subruns->Branch("subrun", &bsubrun, "subrun/i");
+    subruns->Branch("pot",    &pot,     "pot/D");
+
+    for (unsigned int subrun = first; subrun < last; ++subrun) {
+      double exposure0 = helper.TotalExposure();
+      bsubrun = subrun;
+
+      for (unsigned int event = 1; event <= spills; ++event) {
+        bevent = event;
+        truths ->clear();
+        fluxes ->clear();
+        gtruths->clear();
+
+        helper.SetEventID(run, subrun, event);
+        while ( !helper.Stop() ) {
+          simb::MCTruth truth;
+          simb::MCFlux  flux;
+          simb::GTruth  gtruth;
+          if ( helper.Sample(truth, flux, gtruth) ) {
+            truths ->push_back(truth);
+            fluxes ->push_back(flux);
+            gtruths->push_back(gtruth);
+          }
+        }
+        gen->Fill();
+      }
+
+      pot = helper.TotalExposure() - exposure0;
+      subruns->Fill();
+    }
+
+    TTree* fluxfiles = new TTree("fluxfiles", "flux files read by this worker");
+    std::string* fluxfile = new std::string;
+    fluxfiles->Branch("file", &fluxfile);
+    std::vector<std::string> const& files = helper.SelectedFluxFiles();
+    for (size_t i = 0; i < files.size(); ++i) {
+      *fluxfile = files[i];
+      fluxfiles->Fill();
+    }
+
+    out.Write();
+    out.Close();
+    delete fluxfile;
+    delete truths;
+    delete fluxes;
+    delete gtruths;
+  }
+
+  //......................................................................
+  /// Check that no flux file was read by more than one worker
+  bool FluxFilesDisjoint(std::vector<std::string> const& outnames)
+  {
+    std::map<std::string, size_t> reader;
+    bool disjoint = true;
+    for (size_t iw = 0; iw < outnames.size(); ++iw) {
+      TFile in(outnames[iw].c_str());
+      TTree* fluxfiles = dynamic_cast<TTree*>(in.Get("fluxfiles"));
+      if (!fluxfiles) {
+        std::cerr << "genieforkgen: no fluxfiles tree in " << outnames[iw] << std::endl;
+        disjoint = false;
+        continue;
+      }
+      std::string* fluxfile = 0;
+      fluxfiles->SetBranchAddress("file", &fluxfile);
+      for (Long64_t i = 0; i < fluxfiles->GetEntries(); ++i) {
+        fluxfiles->GetEntry(i);
+        std::map<std::string, size_t>::iterator itr = reader.find(*fluxfile);
+        if (itr != reader.end() && itr->second != iw) {
+          std::cerr << "genieforkgen: workers " << itr->second << " and " << iw
+                    << " both read flux file " << *fluxfile << std::endl;
+          disjoint = false;
+        }
+        reader[*fluxfile] = iw;
+      }
+      fluxfiles->ResetBranchAddresses();
+      delete fluxfile;
+    }
+    return disjoint;
+  }
+
+}
+
+//......................................................................
+int main(int argc, char** argv)
+{
+  std::string  config, gdml, outstem;
+  std::string  table    = "generator";
+  int          nworkers = 1;
+  unsigned int run      = 1;
+  unsigned int first    = 1;
+  unsigned int nsubruns = 1;
+  unsigned int spills   = 100;
+  double       mass     = 0.;
+
+  for (int i = 1; i < argc; ++i) {
+    if      (std::strcmp(argv[i], "-c") == 0 && i+1 < argc) config   = argv[++i];
+    else if (std::strcmp(argv[i], "-g") == 0 && i+1 < argc) gdml     = argv[++i];
+    else if (std::strcmp(argv[i], "-o") == 0 && i+1 < argc) outstem  = argv[++i];
+    else if (std::strcmp(argv[i], "-t") == 0 && i+1 < argc) table    = argv[++i];
+    else if (std::strcmp(argv[i], "-n") == 0 && i+1 < argc) nworkers = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "-r") == 0 && i+1 < argc) run      = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "-s") == 0 && i+1 < argc) first    = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "-S") == 0 && i+1 < argc) nsubruns = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "-e") == 0 && i+1 < argc) spills   = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "-m") == 0 && i+1 < argc) mass     = std::atof(argv[++i]);
+    else                                                    Usage();
+  }
+  if (config.empty() || gdml.empty() || outstem.empty()) Usage();
+  if (nworkers < 1) nworkers = 1;
+  if ((unsigned int)nworkers > nsubruns) nworkers = nsubruns;
+
+  // single threaded message facility: nothing running in the background
+  // when forking
+  mf::StartMessageFacility(mf::MessageFacilityService::SingleThread,
+                           mf::MessageFacilityService::logConsole());
+
+  gROOT->SetBatch(true);
+  ROOT::Cintex::Cintex::Enable();
+  gSystem->Load("libSimulationBase_dict");
+
+  fhicl::ParameterSet pset;
+  cet::filepath_lookup lookup("FHICL_FILE_PATH");
+  fhicl::make_ParameterSet(config, lookup, pset);
+
+  TGeoManager* geom = TGeoManager::Import(gdml.c_str());
+  if (!geom) {
+    std::cerr << "genieforkgen: could not load geometry " << gdml << std::endl;
+    return 1;
+  }
+
+  evgb::GENIEHelper helper(pset.get<fhicl::ParameterSet>(table), geom, gdml, mass);
+  helper.Initialize();
+
+  std::vector<pid_t>       pids;
+  std::vector<std::string> outnames;
+  for (int iw = 0; iw < nworkers; ++iw) {
+    unsigned int wfirst = first + (unsigned long)nsubruns*iw/nworkers;
+    unsigned int wlast  = first + (unsigned long)nsubruns*(iw+1)/nworkers;
+    std::stringstream outname;
+    outname << outstem << ".w" << iw << ".root";
+
+    std::cout.flush();
+    std::fflush(0);
+    pid_t pid = fork();
+    if (pid < 0) {
+      std::perror("genieforkgen: fork");
+      return 1;
+    }
+    if (pid == 0) {
+      int status = 0;
+      try {
+        helper.InitializeWorker(iw, nworkers);
+        Generate(helper, outname.str(), run, wfirst, wlast, spills);
+        std::cout << "genieforkgen: worker " << iw << " subruns [" << wfirst << ","
+                  << wlast << ") " << helper.TotalExposure() << " POT -> "
+                  << outname.str() << std::endl;
+      }
+      catch (std::exception const& e) {
+        std::cerr << "genieforkgen: worker " << iw << ": " << e.what() << std::endl;
+        status = 1;
+      }
+      std::cout.flush();
+      std::fflush(0);
+      _exit(status);
+    }
+    pids.push_back(pid);
+    outnames.push_back(outname.str());
+  }
+
+  int nfailed = 0;
+  for (size_t iw = 0; iw < pids.size(); ++iw) {
+    int status = 0;
+    waitpid(pids[iw], &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      std::cerr << "genieforkgen: worker " << iw << " failed" << std::endl;
+      ++nfailed;
+    }
+  }
+
+  if (nfailed != 0) return 1;
+
+  // the workers must not have shared flux entries
+  return FluxFilesDisjoint(outnames) ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  genietrimxsec.cc
+/// \brief Trim a GENIE spline file to the nuclei of a geometry
+///
+///   genietrimxsec -g detector.gdml -x gxspl.xml -o trimmed.xml
+///                 [-l EventGeneratorList] [-f 14,-14,12,-12]
+///
+/// Keeps only the splines GENIEHelper would look up for the materials
+/// of the geometry, the flavors given (default 12,-12,14,-14) and the
+/// EventGeneratorList (default "Default"), see evgb::XSecSplineTrimmer.
+/// The output can be used as XSecTable; GENIEHelper does the same
+/// itself when XSecTrimCache is set.
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ROOT includes
+#include "TGeoManager.h"
+#include "TROOT.h"
+
+// Framework includes
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+// NuTools includes
+#include "EventGeneratorBase/GENIE/XSecSplineTrimmer.h"
+
+namespace {
+
+  //......................................................................
+  void Usage()
+  {
+    std::cerr << "usage: genietrimxsec -g geometry.gdml -x gxspl.xml -o trimmed.xml\n"
+              << "                     [-l EventGeneratorList] [-f 14,-14,12,-12]"
+              << std::endl;
+    std::exit(1);
+  }
+
+}
+
+//......................................................................
+int main(int argc, char** argv)
+{
+  std::string gdml, splines, outname;
+  std::string evgl    = "Default";
+  std::string flavors = "12,-12,14,-14";
+
+  for (int i = 1; i < argc; ++i) {
+    if      (std::strcmp(argv[i], "-g") == 0 && i+1 < argc) gdml    = argv[++i];
+    else if (std::strcmp(argv[i], "-x") == 0 && i+1 < argc) splines = argv[++i];
+    else if (std::strcmp(argv[i], "-o") == 0 && i+1 < argc) outname = argv[++i];
+    else if (std::strcmp(argv[i], "-l") == 0 && i+1 < argc) evgl    = argv[++i];
+    else if (std::strcmp(argv[i], "-f") == 0 && i+1 < argc) flavors = argv[++i];
+    else                                                    Usage();
+  }
+  if (gdml.empty() || splines.empty() || outname.empty()) Usage();
+
+  std::vector<int> pdgs;
+  std::stringstream fs(flavors);
+  std::string pdg;
+  while (std::getline(fs, pdg, ',')) pdgs.push_back(std::atoi(pdg.c_str()));
+
+  mf::StartMessageFacility(mf::MessageFacilityService::SingleThread,
+                           mf::MessageFacilityService::logConsole());
+  gROOT->SetBatch(true);
+
+  TGeoManager* geom = TGeoManager::Import(gdml.c_str());
+  if (!geom) {
+    std::cerr << "genietrimxsec: could not load geometry " << gdml << std::endl;
+    return 1;
+  }
+
+  try {
+    evgb::XSecSplineTrimmer trimmer(evgl, pdgs);
+    trimmer.AddTargets(geom);
+    int nkept = trimmer.Trim(splines, outname);
+    std::cout << "genietrimxsec: " << nkept << " splines for "
+              << trimmer.Targets().size() << " nuclei -> " << outname << std::endl;
+  }
+  catch (std::exception const& e) {
+    std::cerr << "genietrimxsec: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,188 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  FiducialVoxelSelector_test.cc
+/// \brief evgb::FiducialVoxelSelector against the exact fiducial cut
+///
+/// Builds a simple geometry (an argon gas world holding a liquid argon
+/// detector made of slabs along z) and, for each fiducial shape
+/// GENIEHelper supports and both senses of the cut, computes the path
+/// lengths of the same random rays through two ROOTGeomAnalyzers: one
+/// with GENIE's GeomVolSelectorFiducial and one with the voxel
+/// accelerated selector.  The path lengths must agree, and the voxel
+/// selector must have decided some segments without the exact test.
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// ROOT includes
+#include "TGeoManager.h"
+#include "TGeoMaterial.h"
+#include "TGeoMedium.h"
+#include "TGeoVolume.h"
+#include "TGeoBBox.h"
+#include "TGeoMatrix.h"
+#include "TLorentzVector.h"
+#include "TRandom3.h"
+#include "TVector3.h"
+
+// GENIE includes
+#include "Conventions/Units.h"
+#include "Geo/ROOTGeomAnalyzer.h"
+#include "Geo/GeomVolSelectorFiducial.h"
+#include "Geo/PathLengthList.h"
+
+// Framework includes
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+// NuTools includes
+#include "EventGeneratorBase/GENIE/FiducialVoxelSelector.h"
+
+namespace {
+
+  const int kNRays = 2000;
+
+  /// gas world, 12 liquid argon slabs of 100 cm along z in the detector
+  TGeoManager* MakeGeometry()
+  {
+    TGeoManager*  geom   = new TGeoManager("fidtest", "fiducial voxel test");
+    TGeoMaterial* gasMat = new TGeoMaterial("ArGas", 39.95, 18, 1.7e-3);
+    TGeoMaterial* larMat = new TGeoMaterial("LAr",   39.95, 18, 1.39);
+    TGeoMedium*   gas    = new TGeoMedium("ArGas", 1, gasMat);
+    TGeoMedium*   lar    = new TGeoMedium("LAr",   2, larMat);
+
+    TGeoVolume* world = geom->MakeBox("volWorld",    gas, 1000., 1000., 1000.);
+    TGeoVolume* det   = geom->MakeBox("volDetector", lar,  300.,  300.,  600.);
+    TGeoVolume* slab  = geom->MakeBox("volSlab",     lar,  300.,  300.,   50.);
+    for (int i = 0; i < 12; ++i)
+      det->AddNode(slab, i, new TGeoTranslation(0., 0., -550. + 100.*i));
+    world->AddNode(det, 1);
+    geom->SetTopVolume(world);
+    geom->CloseGeometry();
+
+    return geom;
+  }
+
+  genie::geometry::ROOTGeomAnalyzer* MakeAnalyzer(TGeoManager* geom)
+  {
+    genie::geometry::ROOTGeomAnalyzer* rgeom = new genie::geometry::ROOTGeomAnalyzer(geom);
+    rgeom->SetLengthUnits(genie::units::centimeter);
+    rgeom->SetDensityUnits(genie::units::gram_centimeter3);
+    rgeom->SetTopVolName("volWorld");
+    return rgeom;
+  }
+
+  /// make the shape on a selector the way GENIEHelper does
+  void MakeShape(genie::geometry::GeomVolSelectorFiducial& sel,
+                 std::string const&                        shape,
+                 std::vector<double>&                      vals)
+  {
+    vals.clear();
+    if (shape == "zcyl") {
+      double v[7] = {0., 0., 200., -400., 400., 0., 0.};
+      vals.assign(v, v+7);
+      sel.MakeZCylinder(vals[0], vals[1], vals[2], vals[3], vals[4]);
+    }
+    else if (shape == "box") {
+      double v[7] = {-250., -200., -500., 250., 200., 500., 0.};
+      vals.assign(v, v+7);
+      double xyzmin[3] = {vals[0], vals[1], vals[2]};
+      double xyzmax[3] = {vals[3], vals[4], vals[5]};
+      sel.MakeBox(xyzmin, xyzmax);
+    }
+    else if (shape == "zpoly") {
+      double v[7] = {6., 0., 0., 220., 0., -450., 450.};
+      vals.assign(v, v+7);
+      sel.MakeZPolygon((int)vals[0], vals[1], vals[2], vals[3], vals[4], vals[5], vals[6]);
+    }
+    else if (shape == "sphere") {
+      double v[7] = {0., 0., 0., 280., 0., 0., 0.};
+      vals.assign(v, v+7);
+      sel.MakeSphere(vals[0], vals[1], vals[2], vals[3]);
+    }
+  }
+
+  /// compare the two selectors for one shape and sense of the cut
+  int Compare(TGeoManager* geom, std::string const& shape, bool reverse)
+  {
+    std::vector<double> vals;
+
+    genie::geometry::ROOTGeomAnalyzer*       exactGeom = MakeAnalyzer(geom);
+    genie::geometry::GeomVolSelectorFiducial* exact    = new genie::geometry::GeomVolSelectorFiducial();
+    exact->SetRemoveEntries(true);
+    MakeShape(*exact, shape, vals);
+    exact->SetReverseFiducial(reverse);
+    exactGeom->AdoptGeomVolSelector(exact);
+
+    genie::geometry::ROOTGeomAnalyzer* voxelGeom = MakeAnalyzer(geom);
+    evgb::FiducialVoxelSelector*       voxel     = new evgb::FiducialVoxelSelector();
+    voxel->SetRemoveEntries(true);
+    MakeShape(*voxel, shape, vals);
+    voxel->SetReverseFiducial(reverse);
+    TGeoBBox* bbox = dynamic_cast<TGeoBBox*>(geom->GetTopVolume()->GetShape());
+    TVector3 lo(-bbox->GetDX(), -bbox->GetDY(), -bbox->GetDZ());
+    TVector3 hi( bbox->GetDX(),  bbox->GetDY(),  bbox->GetDZ());
+    voxel->BuildVoxels(shape, vals, false, reverse, voxelGeom, lo, hi, 32);
+    voxelGeom->AdoptGeomVolSelector(voxel);
+
+    // rays from upstream of the world, spread over the detector face
+    TRandom3 rnd(4357);
+    int    nbad  = 0;
+    double worst = 0.;
+    for (int i = 0; i < kNRays; ++i) {
+      TVector3 dir(rnd.Uniform(-0.3, 0.3), rnd.Uniform(-0.3, 0.3), 1.);
+      dir.SetMag(1.);
+      TLorentzVector x4(rnd.Uniform(-400., 400.), rnd.Uniform(-400., 400.), -950., 0.);
+      TLorentzVector p4(dir, 1.);
+
+      // copy, the list is reused by the next call
+      genie::PathLengthList exactPl = exactGeom->ComputePathLengths(x4, p4);
+      genie::PathLengthList voxelPl = voxelGeom->ComputePathLengths(x4, p4);
+
+      bool same = (exactPl.size() == voxelPl.size());
+      genie::PathLengthList::const_iterator itr = exactPl.begin();
+      for ( ; same && itr != exactPl.end(); ++itr) {
+        genie::PathLengthList::const_iterator vitr = voxelPl.find(itr->first);
+        if (vitr == voxelPl.end()) { same = false; break; }
+        double diff = std::abs(vitr->second - itr->second);
+        worst = std::max(worst, diff);
+        if (diff > 1.e-6 + 1.e-9*std::abs(itr->second)) same = false;
+      }
+      if (!same) ++nbad;
+    }
+
+    long nfast = voxel->NFastInside() + voxel->NFastOutside();
+    bool ok    = (nbad == 0 && nfast > 0);
+    std::printf("%-7s %-8s %4d of %d rays differ (worst %g), %ld segments by voxel, %ld exact  %s\n",
+                shape.c_str(), reverse ? "reverse" : "forward", nbad, kNRays, worst,
+                nfast, voxel->NExact(), ok ? "ok" : "FAIL");
+
+    delete exactGeom;
+    delete voxelGeom;
+
+    return ok ? 0 : 1;
+  }
+
+}
+
+//......................................................................
+int main()
+{
+  mf::StartMessageFacility(mf::MessageFacilityService::SingleThread,
+                           mf::MessageFacilityService::logConsole());
+
+  TGeoManager* geom = MakeGeometry();
+
+  const char* shapes[] = {"zcyl", "box", "zpoly", "sphere"};
+
+  int nfail = 0;
+  for (size_t i = 0; i < sizeof(shapes)/sizeof(shapes[0]); ++i) {
+    nfail += Compare(geom, shapes[i], false);
+    nfail += Compare(geom, shapes[i], true);
+  }
+
+  return nfail;
+}
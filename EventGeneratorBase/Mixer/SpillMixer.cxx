@@ -0,0 +1,328 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  SpillMixer.cxx
+/// \brief Build spills by resampling pre-generated event libraries
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+// ROOT includes
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TParameter.h"
+#include "TLorentzVector.h"
+
+// CLHEP includes
+#include "CLHEP/Random/RandFlat.h"
+#include "CLHEP/Random/RandGaussQ.h"
+#include "CLHEP/Random/RandPoissonQ.h"
+
+// Framework includes
+#include "fhiclcpp/ParameterSet.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+#include "cetlib/exception.h"
+
+// NuTools includes
+#include "EventGeneratorBase/Mixer/SpillMixer.h"
+#include "SimulationBase/MCParticle.h"
+#include "SimulationBase/MCNeutrino.h"
+
+namespace evgb {
+
+  //--------------------------------------------------
+  MixLibrary::MixLibrary(fhicl::ParameterSet const& pset)
+    : fName       (pset.get< std::string >("Name")                )
+    , fFileName   (pset.get< std::string >("FileName")            )
+    , fTree       (0)
+    , fNEntries   (0)
+    , fTimeScaled (pset.get< std::string >("Scaling", "POT") == "Time")
+    , fExposure   (pset.get< double      >("Exposure", -1.)       )
+    , fWindowStart(0.)
+    , fWindowEnd  (0.)
+    , fPreload    (pset.get< bool        >("Preload", true)       )
+    , fHasFlux    (false)
+    , fHasGTruth  (false)
+    , fTruthBuf   (0)
+    , fFluxBuf    (0)
+    , fGTruthBuf  (0)
+  {
+    std::string treeName    = pset.get< std::string >("TreeName",      "mixlib" );
+    std::string truthBranch = pset.get< std::string >("MCTruthBranch", "MCTruth");
+    std::string fluxBranch  = pset.get< std::string >("MCFluxBranch",  "MCFlux" );
+    std::string gtBranch    = pset.get< std::string >("GTruthBranch",  "GTruth" );
+
+    if(fTimeScaled){
+      std::vector<double> window = pset.get< std::vector<double> >("TimeWindow");
+      if(window.size() != 2 || window[1] <= window[0])
+	throw cet::exception("MixLibrary") << "library " << fName
+					   << " needs TimeWindow: [start, end] with end > start";
+      fWindowStart = window[0];
+      fWindowEnd   = window[1];
+    }
+
+    fFile.reset(TFile::Open(fFileName.c_str(), "READ"));
+    if(!fFile || fFile->IsZombie())
+      throw cet::exception("MixLibrary") << "cannot open library file " << fFileName;
+
+    fTree = dynamic_cast<TTree*>(fFile->Get(treeName.c_str()));
+    if(!fTree)
+      throw cet::exception("MixLibrary") << "no tree " << treeName << " in " << fFileName;
+
+    fNEntries = fTree->GetEntries();
+    if(fNEntries == 0)
+      throw cet::exception("MixLibrary") << "library " << fName << " is empty";
+
+    // if the exposure was not configured, look for the value the
+    // library producer stored alongside the tree
+    if(fExposure <= 0.){
+      TParameter<double>* exposure = dynamic_cast< TParameter<double>* >(fFile->Get("Exposure"));
+      if(exposure) fExposure = exposure->GetVal();
+    }
+    if(fExposure <= 0.)
+      throw cet::exception("MixLibrary") << "library " << fName
+					 << " has no exposure, set Exposure in the configuration";
+
+    fTree->SetBranchAddress(truthBranch.c_str(), &fTruthBuf);
+    if(!fluxBranch.empty() && fTree->GetBranch(fluxBranch.c_str())){
+      fHasFlux = true;
+      fTree->SetBranchAddress(fluxBranch.c_str(), &fFluxBuf);
+    }
+    if(!gtBranch.empty() && fTree->GetBranch(gtBranch.c_str())){
+      fHasGTruth = true;
+      fTree->SetBranchAddress(gtBranch.c_str(), &fGTruthBuf);
+    }
+
+    if(fPreload){
+      fTruths.reserve(fNEntries);
+      if(fHasFlux)   fFluxes .reserve(fNEntries);
+      if(fHasGTruth) fGTruths.reserve(fNEntries);
+      for(size_t i = 0; i < fNEntries; ++i){
+	this->ReadEntry(i);
+	fTruths.push_back(*fTruthBuf);
+	if(fHasFlux)   fFluxes .push_back(*fFluxBuf);
+	if(fHasGTruth) fGTruths.push_back(*fGTruthBuf);
+      }
+    }
+
+    mf::LogInfo("MixLibrary") << "library " << fName << " from " << fFileName
+			      << ": " << fNEntries << " records, exposure " << fExposure
+			      << (fTimeScaled ? " ns" : " POT")
+			      << (fPreload ? ", preloaded" : ", read on demand");
+  }
+
+  //--------------------------------------------------
+  MixLibrary::~MixLibrary()
+  {
+    if(fFile) fFile->Close();
+
+    // the branch buffers were allocated by ROOT but belong to us
+    delete fTruthBuf;
+    delete fFluxBuf;
+    delete fGTruthBuf;
+  }
+
+  //--------------------------------------------------
+  void MixLibrary::ReadEntry(size_t i)
+  {
+    if(fTree->GetEntry(i) <= 0 || !fTruthBuf)
+      throw cet::exception("MixLibrary") << "failed to read entry " << i
+					 << " of library " << fName;
+  }
+
+  //--------------------------------------------------
+  void MixLibrary::Get(size_t          i,
+		       simb::MCTruth&  truth,
+		       simb::MCFlux&   flux,
+		       simb::GTruth&   gtruth)
+  {
+    if(fPreload){
+      truth = fTruths[i];
+      if(fHasFlux)   flux   = fFluxes[i];
+      if(fHasGTruth) gtruth = fGTruths[i];
+      return;
+    }
+
+    this->ReadEntry(i);
+    truth = *fTruthBuf;
+    if(fHasFlux)   flux   = *fFluxBuf;
+    if(fHasGTruth) gtruth = *fGTruthBuf;
+  }
+
+  //--------------------------------------------------
+  SpillMixer::SpillMixer(fhicl::ParameterSet const& pset,
+			 CLHEP::HepRandomEngine&    engine)
+    : fEngine          (engine)
+    , fPOTPerSpill     (pset.get< double              >("POTPerSpill",      5.e13)                 )
+    , fGlobalTimeOffset(pset.get< double              >("GlobalTimeOffset", 1.e4)                  )
+    , fSpillLength     (pset.get< double              >("SpillLength",      1.e4)                  )
+    , fBunchTimes      (pset.get< std::vector<double> >("BunchTimes",       std::vector<double>()) )
+    , fBunchSigma      (pset.get< double              >("BunchSigma",       0.)                    )
+    , fTotalPOT        (0.)
+    , fNSpills         (0)
+  {
+    std::vector<fhicl::ParameterSet> libs = pset.get< std::vector<fhicl::ParameterSet> >("Libraries");
+    if(libs.empty())
+      throw cet::exception("SpillMixer") << "no libraries configured";
+
+    for(size_t i = 0; i < libs.size(); ++i)
+      fLibraries.push_back(std::unique_ptr<MixLibrary>(new MixLibrary(libs[i])));
+
+    fNDrawn.resize(fLibraries.size(), 0);
+  }
+
+  //--------------------------------------------------
+  SpillMixer::~SpillMixer()
+  {
+    mf::LogInfo log("SpillMixer");
+    log << "mixed " << fNSpills << " spills, " << fTotalPOT << " POT";
+    for(size_t i = 0; i < fLibraries.size(); ++i){
+      log << "\n  " << fLibraries[i]->Name()
+	  << ": drawn " << fNDrawn[i]
+	  << " of "     << fLibraries[i]->Size()
+	  << " (reuse factor " << this->ReuseFactor(i) << ")";
+      if(fLibraries[i]->IsTimeScaled()) log << ", livetime " << this->Livetime(i) << " ns";
+    }
+  }
+
+  //--------------------------------------------------
+  double SpillMixer::Livetime(size_t i) const
+  {
+    MixLibrary const* lib = fLibraries[i].get();
+    if(!lib->IsTimeScaled()) return 0.;
+    return fNSpills * (lib->WindowEnd() - lib->WindowStart());
+  }
+
+  //--------------------------------------------------
+  double SpillMixer::ReuseFactor(size_t i) const
+  {
+    return (1.*fNDrawn[i])/fLibraries[i]->Size();
+  }
+
+  //--------------------------------------------------
+  double SpillMixer::EquivalentExposure(size_t i) const
+  {
+    return this->ReuseFactor(i) * fLibraries[i]->Exposure();
+  }
+
+  //--------------------------------------------------
+  void SpillMixer::Sample(std::vector<simb::MCTruth>& truths,
+			  std::vector<simb::MCFlux>&  fluxes,
+			  std::vector<simb::GTruth>&  gtruths)
+  {
+    truths .clear();
+    fluxes .clear();
+    gtruths.clear();
+
+    for(size_t i = 0; i < fLibraries.size(); ++i){
+      MixLibrary* lib = fLibraries[i].get();
+
+      // the library rate is records per unit exposure, scale it by
+      // the POT in the spill or the length of the time window
+      double scale = lib->IsTimeScaled() ? lib->WindowEnd() - lib->WindowStart() : fPOTPerSpill;
+      double mean  = scale * lib->Size() / lib->Exposure();
+      long   n     = CLHEP::RandPoissonQ::shoot(&fEngine, mean);
+
+      LOG_DEBUG("SpillMixer") << lib->Name() << ": mean " << mean << " drew " << n;
+
+      for(long j = 0; j < n; ++j){
+	size_t idx = CLHEP::RandFlat::shootInt(&fEngine, (long)lib->Size());
+
+	simb::MCTruth truth;
+	simb::MCFlux  flux;
+	simb::GTruth  gtruth;
+	lib->Get(idx, truth, flux, gtruth);
+
+	double t = lib->IsTimeScaled()
+	  ? CLHEP::RandFlat::shoot(&fEngine, lib->WindowStart(), lib->WindowEnd())
+	  : this->SpillTime();
+
+	// find the earliest time of the tracked particles in the record,
+	// that is what lands at the sampled time
+	double tref = std::numeric_limits<double>::max();
+	for(int p = 0; p < truth.NParticles(); ++p){
+	  simb::MCParticle const& part = truth.GetParticle(p);
+	  if(part.StatusCode() != 0 && part.StatusCode() != 1) continue;
+	  if(part.NumberTrajectoryPoints() > 0) tref = std::min(tref, part.T());
+	}
+	if(tref == std::numeric_limits<double>::max()) tref = t;
+
+	simb::MCTruth shifted;
+	this->ShiftTime(truth, shifted, t - tref);
+
+	truths .push_back(shifted);
+	fluxes .push_back(flux);
+	gtruths.push_back(gtruth);
+      }
+
+      fNDrawn[i] += n;
+    }
+
+    fTotalPOT += fPOTPerSpill;
+    ++fNSpills;
+  }
+
+  //--------------------------------------------------
+  double SpillMixer::SpillTime()
+  {
+    if(fBunchTimes.empty())
+      return fGlobalTimeOffset + CLHEP::RandFlat::shoot(&fEngine, fSpillLength);
+
+    size_t bunch = CLHEP::RandFlat::shootInt(&fEngine, (long)fBunchTimes.size());
+    double t     = fGlobalTimeOffset + fBunchTimes[bunch];
+    if(fBunchSigma > 0.) t += CLHEP::RandGaussQ::shoot(&fEngine, 0., fBunchSigma);
+
+    return t;
+  }
+
+  //--------------------------------------------------
+  // MCTruth does not allow its particles to be modified in place, so
+  // rebuild the record with the tracked particles moved by dt.  Only
+  // status 0 and 1 particles carry the spill time, the rest keep the
+  // generator's own coordinates just as GENIEHelper::PackMCTruth does.
+  void SpillMixer::ShiftTime(simb::MCTruth const& in,
+			     simb::MCTruth&       out,
+			     double               dt) const
+  {
+    out.SetOrigin(in.Origin());
+
+    for(int i = 0; i < in.NParticles(); ++i){
+      simb::MCParticle const& part = in.GetParticle(i);
+      bool tracked = (part.StatusCode() == 0 || part.StatusCode() == 1);
+
+      simb::MCParticle p(part.TrackId(),
+			 part.PdgCode(),
+			 part.Process(),
+			 part.Mother(),
+			 part.Mass(),
+			 part.StatusCode());
+
+      for(unsigned int t = 0; t < part.NumberTrajectoryPoints(); ++t){
+	TLorentzVector pos = part.Position(t);
+	if(tracked) pos.SetT(pos.T() + dt);
+	p.AddTrajectoryPoint(pos, part.Momentum(t));
+      }
+      for(int d = 0; d < part.NumberDaughters(); ++d) p.AddDaughter(part.Daughter(d));
+
+      p.SetEndProcess(part.EndProcess());
+      p.SetPolarization(part.Polarization());
+      p.SetGvtx(part.GetGvtx());
+      p.SetRescatter(part.Rescatter());
+      p.SetWeight(part.Weight());
+
+      out.Add(p);
+    }
+
+    if(in.NeutrinoSet()){
+      simb::MCNeutrino const& nu = in.GetNeutrino();
+      out.SetNeutrino(nu.CCNC(), nu.Mode(), nu.InteractionType(),
+		      nu.Target(), nu.HitNuc(), nu.HitQuark(),
+		      nu.W(), nu.X(), nu.Y(), nu.QSqr());
+    }
+
+    return;
+  }
+
+}// namespace
@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  SpillMixer.h
+/// \brief Build spills by resampling pre-generated event libraries
+///
+/// Rather than running GENIEHelper (detector and rock) and CRYHelper
+/// for every spill, the SpillMixer draws records from libraries of
+/// previously generated simb::MCTruth, simb::MCFlux and simb::GTruth
+/// objects.  Each library is a ROOT file holding a TTree with one
+/// entry per interaction (or per cosmic-ray sample) and one branch per
+/// data product; the MCFlux and GTruth branches are optional.
+///
+/// Libraries are either POT-scaled (beam neutrinos, rock) or
+/// time-scaled (cosmic rays).  The number of entries drawn per spill
+/// is Poisson distributed with mean
+///
+///   nentries / exposure * (POT per spill)     for POT-scaled libraries
+///   nentries / exposure * (window length)     for time-scaled libraries
+///
+/// and each drawn record is shifted in time so that its first
+/// particle lands at a time sampled from the spill structure (bunch
+/// times with a gaussian width, or a flat spill) or, for time-scaled
+/// libraries, uniformly within the configured time window.  The
+/// accumulated POT and livetime are tracked so that the mixed sample
+/// carries the same exposure as a full regeneration would.
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#ifndef EVGB_SPILLMIXER_H
+#define EVGB_SPILLMIXER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "SimulationBase/MCTruth.h"
+#include "SimulationBase/MCFlux.h"
+#include "SimulationBase/GTruth.h"
+
+class TFile;
+class TTree;
+
+namespace fhicl { class ParameterSet; }
+namespace CLHEP { class HepRandomEngine; }
+
+namespace evgb {
+
+  /// A single library of pre-generated records
+  class MixLibrary {
+  public:
+    explicit MixLibrary(fhicl::ParameterSet const& pset);
+    ~MixLibrary();
+
+    /// fetch entry i into the supplied objects, flux and gtruth are
+    /// left default constructed if the library has no such branch
+    void Get(size_t          i,
+	     simb::MCTruth&  truth,
+	     simb::MCFlux&   flux,
+	     simb::GTruth&   gtruth);
+
+    std::string const& Name()          const { return fName;          }
+    size_t             Size()          const { return fNEntries;      }
+    bool               IsTimeScaled()  const { return fTimeScaled;    }
+    double             Exposure()      const { return fExposure;      }
+    double             WindowStart()   const { return fWindowStart;   }
+    double             WindowEnd()     const { return fWindowEnd;     }
+    bool               HasFlux()       const { return fHasFlux;       }
+    bool               HasGTruth()     const { return fHasGTruth;     }
+
+  private:
+
+    void ReadEntry(size_t i);
+
+    std::string                fName;          ///< name used in log messages
+    std::string                fFileName;      ///< library file
+    std::unique_ptr<TFile>     fFile;          ///< open library file
+    TTree*                     fTree;          ///< library tree
+    size_t                     fNEntries;      ///< number of records in the library
+    bool                       fTimeScaled;    ///< true: rate per ns, false: rate per POT
+    double                     fExposure;      ///< POT or ns used to generate the library
+    double                     fWindowStart;   ///< start of time window for time-scaled libraries (ns)
+    double                     fWindowEnd;     ///< end of time window for time-scaled libraries (ns)
+    bool                       fPreload;       ///< read the whole library into memory at startup
+    bool                       fHasFlux;       ///< library has an MCFlux branch
+    bool                       fHasGTruth;     ///< library has a GTruth branch
+    simb::MCTruth*             fTruthBuf;      ///< branch buffer for MCTruth
+    simb::MCFlux*              fFluxBuf;       ///< branch buffer for MCFlux
+    simb::GTruth*              fGTruthBuf;     ///< branch buffer for GTruth
+    std::vector<simb::MCTruth> fTruths;        ///< preloaded MCTruth records
+    std::vector<simb::MCFlux>  fFluxes;        ///< preloaded MCFlux records
+    std::vector<simb::GTruth>  fGTruths;       ///< preloaded GTruth records
+  };
+
+  /// Combine neutrino, rock and cosmic-ray libraries into spills
+  class SpillMixer {
+  public:
+    explicit SpillMixer(fhicl::ParameterSet const& pset,
+			CLHEP::HepRandomEngine&    engine);
+    ~SpillMixer();
+
+    /// fill the vectors with one spill worth of records, the three
+    /// vectors are always the same length and ordered identically
+    void Sample(std::vector<simb::MCTruth>& truths,
+		std::vector<simb::MCFlux>&  fluxes,
+		std::vector<simb::GTruth>&  gtruths);
+
+    double      TotalPOT()                  const { return fTotalPOT;       }
+    double      SpillPOT()                  const { return fPOTPerSpill;    }
+    double      Livetime(size_t i)          const;
+    long        NSpills()                   const { return fNSpills;        }
+    size_t      NLibraries()                const { return fLibraries.size(); }
+    std::string LibraryName(size_t i)       const { return fLibraries[i]->Name(); }
+    long        NDrawn(size_t i)            const { return fNDrawn[i];      }
+    double      ReuseFactor(size_t i)       const;
+    double      EquivalentExposure(size_t i) const;
+
+  private:
+
+    double SpillTime();
+    void   ShiftTime(simb::MCTruth const& in,
+		     simb::MCTruth&       out,
+		     double               dt) const;
+
+    CLHEP::HepRandomEngine&                  fEngine;          ///< random engine owned by the calling module
+    std::vector< std::unique_ptr<MixLibrary> > fLibraries;       ///< libraries to draw from
+    std::vector<long>                        fNDrawn;          ///< records drawn from each library
+    double                                   fPOTPerSpill;     ///< POT in each spill
+    double                                   fGlobalTimeOffset;///< start of the spill (ns)
+    double                                   fSpillLength;     ///< length of a flat spill (ns)
+    std::vector<double>                      fBunchTimes;      ///< bunch centres relative to the spill start (ns)
+    double                                   fBunchSigma;      ///< gaussian width of each bunch (ns)
+    double                                   fTotalPOT;        ///< POT accumulated over all spills
+    long                                     fNSpills;         ///< number of spills generated
+  };
+
+}
+#endif // EVGB_SPILLMIXER_H
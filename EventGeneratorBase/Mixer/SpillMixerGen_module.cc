@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  SpillMixerGen_module.cc
+/// \brief Producer that fills each event with a spill from evgb::SpillMixer
+///
+/// Every event gets one spill drawn from the configured libraries, as
+///   std::vector<simb::MCTruth>, std::vector<simb::MCFlux>,
+///   std::vector<simb::GTruth>
+/// (same length and order) plus the MCTruth <-> MCFlux and MCTruth <->
+/// GTruth associations GENIE based generators provide.  The module
+/// parameters are those of evgb::SpillMixer (POTPerSpill, BunchTimes,
+/// Libraries, ...) and an optional Seed for its random engine.  The
+/// POT mixed into each subrun is logged at the end of the subrun.
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#include <memory>
+#include <vector>
+
+// Framework includes
+#include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/SubRun.h"
+#include "art/Framework/Services/Registry/ServiceHandle.h"
+#include "art/Framework/Services/Optional/RandomNumberGenerator.h"
+#include "art/Persistency/Common/Ptr.h"
+#include "art/Persistency/Common/Assns.h"
+#include "fhiclcpp/ParameterSet.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+// NuTools includes
+#include "SimulationBase/MCTruth.h"
+#include "SimulationBase/MCFlux.h"
+#include "SimulationBase/GTruth.h"
+#include "EventGeneratorBase/evgenbase.h"
+#include "EventGeneratorBase/Mixer/SpillMixer.h"
+
+namespace evgen {
+
+  /// Build spills from pre-generated libraries instead of running the
+  /// generators
+  class SpillMixerGen : public art::EDProducer {
+
+  public:
+
+    explicit SpillMixerGen(fhicl::ParameterSet const& pset);
+    virtual ~SpillMixerGen();
+
+    void produce(art::Event& evt);
+    void beginSubRun(art::SubRun& sr);
+    void endSubRun(art::SubRun& sr);
+
+  private:
+
+    std::unique_ptr<evgb::SpillMixer> fMixer;        ///< draws the spills
+    double                            fSubRunPOT0;   ///< mixer POT at the start of the subrun
+  };
+}
+
+namespace evgen {
+
+  //____________________________________________________________________________
+  SpillMixerGen::SpillMixerGen(fhicl::ParameterSet const& pset)
+    : fSubRunPOT0(0.)
+  {
+    /// Create a Art Random Number engine
+    int seed = (pset.get< int >("Seed", evgb::GetRandomNumberSeed()));
+    createEngine(seed);
+
+    art::ServiceHandle<art::RandomNumberGenerator> rng;
+    fMixer.reset(new evgb::SpillMixer(pset, rng->getEngine()));
+
+    produces< std::vector<simb::MCTruth> >();
+    produces< std::vector<simb::MCFlux>  >();
+    produces< std::vector<simb::GTruth>  >();
+    produces< art::Assns<simb::MCTruth, simb::MCFlux> >();
+    produces< art::Assns<simb::MCTruth, simb::GTruth> >();
+  }
+
+  //____________________________________________________________________________
+  SpillMixerGen::~SpillMixerGen()
+  {
+  }
+
+  //____________________________________________________________________________
+  void SpillMixerGen::beginSubRun(art::SubRun&)
+  {
+    fSubRunPOT0 = fMixer->TotalPOT();
+  }
+
+  //____________________________________________________________________________
+  void SpillMixerGen::endSubRun(art::SubRun& sr)
+  {
+    mf::LogInfo("SpillMixerGen") << "subrun " << sr.subRun() << ": mixed "
+                                 << fMixer->TotalPOT() - fSubRunPOT0 << " POT";
+  }
+
+  //____________________________________________________________________________
+  void SpillMixerGen::produce(art::Event& evt)
+  {
+    std::unique_ptr< std::vector<simb::MCTruth> > truthcol (new std::vector<simb::MCTruth>);
+    std::unique_ptr< std::vector<simb::MCFlux>  > fluxcol  (new std::vector<simb::MCFlux> );
+    std::unique_ptr< std::vector<simb::GTruth>  > gtruthcol(new std::vector<simb::GTruth> );
+    std::unique_ptr< art::Assns<simb::MCTruth, simb::MCFlux> > tfassn(new art::Assns<simb::MCTruth, simb::MCFlux>);
+    std::unique_ptr< art::Assns<simb::MCTruth, simb::GTruth> > tgassn(new art::Assns<simb::MCTruth, simb::GTruth>);
+
+    fMixer->Sample(*truthcol, *fluxcol, *gtruthcol);
+
+    // the three collections are parallel, associate entry i with entry i
+    art::ProductID truthID  = getProductID< std::vector<simb::MCTruth> >(evt);
+    art::ProductID fluxID   = getProductID< std::vector<simb::MCFlux>  >(evt);
+    art::ProductID gtruthID = getProductID< std::vector<simb::GTruth>  >(evt);
+    for(size_t i = 0; i < truthcol->size(); ++i){
+      art::Ptr<simb::MCTruth> truth (truthID,  i, evt.productGetter(truthID) );
+      art::Ptr<simb::MCFlux>  flux  (fluxID,   i, evt.productGetter(fluxID)  );
+      art::Ptr<simb::GTruth>  gtruth(gtruthID, i, evt.productGetter(gtruthID));
+      tfassn->addSingle(truth, flux);
+      tgassn->addSingle(truth, gtruth);
+    }
+
+    LOG_DEBUG("SpillMixerGen") << "spill " << fMixer->NSpills() << ": "
+                               << truthcol->size() << " records";
+
+    evt.put(std::move(truthcol));
+    evt.put(std::move(fluxcol));
+    evt.put(std::move(gtruthcol));
+    evt.put(std::move(tfassn));
+    evt.put(std::move(tgassn));
+  }
+
+}
+
+namespace evgen {
+
+  DEFINE_ART_MODULE(SpillMixerGen)
+
+}
@@ -0,0 +1,204 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  RNGStream.h
+/// \brief Counter based random number streams addressed by event id
+///
+/// The stream is a Philox4x32-10 generator (Salmon et al., "Parallel
+/// random numbers: as easy as 1, 2, 3", SC11).  The key is made from a
+/// job wide seed and a stream id (one per generator, e.g. GENIE or CRY)
+/// and the counter from the (run, subrun, event) triplet plus a running
+/// draw index, so the sequence of numbers for a given event depends only
+/// on its id and never on what was generated before it.  Events can
+/// therefore be produced in any order or on any thread and reproduce
+/// exactly.
+///
+/// RNGStream is a TRandom so it can stand in for gRandom and provides
+/// Flat() for CRY's random function hook.  Generators that own their
+/// own TRandom3 (GENIE's RandomGen and the helpers' TRandom3) are
+/// adapted by reseeding them from DerivedSeed() at the start of every
+/// event.
+///
+/// Reseeding only makes an event reproducible if everything it draws
+/// comes from the reseeded generators.  Flux drivers that read their
+/// ntuple in order do not: the entries an event gets depend on how many
+/// the events before it used.  So GENIEHelper's UseRNGStreams covers
+/// the histogram, mono-energetic and atmospheric fluxes, and refuses
+/// the ntuple (GNuMIFlux) and simple_flux (GSimpleNtpFlux) drivers,
+/// which have no way to address an entry.  GDk2NuFlux can draw its
+/// entries through genie::RandomGen instead (SetRandomEntries()), which
+/// makes it reproducible for generators that configure it themselves;
+/// GENIEHelper does not build a dk2nu driver.  The generator, e.g. the
+/// art module owning the GENIEHelper, must call SetEventID() with the
+/// event's id before every Sample().
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#ifndef EVGB_RNGSTREAM_H
+#define EVGB_RNGSTREAM_H
+
+#include <stdint.h>
+
+#include "TRandom.h"
+
+namespace evgb {
+
+  /// stream ids for the generators in nutools, experiments are free to
+  /// use any other value for their own streams
+  enum {
+    kGENIEStream  = 1,
+    kCRYStream    = 2
+  };
+
+  class RNGStream : public TRandom {
+  public:
+    RNGStream(uint64_t seed     = 0,
+	      uint32_t streamId = 0);
+    virtual ~RNGStream() {}
+
+    /// position the stream at the start of the given event
+    void     SetEvent(uint32_t run, uint32_t subrun, uint32_t event);
+
+    /// uniform on (0,1), never returns exactly 0 or 1
+    double   Flat();
+
+    /// a 32 bit value drawn from the stream, for seeding generators
+    /// that keep their own state
+    uint32_t DerivedSeed();
+
+    uint32_t StreamId()   const { return fStreamId; }
+    uint64_t Draws()      const { return fDraw;     }
+
+    // TRandom interface
+    virtual Double_t Rndm(Int_t i = 0);
+    virtual void     RndmArray(Int_t n, Float_t*  array);
+    virtual void     RndmArray(Int_t n, Double_t* array);
+    virtual void     SetSeed(UInt_t seed = 0);
+
+  private:
+
+    void     Generate();
+    uint32_t Next32();
+
+    uint64_t fSeed;       ///< job wide seed
+    uint32_t fStreamId;   ///< which generator this stream feeds
+    uint32_t fKey[2];     ///< Philox key, from seed and stream id
+    uint32_t fCtr[4];     ///< Philox counter: draw block, event, subrun, run
+    uint32_t fOut[4];     ///< output of the current block
+    int      fUsed;       ///< number of words of fOut already consumed
+    uint64_t fDraw;       ///< number of 32 bit words drawn for this event
+  };
+
+}
+
+//......................................................................
+inline evgb::RNGStream::RNGStream(uint64_t seed,
+				  uint32_t streamId)
+  : TRandom(0)
+  , fSeed    (seed)
+  , fStreamId(streamId)
+  , fUsed    (4)
+  , fDraw    (0)
+{
+  fKey[0] = (uint32_t)(fSeed & 0xFFFFFFFF);
+  fKey[1] = (uint32_t)(fSeed >> 32) ^ (fStreamId * 0x9E3779B9u);
+  this->SetEvent(0, 0, 0);
+}
+
+//......................................................................
+inline void evgb::RNGStream::SetEvent(uint32_t run, uint32_t subrun, uint32_t event)
+{
+  fCtr[0] = 0;
+  fCtr[1] = event;
+  fCtr[2] = subrun;
+  fCtr[3] = run;
+  fUsed   = 4;
+  fDraw   = 0;
+}
+
+//......................................................................
+// Philox4x32 with 10 rounds, constants from the Random123 reference
+inline void evgb::RNGStream::Generate()
+{
+  const uint32_t kM0 = 0xD2511F53u;
+  const uint32_t kM1 = 0xCD9E8D57u;
+  const uint32_t kW0 = 0x9E3779B9u;
+  const uint32_t kW1 = 0xBB67AE85u;
+
+  uint32_t c[4] = {fCtr[0], fCtr[1], fCtr[2], fCtr[3]};
+  uint32_t k[2] = {fKey[0], fKey[1]};
+
+  for(int r = 0; r < 10; ++r){
+    uint64_t p0 = (uint64_t)kM0 * c[0];
+    uint64_t p1 = (uint64_t)kM1 * c[2];
+    uint32_t hi0 = (uint32_t)(p0 >> 32), lo0 = (uint32_t)p0;
+    uint32_t hi1 = (uint32_t)(p1 >> 32), lo1 = (uint32_t)p1;
+    c[0] = hi1 ^ c[1] ^ k[0];
+    c[1] = lo1;
+    c[2] = hi0 ^ c[3] ^ k[1];
+    c[3] = lo0;
+    k[0] += kW0;
+    k[1] += kW1;
+  }
+
+  for(int i = 0; i < 4; ++i) fOut[i] = c[i];
+
+  // only the block index advances, the event id stays in the counter
+  ++fCtr[0];
+  fUsed = 0;
+}
+
+//......................................................................
+inline uint32_t evgb::RNGStream::Next32()
+{
+  if(fUsed >= 4) this->Generate();
+  ++fDraw;
+  return fOut[fUsed++];
+}
+
+//......................................................................
+inline double evgb::RNGStream::Flat()
+{
+  // 52 bits from two words, offset by half a step to stay off 0 and 1;
+  // with 53 bits the largest value plus the half step rounds up to 1
+  uint64_t a = this->Next32() >> 6;
+  uint64_t b = this->Next32() >> 6;
+  return ((a * 67108864. + b) + 0.5) * (1.0/4503599627370496.);
+}
+
+//......................................................................
+inline uint32_t evgb::RNGStream::DerivedSeed()
+{
+  // TRandom3 treats a seed of 0 as a request for a time based seed
+  uint32_t s = 0;
+  while(s == 0) s = this->Next32();
+  return s;
+}
+
+//......................................................................
+inline Double_t evgb::RNGStream::Rndm(Int_t)
+{
+  return this->Flat();
+}
+
+//......................................................................
+inline void evgb::RNGStream::RndmArray(Int_t n, Float_t* array)
+{
+  for(Int_t i = 0; i < n; ++i) array[i] = (Float_t)this->Flat();
+}
+
+//......................................................................
+inline void evgb::RNGStream::RndmArray(Int_t n, Double_t* array)
+{
+  for(Int_t i = 0; i < n; ++i) array[i] = this->Flat();
+}
+
+//......................................................................
+// the seed is part of the key, changing it starts a new family of streams
+inline void evgb::RNGStream::SetSeed(UInt_t seed)
+{
+  fSeed   = seed;
+  fKey[0] = (uint32_t)(fSeed & 0xFFFFFFFF);
+  fKey[1] = (uint32_t)(fSeed >> 32) ^ (fStreamId * 0x9E3779B9u);
+  fUsed   = 4;
+}
+
+#endif // EVGB_RNGSTREAM_H
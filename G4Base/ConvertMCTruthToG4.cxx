@@ -22,6 +22,7 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <algorithm>
 
 #include "messagefacility/MessageLogger/MessageLogger.h"
 
@@ -35,6 +36,7 @@ namespace g4b{
   //-----------------------------------------------------
   // Constructor and destructor.
   ConvertMCTruthToG4::ConvertMCTruthToG4() 
+    : fSubEvent(-1)
   {
   }
 
@@ -70,6 +72,8 @@ namespace g4b{
   void ConvertMCTruthToG4::Reset()
   {
     fConvertList.clear();
+    fSubEventOf.clear();
+    fSubEvent = -1;
   }
 
   //-----------------------------------------------------
@@ -84,6 +88,41 @@ namespace g4b{
     fConvertList.push_back( mct );
   }
 
+  //-----------------------------------------------------
+  std::vector<size_t> ConvertMCTruthToG4::PartitionPrimaries(unsigned int nsub)
+  {
+    if ( nsub < 1 ) nsub = 1;
+
+    // (energy, MCTruth, particle) of everything to be tracked
+    struct Primary { double e; size_t t; int p; };
+    std::vector<Primary> primaries;
+    fSubEventOf.assign(fConvertList.size(), std::vector<int>());
+    for ( size_t t = 0; t < fConvertList.size(); ++t ) {
+      const simb::MCTruth* mct = fConvertList[t];
+      fSubEventOf[t].assign(mct->NParticles(), -1);
+      for ( int p = 0; p != mct->NParticles(); ++p ) {
+	const simb::MCParticle& particle = mct->GetParticle(p);
+	if ( particle.StatusCode() != 1 ) continue;
+	Primary prim = { particle.E(), t, p };
+	primaries.push_back(prim);
+      }
+    }
+
+    // largest energy first into the sub-event with the least energy so
+    // far; ties keep the input order and the lowest sub-event
+    std::stable_sort(primaries.begin(), primaries.end(),
+		     [](Primary const& a, Primary const& b) { return a.e > b.e; });
+    std::vector<double> load(nsub, 0.);
+    std::vector<size_t> count(nsub, 0);
+    for ( auto const& prim : primaries ) {
+      size_t isub = std::min_element(load.begin(), load.end()) - load.begin();
+      load[isub] += prim.e;
+      ++count[isub];
+      fSubEventOf[prim.t][prim.p] = isub;
+    }
+    return count;
+  }
+
   //-----------------------------------------------------
   void ConvertMCTruthToG4::GeneratePrimaries( G4Event* event )
   {
@@ -120,6 +159,9 @@ namespace g4b{
 	// status code == 1 means "track this particle."  Any
 	// other status code should be ignored by the Monte Carlo.
 	if ( particle.StatusCode() != 1 ) continue;
+
+	// with sub-event tracking only this sub-event's share
+	if ( fSubEvent >= 0 && fSubEventOf[index][p] != fSubEvent ) continue;
       
 	// Get the Particle Data Group code for the particle.
 	G4int pdgCode = particle.PdgCode();
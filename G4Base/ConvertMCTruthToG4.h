@@ -57,10 +57,23 @@ namespace g4b {
     /// directly called by the user application.
     virtual void GeneratePrimaries( G4Event* );
 
+    /// Split the particles to be tracked (status 1) of the appended
+    /// MCTruths into nsub sub-events of similar total energy, largest
+    /// first.  The split only depends on the input.  Returns the number
+    /// of particles in each sub-event.
+    std::vector<size_t> PartitionPrimaries(unsigned int nsub);
+
+    /// Generate only the particles of sub-event isub of the last
+    /// partition; -1 (the default after Reset()) generates all.  The
+    /// MCTruthIndex of each primary is its MCTruth's index in the full list.
+    void SelectSubEvent(int isub) { fSubEvent = isub; }
+
   private:
     static G4ParticleTable*           fParticleTable; ///< Geant4's table of particle definitions.
     std::vector<const simb::MCTruth*> fConvertList;   ///< List of MCTruth objects to convert for this spill
     std::map<G4int, G4int>            fUnknownPDG;    ///< map of unknown PDG codes to instances
+    std::vector< std::vector<int> >   fSubEventOf;    ///< sub-event of each particle of each MCTruth
+    int                               fSubEvent;      ///< sub-event to generate, -1 = all
   };
 
 } // namespace g4b
@@ -29,7 +29,9 @@ namespace g4b{
   // Constructor
   DetectorConstruction::DetectorConstruction(std::string const& gdmlFile,
                                              bool overlapCheck,
-                                             bool validateSchema)
+                                             bool validateSchema,
+                                             bool useFieldService)
+    : fUseFieldService(useFieldService)
   {
     if ( gdmlFile.empty() ) {
       throw cet::exception("DetectorConstruction") << "Supplied GDML filename is empty\n"
@@ -58,6 +60,8 @@ namespace g4b{
   //---------------------------------------------------
   G4VPhysicalVolume* DetectorConstruction::Construct()
   {
+    if ( !fUseFieldService ) return fWorld;
+
     // Setup the magnetic field situation 
     art::ServiceHandle<mag::MagneticField> bField;
     switch (bField->UseField()) {
@@ -20,9 +20,12 @@ namespace g4b {
 
   public:
     /// Standard constructor and destructor.
+    /// Without useFieldService there is no magnetic field and no need
+    /// for the art MagneticField service, e.g. in standalone programs.
     explicit DetectorConstruction(std::string const& gdmlFile,
                                   bool overlapCheck = false,
-                                  bool validateSchema = true);
+                                  bool validateSchema = true,
+                                  bool useFieldService = true);
     virtual ~DetectorConstruction();
 
     /// The key method in this class; returns the Geant4 version of
@@ -42,6 +45,7 @@ namespace g4b {
   private:
     static G4VPhysicalVolume* fWorld;    ///< pointer to the world volume
     static G4FieldManager*    fFieldMgr; ///< pointer to the field manager
+    bool                      fUseFieldService; ///< take the field from mag::MagneticField?
 
   };
 
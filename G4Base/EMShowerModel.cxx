@@ -0,0 +1,157 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  EMShowerModel.cxx
+/// \brief Parameterized electromagnetic shower for G4 fast simulation
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+#include "G4Base/EMShowerModel.h"
+#include "G4Base/EnergySpot.h"
+#include "G4Base/UserActionManager.h"
+
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+#include "Geant4/G4Electron.hh"
+#include "Geant4/G4Positron.hh"
+#include "Geant4/G4Gamma.hh"
+#include "Geant4/G4FastTrack.hh"
+#include "Geant4/G4FastStep.hh"
+#include "Geant4/G4Track.hh"
+#include "Geant4/G4Material.hh"
+#include "Geant4/G4Element.hh"
+#include "Geant4/G4Region.hh"
+#include "Geant4/G4SystemOfUnits.hh"
+#include "Geant4/G4PhysicalConstants.hh"
+#include "Geant4/Randomize.hh"
+
+#include <cmath>
+#include <algorithm>
+
+namespace g4b {
+
+  //-------------------------------------------------------------
+  EMShowerModel::EMShowerModel(G4String const&             name,
+			       G4Region*                   envelope,
+			       fhicl::ParameterSet const&  pset)
+    : G4VFastSimulationModel(name, envelope)
+    , fMinEnergy   (pset.get< double >("MinEnergy",    1.   )*GeV)
+    , fSpotEnergy  (pset.get< double >("SpotEnergy",   0.01 )*GeV)
+    , fMaxSpots    (pset.get< int    >("MaxSpots",     10000))
+    , fAlphaSlope  (pset.get< double >("AlphaSlope",   0.5  ))
+    , fCoreRadius  (pset.get< double >("CoreRadius",   0.2  ))
+    , fTailRadius  (pset.get< double >("TailRadius",   1.0  ))
+    , fCoreFraction(pset.get< double >("CoreFraction", 0.85 ))
+    , fNShowers(0)
+  {
+    mf::LogInfo("EMShowerModel") << "parameterizing e+/e-/gamma above "
+				 << fMinEnergy/GeV << " GeV in region "
+				 << envelope->GetName();
+  }
+
+  //-------------------------------------------------------------
+  EMShowerModel::~EMShowerModel()
+  {
+    mf::LogInfo("EMShowerModel") << GetName() << " parameterized "
+				 << fNShowers << " showers";
+  }
+
+  //-------------------------------------------------------------
+  G4bool EMShowerModel::IsApplicable(const G4ParticleDefinition& particle)
+  {
+    return ( &particle == G4Electron::ElectronDefinition() ||
+	     &particle == G4Positron::PositronDefinition() ||
+	     &particle == G4Gamma::GammaDefinition()       );
+  }
+
+  //-------------------------------------------------------------
+  G4bool EMShowerModel::ModelTrigger(const G4FastTrack& fastTrack)
+  {
+    return ( fastTrack.GetPrimaryTrack()->GetKineticEnergy() > fMinEnergy );
+  }
+
+  //-------------------------------------------------------------
+  void EMShowerModel::MaterialConstants(const G4Material* mat,
+					double&           x0,
+					double&           ec,
+					double&           rm) const
+  {
+    // effective Z weighted by the number of electrons of each element
+    const G4ElementVector* elements = mat->GetElementVector();
+    const G4double*        nAtoms   = mat->GetVecNbOfAtomsPerVolume();
+    double sumZ  = 0.;
+    double sumZ2 = 0.;
+    for ( size_t i = 0; i < mat->GetNumberOfElements(); ++i ) {
+      double z = (*elements)[i]->GetZ();
+      sumZ  += nAtoms[i]*z;
+      sumZ2 += nAtoms[i]*z*z;
+    }
+    double zeff = ( sumZ > 0. ) ? sumZ2/sumZ : 1.;
+
+    // PDG parameterizations of the critical energy
+    x0 = mat->GetRadlen();
+    if ( mat->GetState() == kStateGas ) ec = 710.*MeV/(zeff + 0.92);
+    else                                ec = 610.*MeV/(zeff + 1.24);
+    rm = 21.2052*MeV*x0/ec;
+  }
+
+  //-------------------------------------------------------------
+  void EMShowerModel::DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep)
+  {
+    const G4Track* track = fastTrack.GetPrimaryTrack();
+
+    const double        energy = track->GetKineticEnergy();
+    const G4ThreeVector origin = track->GetPosition();
+    const G4ThreeVector dir    = track->GetMomentumDirection();
+    const double        t0     = track->GetGlobalTime();
+
+    double x0 = 0., ec = 0., rm = 0.;
+    this->MaterialConstants(track->GetMaterial(), x0, ec, rm);
+
+    // longitudinal profile: dE/dt ~ (bt)^(a-1) exp(-bt), tmax = (a-1)/b
+    double tmax = std::log(std::max(energy/ec, 1.));
+    tmax += ( track->GetDefinition() == G4Gamma::GammaDefinition() ) ? 0.5 : -0.5;
+    tmax  = std::max(tmax, 0.);
+    const double b = fAlphaSlope;
+    const double a = b*tmax + 1.;
+
+    int nspots = (int)(energy/fSpotEnergy);
+    nspots = std::max(1, std::min(nspots, fMaxSpots));
+    const double espot = energy/nspots;
+
+    // axes transverse to the shower
+    const G4ThreeVector u = dir.orthogonal().unit();
+    const G4ThreeVector v = dir.cross(u);
+
+    UserActionManager* uaManager = UserActionManager::Instance();
+
+    EnergySpot spot;
+    spot.energy  = espot;
+    spot.trackID = track->GetTrackID();
+    spot.weight  = track->GetWeight();
+    spot.volume  = fastTrack.GetEnvelopeLogicalVolume();
+
+    for ( int i = 0; i < nspots; ++i ) {
+      const double t = CLHEP::RandGamma::shoot(a, b);
+
+      // radial: CDF of 2rR^2/(r^2+R^2)^2 is r^2/(r^2+R^2)
+      const double rr  = ( G4UniformRand() < fCoreFraction ) ? fCoreRadius : fTailRadius;
+      const double q   = G4UniformRand();
+      const double r   = rr*rm*std::sqrt(q/(1. - q));
+      const double phi = twopi*G4UniformRand();
+
+      spot.position = origin + t*x0*dir + r*(std::cos(phi)*u + std::sin(phi)*v);
+      spot.time     = t0 + t*x0/c_light;
+      uaManager->EnergySpotAction(spot);
+    }
+
+    ++fNShowers;
+
+    // the energy reaches the UserActions only through the spots; also
+    // proposing it as the step's deposit would count it twice in any
+    // action that sums both
+    fastStep.KillPrimaryTrack();
+    fastStep.ProposePrimaryTrackPathLength(0.);
+    fastStep.ProposeTotalEnergyDeposited(0.);
+  }
+
+} // namespace g4b
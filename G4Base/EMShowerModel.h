@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  EMShowerModel.h
+/// \brief Parameterized electromagnetic shower for G4 fast simulation
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+/// This G4VFastSimulationModel replaces the full tracking of e+, e- and
+/// gammas above a configurable energy inside its envelope (a G4Region)
+/// by a parameterized shower in the style of Grindhammer and Peters
+/// (hep-ex/0001020).  The longitudinal profile is a gamma distribution
+/// in radiation lengths with the maximum at ln(E/Ec) -/+ 0.5 for
+/// electrons/photons; the radial profile is a sum of a core and a tail
+/// component, each of the form 2 r R^2/(r^2 + R^2)^2, in units of the
+/// Moliere radius.  The material constants are taken from the material
+/// the shower starts in.
+///
+/// The shower energy is split into spots of roughly equal energy which
+/// are handed to the UserActionManager (UserAction::EnergySpotAction)
+/// instead of being tracked.  The primary is killed; the step that
+/// kills it deposits nothing, so the spots carry all of the shower
+/// energy and the sum of the spots is the primary's kinetic energy.
+/// Spots that would fall outside the envelope are kept, so the
+/// envelope should be chosen to contain the showers it is used for.
+
+#ifndef G4BASE_EMSHOWERMODEL_H
+#define G4BASE_EMSHOWERMODEL_H
+
+#include "Geant4/G4VFastSimulationModel.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+class G4Region;
+class G4Material;
+
+namespace g4b {
+
+  class EMShowerModel : public G4VFastSimulationModel {
+
+  public:
+    EMShowerModel(G4String const&             name,
+		  G4Region*                   envelope,
+		  fhicl::ParameterSet const&  pset);
+    virtual ~EMShowerModel();
+
+    G4bool IsApplicable(const G4ParticleDefinition& particle);
+    G4bool ModelTrigger(const G4FastTrack& fastTrack);
+    void   DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep);
+
+    long   NShowers() const { return fNShowers; }
+
+  private:
+
+    /// effective Z, radiation length, critical energy and Moliere radius
+    void MaterialConstants(const G4Material* mat,
+			   double&           x0,
+			   double&           ec,
+			   double&           rm) const;
+
+    double fMinEnergy;     ///< parameterize showers above this energy
+    double fSpotEnergy;    ///< nominal energy per spot
+    int    fMaxSpots;      ///< upper limit on spots per shower
+    double fAlphaSlope;    ///< b of the longitudinal gamma distribution
+    double fCoreRadius;    ///< core radius in Moliere radii
+    double fTailRadius;    ///< tail radius in Moliere radii
+    double fCoreFraction;  ///< fraction of the energy in the core
+    long   fNShowers;      ///< number of showers parameterized
+  };
+
+} // namespace g4b
+
+#endif // G4BASE_EMSHOWERMODEL_H
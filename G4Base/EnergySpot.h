@@ -0,0 +1,34 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  EnergySpot.h
+/// \brief Energy deposited at a point by a fast simulation model
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+/// A parameterized shower does not produce G4Steps, so the energy it
+/// deposits is handed to the UserActions as a list of spots through
+/// UserAction::EnergySpotAction().  All quantities are in Geant4 units.
+/// Actions that sum the energy should weight it with the weight of the
+/// shower parent, as they weight step deposits with the track weight.
+
+#ifndef G4BASE_ENERGYSPOT_H
+#define G4BASE_ENERGYSPOT_H
+
+#include "Geant4/G4ThreeVector.hh"
+
+class G4LogicalVolume;
+
+namespace g4b {
+
+  struct EnergySpot {
+    G4ThreeVector          position;  ///< where the energy was deposited
+    double                 energy;    ///< deposited energy
+    double                 time;      ///< global time of the deposit
+    int                    trackID;   ///< G4 track id of the shower parent
+    double                 weight;    ///< G4 track weight of the shower parent
+    const G4LogicalVolume* volume;    ///< envelope volume the shower started in
+  };
+
+} // namespace g4b
+
+#endif // G4BASE_ENERGYSPOT_H
@@ -0,0 +1,47 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  FastShowerPhysics.cxx
+/// \brief Attach the G4 fast simulation process to e+, e- and gamma
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+#include "G4Base/FastShowerPhysics.h"
+
+#include "Geant4/G4FastSimulationManagerProcess.hh"
+#include "Geant4/G4ProcessManager.hh"
+#include "Geant4/G4Electron.hh"
+#include "Geant4/G4Positron.hh"
+#include "Geant4/G4Gamma.hh"
+
+namespace g4b {
+
+  //-------------------------------------------------------------
+  FastShowerPhysics::FastShowerPhysics(G4String const& name)
+    : G4VPhysicsConstructor(name)
+  {
+  }
+
+  //-------------------------------------------------------------
+  FastShowerPhysics::~FastShowerPhysics()
+  {
+  }
+
+  //-------------------------------------------------------------
+  void FastShowerPhysics::ConstructParticle()
+  {
+    // the particles are constructed by the EM physics of the list
+  }
+
+  //-------------------------------------------------------------
+  void FastShowerPhysics::ConstructProcess()
+  {
+    G4FastSimulationManagerProcess* fastSim = new G4FastSimulationManagerProcess();
+
+    G4ParticleDefinition* particles[] = { G4Electron::ElectronDefinition(),
+					  G4Positron::PositronDefinition(),
+					  G4Gamma::GammaDefinition()        };
+    for ( size_t i = 0; i < sizeof(particles)/sizeof(particles[0]); ++i )
+      particles[i]->GetProcessManager()->AddDiscreteProcess(fastSim);
+  }
+
+} // namespace g4b
@@ -0,0 +1,32 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  FastShowerPhysics.h
+/// \brief Attach the G4 fast simulation process to e+, e- and gamma
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+/// G4FastSimulationManagerProcess must be in the process list of a
+/// particle for any G4VFastSimulationModel to be invoked for it.
+/// G4Helper registers this constructor with the physics list when a
+/// fast shower configuration has been given.
+
+#ifndef G4BASE_FASTSHOWERPHYSICS_H
+#define G4BASE_FASTSHOWERPHYSICS_H
+
+#include "Geant4/G4VPhysicsConstructor.hh"
+
+namespace g4b {
+
+  class FastShowerPhysics : public G4VPhysicsConstructor {
+
+  public:
+    FastShowerPhysics(G4String const& name = "FastShowerPhysics");
+    virtual ~FastShowerPhysics();
+
+    void ConstructParticle();
+    void ConstructProcess();
+  };
+
+} // namespace g4b
+
+#endif // G4BASE_FASTSHOWERPHYSICS_H
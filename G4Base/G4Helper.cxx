@@ -9,6 +9,10 @@
 #include "G4Base/G4Helper.h"
 #include "G4Base/DetectorConstruction.h"
 #include "G4Base/UserActionManager.h"
+#include "G4Base/EMShowerModel.h"
+#include "G4Base/FastShowerPhysics.h"
+#include "G4Base/StepLimiterPhysics.h"
+#include "G4Base/RegionStepAction.h"
 
 #include "SimulationBase/MCTruth.h"
 
@@ -21,6 +25,18 @@
 #include "Geant4/G4UserTrackingAction.hh"
 #include "Geant4/G4UserSteppingAction.hh"
 #include "Geant4/G4VisExecutive.hh"
+#include "Geant4/G4Region.hh"
+#include "Geant4/G4LogicalVolume.hh"
+#include "Geant4/G4LogicalVolumeStore.hh"
+#include "Geant4/G4RegionStore.hh"
+#include "Geant4/G4ProductionCuts.hh"
+#include "Geant4/G4UserLimits.hh"
+#include "Geant4/G4SystemOfUnits.hh"
+#include "Geant4/G4IStore.hh"
+#include "Geant4/G4GeometrySampler.hh"
+#include "Geant4/G4TransportationManager.hh"
+#include "Geant4/G4VPhysicalVolume.hh"
+#include "Geant4/Randomize.hh"
 
 #include <boost/algorithm/string.hpp>
 
@@ -39,15 +55,61 @@
 
 #include <iostream>
 #include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <stdint.h>
 #include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "messagefacility/MessageLogger/MessageLogger.h"
+#include "cetlib/exception.h"
+
+namespace {
+
+  // splitmix64 finalizer: seeds of the sub-events from the base seed,
+  // the G4Run count and the sub-event index
+  long SeedMix(long seed, long i)
+  {
+    uint64_t k = (uint64_t)seed + 0x9e3779b97f4a7c15ULL*(uint64_t)(i + 1);
+    k ^= k >> 30; k *= 0xbf58476d1ce4e5b9ULL;
+    k ^= k >> 27; k *= 0x94d049bb133111ebULL;
+    k ^= k >> 31;
+    // CLHEP engines want a positive seed
+    return (long)(k & 0x7fffffffL) + 1;
+  }
+
+  // threads of this process, 0 if that can not be found out
+  unsigned int NThreads()
+  {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while ( std::getline(status, line) )
+      if ( line.compare(0, 8, "Threads:") == 0 ) return std::atoi(line.c_str() + 8);
+    return 0;
+  }
+
+}
 
 namespace g4b{
 
   //------------------------------------------------
   // Constructor
   G4Helper::G4Helper()
+    : fUseFieldService(true)
+    , fUseFastShower(false)
+    , fUseStepLimits(false)
+    , fRegionSteps(0)
+    , fIStore(0)
+    , fNSubEvents(0)
+    , fNSubEventWorkers(1)
+    , fSubEventSeed(0)
+    , fNSubEventRuns(0)
   {
     fParallelWorlds.clear();
   }
@@ -62,9 +124,18 @@ namespace g4b{
     , fGDMLFile(gdmlFile)
     , fCheckOverlaps(false)
     , fValidateGDMLSchema(true)
+    , fUseFieldService(true)
     , fUIManager(0)
     , fConvertMCTruth(0)
     , fDetector(0)
+    , fUseFastShower(false)
+    , fUseStepLimits(false)
+    , fRegionSteps(0)
+    , fIStore(0)
+    , fNSubEvents(0)
+    , fNSubEventWorkers(1)
+    , fSubEventSeed(0)
+    , fNSubEventRuns(0)
   {
     // Geant4 run manager.  Nothing happens in Geant4 until this object
     // is created.
@@ -92,6 +163,10 @@ namespace g4b{
       // clean-up manually, then tell the G4RunManager that all those
       // classes no longer exist.
     
+      // the region step counter goes with the other actions
+      this->PrintRegionSummary();
+      fRegionSteps = 0;
+
       g4b::UserActionManager* uaManager = UserActionManager::Instance();
       bool wasStacking = uaManager->DoesAnyActionProvideStacking();
       uaManager->Close();
@@ -118,6 +193,13 @@ namespace g4b{
 		<< std::endl;
     }
 
+    for(size_t i = 0; i < fSamplers.size(); ++i){
+      fSamplers[i]->ClearSampling();
+      delete fSamplers[i];
+    }
+    fSamplers.clear();
+    if(fIStore) delete fIStore;
+
     for(size_t i = 0; i < fParallelWorlds.size(); ++i){
       if(fParallelWorlds[i]) delete fParallelWorlds[i];
     }
@@ -304,6 +386,27 @@ namespace g4b{
 
     }
 
+    // the fast simulation process has to be in the process list of
+    // e+/e-/gamma for the shower model to be invoked
+    if ( fUseFastShower ) {
+      G4VModularPhysicsList* mpl = dynamic_cast<G4VModularPhysicsList*>(physics);
+      if ( ! mpl )
+        throw cet::exception("G4Helper") << "fast shower simulation requires a "
+                                         << "G4VModularPhysicsList, \"" << phListName
+                                         << "\" is not one";
+      mpl->RegisterPhysics(new FastShowerPhysics);
+    }
+
+    // G4UserLimits only limit the step of particles with G4StepLimiter
+    if ( fUseStepLimits ) {
+      G4VModularPhysicsList* mpl = dynamic_cast<G4VModularPhysicsList*>(physics);
+      if ( ! mpl )
+        throw cet::exception("G4Helper") << "region step limits require a "
+                                         << "G4VModularPhysicsList, \"" << phListName
+                                         << "\" is not one";
+      mpl->RegisterPhysics(new StepLimiterPhysics);
+    }
+
     // pass off (possibly augmented) physics list to run manager
     // which calls G4RunManagerKernel->SetPhysics() on it 
     //   which itself call ConstructParticle() for the list
@@ -321,6 +424,208 @@ namespace g4b{
     return;
   }
 
+  //------------------------------------------------
+  void G4Helper::SetFastShower(fhicl::ParameterSet const& pset)
+  {
+    fFastShowerPSet = pset;
+    fUseFastShower  = true;
+
+    return;
+  }
+
+  //------------------------------------------------
+  void G4Helper::ConstructFastShower()
+  {
+    // All the envelope volumes go into one region; the shower model
+    // attaches itself to that region's G4FastSimulationManager.
+    std::vector<std::string> volumes = fFastShowerPSet.get< std::vector<std::string> >("Volumes");
+
+    G4Region* region = new G4Region("FastShowerRegion");
+    G4LogicalVolumeStore* lvStore = G4LogicalVolumeStore::GetInstance();
+    for(auto const& name : volumes){
+      G4LogicalVolume* lv = lvStore->GetVolume(name, false);
+      if( !lv )
+        throw cet::exception("G4Helper") << "fast shower envelope volume "
+                                         << name << " not found";
+      if( lv == DetectorConstruction::GetWorld()->GetLogicalVolume() )
+        throw cet::exception("G4Helper") << "the world volume can not be a fast shower envelope";
+      region->AddRootLogicalVolume(lv);
+      LOG_DEBUG("G4Helper") << "fast shower envelope " << name;
+    }
+
+    // the model is owned by the G4FastSimulationManager of the region
+    new EMShowerModel("EMShowerModel", region, fFastShowerPSet);
+
+    return;
+  }
+
+  //------------------------------------------------
+  void G4Helper::SetRegions(fhicl::ParameterSet const& pset)
+  {
+    fRegionsPSet   = pset;
+    fUseStepLimits = false;
+    for(auto const& rpset : pset.get< std::vector<fhicl::ParameterSet> >("Regions"))
+      if( rpset.has_key("MaxStepLength") ) fUseStepLimits = true;
+
+    return;
+  }
+
+  //------------------------------------------------
+  void G4Helper::ConstructRegions()
+  {
+    G4LogicalVolumeStore* lvStore  = G4LogicalVolumeStore::GetInstance();
+    G4RegionStore*        regStore = G4RegionStore::GetInstance();
+
+    for(auto const& rpset : fRegionsPSet.get< std::vector<fhicl::ParameterSet> >("Regions")){
+      std::string              name    = rpset.get< std::string >("Name");
+      std::vector<std::string> volumes = rpset.get< std::vector<std::string> >("Volumes",
+									       std::vector<std::string>());
+
+      G4Region* region = regStore->GetRegion(name, false);
+      if( !region ) region = new G4Region(name);
+
+      for(auto const& vname : volumes){
+	G4LogicalVolume* lv = lvStore->GetVolume(vname, false);
+	if( !lv )
+	  throw cet::exception("G4Helper") << "region " << name << ": volume "
+					   << vname << " not found";
+	if( lv == DetectorConstruction::GetWorld()->GetLogicalVolume() )
+	  throw cet::exception("G4Helper") << "region " << name << ": the world volume "
+					   << "belongs to the default region";
+	if( lv->IsRootRegion() && lv->GetRegion() != region )
+	  throw cet::exception("G4Helper") << "region " << name << ": volume " << vname
+					   << " already starts region " << lv->GetRegion()->GetName();
+	region->AddRootLogicalVolume(lv);
+      }
+      if( region->GetNumberOfRootVolumes() == 0 )
+	throw cet::exception("G4Helper") << "region " << name << " has no volumes";
+
+      // range cuts, in cm; a per particle value overrides RangeCut
+      const char* cutKeys[]   = { "GammaCut", "ElectronCut", "PositronCut", "ProtonCut" };
+      const char* particles[] = { "gamma",    "e-",          "e+",          "proton"    };
+      bool        anyCut      = rpset.has_key("RangeCut");
+      for(size_t i = 0; i < 4; ++i) anyCut = anyCut || rpset.has_key(cutKeys[i]);
+
+      mf::LogInfo log("G4Helper");
+      log << "region " << name << ":";
+      for(auto const& vname : volumes) log << " " << vname;
+
+      if( anyCut ){
+	G4ProductionCuts* cuts = new G4ProductionCuts;
+	// the Geant4 default of 0.7 mm for particles without a value
+	double range = rpset.get< double >("RangeCut", 0.07);
+	for(size_t i = 0; i < 4; ++i){
+	  double cut = rpset.get< double >(cutKeys[i], range);
+	  cuts->SetProductionCut(cut*CLHEP::cm, particles[i]);
+	  log << ", " << particles[i] << " cut " << cut << " cm";
+	}
+	region->SetProductionCuts(cuts);
+      }
+
+      if( rpset.has_key("MaxStepLength") ){
+	double maxStep = rpset.get< double >("MaxStepLength");
+	region->SetUserLimits(new G4UserLimits(maxStep*CLHEP::cm));
+	log << ", max step " << maxStep << " cm";
+      }
+    }
+
+    if( fRegionsPSet.get< bool >("StepSummary", false) ){
+      fRegionSteps = new RegionStepAction;
+      fRegionSteps->SetName("RegionStepAction");
+      UserActionManager::AddAndAdoptAction(fRegionSteps);
+    }
+
+    return;
+  }
+
+  //------------------------------------------------
+  void G4Helper::PrintRegionSummary() const
+  {
+    if( fRegionSteps ) fRegionSteps->Summary();
+  }
+
+  //------------------------------------------------
+  void G4Helper::SetImportanceBiasing(fhicl::ParameterSet const& pset)
+  {
+    fBiasingPSet = pset;
+
+    return;
+  }
+
+  //------------------------------------------------
+  void G4Helper::ConstructBiasing()
+  {
+    std::vector<std::string> particles = fBiasingPSet.get< std::vector<std::string> >("Particles");
+    std::string parallelName = fBiasingPSet.get< std::string >("ParallelWorld",     "");
+    double      defaultImp   = fBiasingPSet.get< double      >("DefaultImportance", 1.);
+
+    // importance by physical or logical volume name
+    std::map<std::string, double> byName;
+    for(auto const& ipset : fBiasingPSet.get< std::vector<fhicl::ParameterSet> >("Importances")){
+      double importance = ipset.get< double >("Importance");
+      if( importance <= 0. )
+	throw cet::exception("G4Helper") << "importances must be positive, not " << importance;
+      for(auto const& name : ipset.get< std::vector<std::string> >("Volumes"))
+	byName[name] = importance;
+    }
+
+    G4VPhysicalVolume* world = DetectorConstruction::GetWorld();
+    if( !parallelName.empty() ){
+      world = G4TransportationManager::GetTransportationManager()->IsWorldExisting(parallelName);
+      if( !world )
+	throw cet::exception("G4Helper") << "no parallel world " << parallelName
+					 << " for importance biasing";
+    }
+
+    // every cell below the world needs an importance; walk the volume
+    // tree once, each physical volume (and replica copy) is one cell
+    fIStore = new G4IStore(*world);
+    std::set<const G4VPhysicalVolume*> done;
+    std::vector<G4VPhysicalVolume*>    todo(1, world);
+    std::set<std::string>              used;
+    while( !todo.empty() ){
+      G4VPhysicalVolume* pv = todo.back();
+      todo.pop_back();
+      if( !done.insert(pv).second ) continue;
+
+      G4LogicalVolume* lv = pv->GetLogicalVolume();
+      double importance = defaultImp;
+      auto itr = byName.find(pv->GetName());
+      if( itr == byName.end() ) itr = byName.find(lv->GetName());
+      if( itr != byName.end() ){
+	importance = itr->second;
+	used.insert(itr->first);
+      }
+
+      if( pv->IsReplicated() ){
+	for(G4int copy = 0; copy < pv->GetMultiplicity(); ++copy)
+	  fIStore->AddImportanceGeometryCell(importance, *pv, copy);
+      }
+      else fIStore->AddImportanceGeometryCell(importance, *pv, pv->GetCopyNo());
+
+      for(G4int d = 0; d < lv->GetNoDaughters(); ++d) todo.push_back(lv->GetDaughter(d));
+    }
+    for(auto const& entry : byName)
+      if( !used.count(entry.first) )
+	mf::LogWarning("G4Helper") << "importance biasing: no volume named " << entry.first
+				   << ( parallelName.empty() ? "" : " in " + parallelName );
+
+    mf::LogInfo log("G4Helper");
+    log << "importance biasing of";
+    for(auto const& particle : particles){
+      G4GeometrySampler* sampler = new G4GeometrySampler(world, particle);
+      sampler->SetParallel(!parallelName.empty());
+      sampler->PrepareImportanceSampling(fIStore, 0);
+      sampler->Configure();
+      fSamplers.push_back(sampler);
+      log << " " << particle;
+    }
+    log << " in " << done.size() << " volumes of "
+	<< ( parallelName.empty() ? std::string("the mass geometry") : parallelName );
+
+    return;
+  }
+
   //------------------------------------------------
   void G4Helper::ConstructDetector(std::string const& gdmlFile)
   {
@@ -329,7 +634,8 @@ namespace g4b{
     bool validateGDMLSchema = fValidateGDMLSchema;
     fDetector = new DetectorConstruction(gdmlFile,
                                          checkOverlaps,
-                                         validateGDMLSchema);
+                                         validateGDMLSchema,
+                                         fUseFieldService);
 
     return;
   }
@@ -346,6 +652,10 @@ namespace g4b{
     // define the physics list to use
     this->SetPhysicsList(fG4PhysListName);
 
+    if(fUseFastShower) this->ConstructFastShower();
+
+    if(!fRegionsPSet.is_empty()) this->ConstructRegions();
+
     // Pass the detector geometry on to Geant4.
     fRunManager->SetUserInitialization(fDetector);
   
@@ -398,6 +708,9 @@ namespace g4b{
     /// simulate events in the detector.
     fRunManager->Initialize();
 
+    // the importance processes go in after the physics list is built
+    if(!fBiasingPSet.is_empty()) this->ConstructBiasing();
+
     return;
   }
 
@@ -434,6 +747,11 @@ namespace g4b{
     // Pass all the MCTruths to our event generator.
     for(auto primary : primaries)
       fConvertMCTruth->Append( primary );
+
+    if ( fNSubEvents > 0 ) {
+      this->G4RunSubEvents();
+      return true;
+    }
     
     // Start the simulation for this event.  Note: The following
     // statement increments the G4RunManager's run number.  Because of
@@ -444,4 +762,172 @@ namespace g4b{
     return true;
   }
 
+  //------------------------------------------------
+  void G4Helper::SetSubEventTracking(unsigned int nSubEvents,
+				     unsigned int nWorkers,
+				     long         seed)
+  {
+    fNSubEvents       = nSubEvents;
+    fNSubEventWorkers = std::max(nWorkers, 1u);
+    fSubEventSeed     = ( seed != 0 ) ? seed : CLHEP::HepRandom::getTheSeed();
+    fNSubEventRuns    = 0;
+
+    if ( fNSubEvents == 0 ) return;
+
+    this->CheckSubEventTracking();
+    mf::LogInfo("G4Helper") << "tracking each event as " << fNSubEvents 
+			    << " sub-events in " << fNSubEventWorkers << " process(es)";
+  }
+
+  //------------------------------------------------
+  // Actions may be added after SetSubEventTracking, and threads started,
+  // so this is repeated for every G4Run call
+  void G4Helper::CheckSubEventTracking() const
+  {
+    // the results of an action without a merge would silently be those
+    // of the last sub-event, or of none of them with worker processes
+    std::vector<std::string> names = UserActionManager::Instance()->ActionsWithoutSubEventMerge();
+    if ( !names.empty() ) {
+      cet::exception e("G4Helper");
+      e << "sub-event tracking needs every UserAction to merge sub-events; these do not:";
+      for ( auto const& name : names ) e << " " << name;
+      throw e;
+    }
+
+    // a forked child only gets the thread that called fork(), so a lock
+    // held by any other thread (malloc, the message logger, ROOT) at
+    // that moment stays locked for good in the child
+    if ( fNSubEventWorkers > 1 ) {
+      unsigned int nthreads = NThreads();
+      if ( nthreads > 1 )
+	throw cet::exception("G4Helper") << "sub-event worker processes can not be forked from a "
+					 << "process running " << nthreads << " threads (as art "
+					 << "jobs do); use one worker there, or a "
+					 << "single threaded driver";
+    }
+  }
+
+  //------------------------------------------------
+  void G4Helper::G4RunSubEvents()
+  {
+    this->CheckSubEventTracking();
+
+    UserActionManager* uam = UserActionManager::Instance();
+
+    // the sub-events reseed the global engine, which may be the one
+    // the caller (e.g. the art RandomNumberGenerator service) owns, so
+    // its state is put back at the end
+    CLHEP::HepRandomEngine*    engine      = CLHEP::HepRandom::getTheEngine();
+    std::vector<unsigned long> engineState = engine->put();
+
+    std::vector<size_t> counts = fConvertMCTruth->PartitionPrimaries(fNSubEvents);
+    const long spillSeed = SeedMix(fSubEventSeed, fNSubEventRuns++);
+
+    // per sub-event: largest track id and one buffer per UserAction
+    std::vector<G4int>                      maxTrackID(fNSubEvents, 0);
+    std::vector< std::vector<std::string> > buffers(fNSubEvents);
+
+    // tracks sub-event k into maxTrackID[k] and buffers[k]
+    auto track = [&](unsigned int k) {
+      if ( counts[k] == 0 ) return;
+      CLHEP::HepRandom::setTheSeed(SeedMix(spillSeed, k));
+      fConvertMCTruth->SelectSubEvent(k);
+      fUIManager->ApplyCommand("/run/beamOn 1");
+      maxTrackID[k] = uam->MaxTrackID();
+      uam->WriteSubEvent(buffers[k]);
+    };
+
+    if ( fNSubEventWorkers == 1 ) {
+      for ( unsigned int k = 0; k < fNSubEvents; ++k ) track(k);
+    }
+    else {
+      // each worker gets every nworkers-th sub-event and writes its
+      // results to an unlinked temporary file opened before the fork
+      const unsigned int nworkers = std::min(fNSubEventWorkers, fNSubEvents);
+      std::vector<FILE*> files;
+      std::vector<pid_t> pids;
+      for ( unsigned int w = 0; w < nworkers; ++w ) {
+	FILE* f = std::tmpfile();
+	if ( !f ) throw cet::exception("G4Helper") << "no temporary file for sub-event worker " << w;
+	files.push_back(f);
+
+	std::cout.flush();
+	std::fflush(0);
+	pid_t pid = fork();
+	if ( pid < 0 ) throw cet::exception("G4Helper") << "could not fork sub-event worker " << w;
+	if ( pid == 0 ) {
+	  // a worker never returns into the caller
+	  bool ok = true;
+	  for ( unsigned int k = w; k < fNSubEvents && ok; k += nworkers ) {
+	    try { track(k); }
+	    catch ( std::exception const& e ) {
+	      std::cerr << "G4Helper: sub-event " << k << ": " << e.what() << std::endl;
+	      ok = false;
+	      break;
+	    }
+	    uint32_t nbuf = buffers[k].size();
+	    ok = ( std::fwrite(&k,             sizeof(k),             1, f) == 1 &&
+		   std::fwrite(&maxTrackID[k], sizeof(maxTrackID[k]), 1, f) == 1 &&
+		   std::fwrite(&nbuf,          sizeof(nbuf),          1, f) == 1 );
+	    for ( uint32_t b = 0; b < nbuf && ok; ++b ) {
+	      uint64_t len = buffers[k][b].size();
+	      ok = ( std::fwrite(&len, sizeof(len), 1, f) == 1 &&
+		     ( len == 0 || std::fwrite(buffers[k][b].data(), len, 1, f) == 1 ) );
+	    }
+	  }
+	  ok = ok && ( std::fflush(f) == 0 );
+	  std::cout.flush();
+	  std::fflush(0);
+	  _exit(ok ? 0 : 1);
+	}
+	pids.push_back(pid);
+      }
+
+      bool ok = true;
+      for ( unsigned int w = 0; w < nworkers; ++w ) {
+	int status = 0;
+	waitpid(pids[w], &status, 0);
+	if ( !WIFEXITED(status) || WEXITSTATUS(status) != 0 ) {
+	  mf::LogError("G4Helper") << "sub-event worker " << w << " failed";
+	  ok = false;
+	  continue;
+	}
+
+	FILE* f = files[w];
+	std::rewind(f);
+	unsigned int k;
+	while ( ok && std::fread(&k, sizeof(k), 1, f) == 1 ) {
+	  uint32_t nbuf = 0;
+	  ok = ( k < fNSubEvents &&
+		 std::fread(&maxTrackID[k], sizeof(maxTrackID[k]), 1, f) == 1 &&
+		 std::fread(&nbuf,          sizeof(nbuf),          1, f) == 1 );
+	  if ( ok ) buffers[k].resize(nbuf);
+	  for ( uint32_t b = 0; b < nbuf && ok; ++b ) {
+	    uint64_t len = 0;
+	    ok = ( std::fread(&len, sizeof(len), 1, f) == 1 );
+	    if ( ok ) buffers[k][b].resize(len);
+	    ok = ok && ( len == 0 || std::fread(&buffers[k][b][0], len, 1, f) == 1 );
+	  }
+	}
+	if ( !ok ) mf::LogError("G4Helper") << "bad results from sub-event worker " << w;
+      }
+      for ( unsigned int w = 0; w < nworkers; ++w ) std::fclose(files[w]);
+      if ( !ok ) throw cet::exception("G4Helper") << "sub-event tracking failed";
+    }
+
+    // merge in sub-event order, each sub-event's track ids following
+    // the ones of the sub-events before it
+    uam->ClearSubEvents();
+    G4int offset = 0;
+    for ( unsigned int k = 0; k < fNSubEvents; ++k ) {
+      if ( counts[k] == 0 ) continue;
+      uam->MergeSubEvent(buffers[k], offset);
+      offset += maxTrackID[k];
+    }
+
+    fConvertMCTruth->SelectSubEvent(-1);
+    // this also leaves the engine in a state that does not depend on nWorkers
+    engine->get(engineState);
+  }
+
 } // namespace
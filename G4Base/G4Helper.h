@@ -30,8 +30,12 @@
 #include "Geant4/G4RunManager.hh"
 #include "Geant4/G4VUserParallelWorld.hh"
 
+#include "fhiclcpp/ParameterSet.h"
+
 // Forward declarations
 class G4UImanager;
+class G4IStore;
+class G4GeometrySampler;
 
 namespace simb{ class MCTruth;      }
 namespace sim { class ParticleList; }
@@ -43,6 +47,7 @@ namespace g4b {
   class ParticleListAction;
   class ConvertPrimaryToGeant4;
   class DetectorConstruction;
+  class RegionStepAction;
 
   class G4Helper {
 
@@ -59,9 +64,44 @@ namespace g4b {
     // parallel worlds.  G4Helper takes over ownership
     void SetParallelWorlds(std::vector<G4VUserParallelWorld*> pworlds);
 
+    // have to call this before InitPhysics if you want e+/e-/gammas
+    // above some energy in the listed volumes to be replaced by a
+    // parameterized shower (see EMShowerModel); the pset holds the
+    // envelope "Volumes" and the model parameters
+    void SetFastShower(fhicl::ParameterSet const& pset);
+
+    // have to call this before InitPhysics if you want production cuts
+    // or step limits per detector region.  The pset holds a list
+    //   Regions: [ { Name: "Rock" Volumes: [ "volRock" ]
+    //                RangeCut: 10.  MaxStepLength: 100. }, ... ]
+    // with lengths in cm; GammaCut, ElectronCut, PositronCut and
+    // ProtonCut override RangeCut (default 0.07) for one particle.
+    // A region named like an existing one (e.g. FastShowerRegion) is
+    // extended.  With StepSummary: true the steps per region are
+    // counted (RegionStepAction) and printed by PrintRegionSummary()
+    // and when the G4Helper is destroyed.
+    void SetRegions(fhicl::ParameterSet const& pset);
+    void PrintRegionSummary() const;
+
+    // have to call this before SetUserAction if you want geometry
+    // importance biasing: particles of the listed types are split when
+    // they cross into a cell of higher importance and played Russian
+    // roulette when they move to a lower one, their weight (G4Track and
+    // MCParticle::Weight) compensating.  The pset holds
+    //   Particles:  [ "neutron", "gamma" ]
+    //   Importances: [ { Volumes: [ "volRock" ]       Importance: 1 },
+    //                  { Volumes: [ "volCavernAir" ]  Importance: 4 }, ... ]
+    // with volumes given by physical or logical name; the remaining
+    // volumes get DefaultImportance (1).  With ParallelWorld set to the
+    // name of a parallel world the cells are its volumes instead, e.g.
+    // concentric shells around the detector.
+    void SetImportanceBiasing(fhicl::ParameterSet const& pset);
+
     // extra control over how GDML is parsed
     inline void SetOverlapCheck(bool check);
     inline void SetValidateGDMLSchema(bool validate);
+    // without the art MagneticField service there is no field
+    inline void SetUseFieldService(bool use);
 
     // have to call this before InitMC if you want to control
     // when the detector is constructed, useful if you need to 
@@ -91,11 +131,41 @@ namespace g4b {
     // Pass a single MCTruth object to G4
     bool G4Run(const simb::MCTruth* primary);
 
+    // Split the primaries of every G4Run call into nSubEvents sub-events
+    // of similar energy and track each as its own Geant4 event, spread
+    // over nWorkers forked processes (1 = tracked in this process).  The
+    // UserActions that provide a sub-event merge see one logical event:
+    // track ids of sub-event k are shifted past those of sub-events
+    // 0..k-1, so ids and MCTruthIndex do not depend on nWorkers.  Each
+    // sub-event reseeds the CLHEP engine from seed (0 = the current
+    // seed), the G4Run call count and its index; the engine state is
+    // restored when G4Run returns.  Geant4 here is sequential, so
+    // processes rather than threads do the work.
+    //
+    // Every UserAction must provide a sub-event merge, otherwise G4Run
+    // throws.  Worker processes are forked for every event, which is
+    // only safe in a single threaded process: with nWorkers > 1 G4Run
+    // throws if the process runs other threads.  An art job always does
+    // (the message logger has its own), and its threads are running
+    // before any module is constructed, so inside art the sub-events
+    // run one after the other in the job's process.  That gives the
+    // same results as any nWorkers, but no speed up: every sub-event
+    // costs a /run/beamOn of its own.  Concurrent sub-events need a
+    // single threaded driver, such as g4base_bench -e in Benchmarks.
+    void SetSubEventTracking(unsigned int nSubEvents,
+			     unsigned int nWorkers = 1,
+			     long         seed     = 0);
+
     G4RunManager* GetRunManager() { return fRunManager; }
 
   protected:
 
     void SetPhysicsList(std::string physicsList);
+    void ConstructFastShower();
+    void ConstructRegions();
+    void ConstructBiasing();
+    void G4RunSubEvents();
+    void CheckSubEventTracking() const;
 
     // These variables are "protected" rather than private, because I
     // can forsee that it may be desirable to derive other simulation
@@ -106,6 +176,7 @@ namespace g4b {
     std::string                        fGDMLFile;       ///< Name of the gdml file containing the detector Geometry
     bool                               fCheckOverlaps;  ///< Have G4GDML check for overlaps?
     bool                               fValidateGDMLSchema; ///< Have G4GDML validate geometry schema?
+    bool                               fUseFieldService; ///< Get the field from the MagneticField service?
 
     G4RunManager*         	       fRunManager;     ///< Geant4's run manager.		        
     G4UImanager*          	       fUIManager;      ///< Geant4's user-interface manager.		
@@ -113,6 +184,18 @@ namespace g4b {
                                                         ///< Geant4 event generator.
     DetectorConstruction* 	       fDetector;       ///< DetectorConstruction object   
     std::vector<G4VUserParallelWorld*> fParallelWorlds; ///< list of parallel worlds
+    bool                               fUseFastShower;  ///< parameterize EM showers?
+    fhicl::ParameterSet                fFastShowerPSet; ///< envelopes and shower model parameters
+    fhicl::ParameterSet                fRegionsPSet;    ///< region definitions, cuts and step limits
+    bool                               fUseStepLimits;  ///< some region has a MaxStepLength
+    RegionStepAction*                  fRegionSteps;    ///< steps per region, owned by the UserActionManager
+    fhicl::ParameterSet                fBiasingPSet;    ///< importance biasing configuration
+    G4IStore*                          fIStore;         ///< cell importances
+    std::vector<G4GeometrySampler*>    fSamplers;       ///< one per biased particle type
+    unsigned int                       fNSubEvents;     ///< sub-events per G4Run call, 0 = off
+    unsigned int                       fNSubEventWorkers; ///< processes tracking sub-events
+    long                               fSubEventSeed;   ///< base seed of the sub-events
+    long                               fNSubEventRuns;  ///< G4Run calls with sub-events so far
   };
 
 } // namespace g4b
@@ -120,6 +203,7 @@ namespace g4b {
 #ifndef __GCCXML__
 inline void g4b::G4Helper::SetOverlapCheck(bool check) { fCheckOverlaps = check; }
 inline void g4b::G4Helper::SetValidateGDMLSchema(bool validate) { fValidateGDMLSchema = validate; }
+inline void g4b::G4Helper::SetUseFieldService(bool use) { fUseFieldService = use; }
 #endif
 
 
@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  RegionStepAction.cxx
+/// \brief Count Geant4 steps and tracks per G4Region
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+#include "G4Base/RegionStepAction.h"
+#include "G4Base/SubEventBuffer.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+// self-register with the factory
+#include "G4Base/UserActionFactory.h"
+USERACTIONREG3(g4b,RegionStepAction,g4b::RegionStepAction)
+
+// G4 includes
+#include "Geant4/G4Track.hh"
+#include "Geant4/G4Step.hh"
+#include "Geant4/G4StepPoint.hh"
+#include "Geant4/G4VPhysicalVolume.hh"
+#include "Geant4/G4LogicalVolume.hh"
+#include "Geant4/G4Region.hh"
+#include "Geant4/G4RegionStore.hh"
+
+// C/C++ includes
+#include <iomanip>
+
+namespace g4b {
+
+  //-------------------------------------------------------------
+  // Constructor.
+  RegionStepAction::RegionStepAction()
+    : fLast(0)
+  {
+  }
+
+  //-------------------------------------------------------------
+  // Destructor.
+  RegionStepAction::~RegionStepAction()
+  {
+  }
+
+  //-------------------------------------------------------------
+  void RegionStepAction::Config(fhicl::ParameterSet const& /* pset */)
+  {
+  }
+
+  //-------------------------------------------------------------
+  void RegionStepAction::PrintConfig(std::string const& /* opt */)
+  {
+    mf::LogInfo("RegionStepAction") << "RegionStepAction::PrintConfig \n"
+				    << "    (no parameters)\n";
+  }
+
+  //-------------------------------------------------------------
+  RegionStepAction::Counts& RegionStepAction::Find(const G4Region* region)
+  {
+    if ( fLast < fCounts.size() && fCounts[fLast].region == region ) return fCounts[fLast];
+
+    for ( fLast = 0; fLast < fCounts.size(); ++fLast )
+      if ( fCounts[fLast].region == region ) return fCounts[fLast];
+
+    Counts c;
+    c.region   = region;
+    c.name     = ( region ) ? std::string(region->GetName()) : std::string("(none)");
+    c.nSteps   = 0;
+    c.nTracks  = 0;
+    c.evSteps  = 0;
+    c.evTracks = 0;
+    fCounts.push_back(c);
+    fLast = fCounts.size() - 1;
+    return fCounts.back();
+  }
+
+  //-------------------------------------------------------------
+  void RegionStepAction::BeginOfEventAction(const G4Event* /* event */)
+  {
+    for ( size_t i = 0; i < fCounts.size(); ++i ) {
+      fCounts[i].evSteps  = 0;
+      fCounts[i].evTracks = 0;
+    }
+  }
+
+  //-------------------------------------------------------------
+  void RegionStepAction::PreTrackingAction(const G4Track* track)
+  {
+    const G4VPhysicalVolume* pv = track->GetVolume();
+    Counts& c = this->Find( ( pv ) ? pv->GetLogicalVolume()->GetRegion() : 0 );
+    ++c.nTracks;
+    ++c.evTracks;
+  }
+
+  //-------------------------------------------------------------
+  void RegionStepAction::SteppingAction(const G4Step* step)
+  {
+    const G4VPhysicalVolume* pv = step->GetPreStepPoint()->GetPhysicalVolume();
+    Counts& c = this->Find( ( pv ) ? pv->GetLogicalVolume()->GetRegion() : 0 );
+    ++c.nSteps;
+    ++c.evSteps;
+  }
+
+  //-------------------------------------------------------------
+  void RegionStepAction::Summary() const
+  {
+    long steps = 0, tracks = 0;
+    for ( size_t i = 0; i < fCounts.size(); ++i ) {
+      steps  += fCounts[i].nSteps;
+      tracks += fCounts[i].nTracks;
+    }
+
+    mf::LogInfo log("RegionStepAction");
+    log << "steps and tracks per region \n";
+    for ( size_t i = 0; i < fCounts.size(); ++i ) {
+      Counts const& c = fCounts[i];
+      log << "    " << std::left << std::setw(32) << c.name << std::right
+	  << std::setw(14) << c.nSteps << " steps ("
+	  << std::fixed << std::setprecision(1) << std::setw(5)
+	  << ( steps > 0 ? 100.*c.nSteps/steps : 0. ) << "%) "
+	  << std::setw(12) << c.nTracks << " tracks\n";
+    }
+    log << "    " << std::left << std::setw(32) << "total" << std::right
+	<< std::setw(14) << steps << " steps         "
+	<< std::setw(12) << tracks << " tracks\n";
+  }
+
+  //-------------------------------------------------------------
+  void RegionStepAction::Reset()
+  {
+    fCounts.clear();
+    fLast = 0;
+  }
+
+  //-------------------------------------------------------------
+  // The counts of the sub-event come out of the totals here and go
+  // back in with the merge, so a sub-event tracked in this process is
+  // not counted twice.  G4Region pointers are the same in a forked
+  // worker, but the name is what identifies a region in the buffer.
+  void RegionStepAction::WriteSubEvent(std::string& buffer)
+  {
+    SubEventWriter out(buffer);
+    for ( size_t i = 0; i < fCounts.size(); ++i ) {
+      Counts& c = fCounts[i];
+      if ( c.evSteps == 0 && c.evTracks == 0 ) continue;
+      out.Put(c.name);
+      out.Put(c.evSteps);
+      out.Put(c.evTracks);
+      c.nSteps  -= c.evSteps;
+      c.nTracks -= c.evTracks;
+      c.evSteps  = 0;
+      c.evTracks = 0;
+    }
+  }
+
+  //-------------------------------------------------------------
+  void RegionStepAction::ClearSubEvents()
+  {
+    this->BeginOfEventAction(0);
+  }
+
+  //-------------------------------------------------------------
+  void RegionStepAction::MergeSubEvent(std::string const& buffer, int /* trackIDOffset */)
+  {
+    SubEventReader in(buffer);
+    while ( !in.AtEnd() ) {
+      std::string name;
+      long        nSteps  = 0;
+      long        nTracks = 0;
+      in.Get(name);
+      in.Get(nSteps);
+      in.Get(nTracks);
+
+      size_t i = 0;
+      while ( i < fCounts.size() && fCounts[i].name != name ) ++i;
+      if ( i == fCounts.size() ) {
+	// a region this process has not stepped in yet
+	G4Region* region = ( name == "(none)" ) ? 0 :
+	  G4RegionStore::GetInstance()->GetRegion(name, false);
+	this->Find(region);
+	i = fLast;
+      }
+      Counts& c = fCounts[i];
+      c.nSteps   += nSteps;
+      c.nTracks  += nTracks;
+      c.evSteps  += nSteps;
+      c.evTracks += nTracks;
+    }
+  }
+
+} // end namespace
@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  RegionStepAction.h
+/// \brief Count Geant4 steps and tracks per G4Region
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+/// This class implements the G4Base::UserAction interface to count the
+/// steps taken and the tracks started in each G4Region, to check where
+/// the simulation spends its time and what coarser production cuts or
+/// step limits (G4Helper::SetRegions) buy.  The counts add up over all
+/// Geant4 runs of the job; G4Run calls /run/beamOn once per event, so
+/// the end of a Geant4 run is the end of an event.  Summary() prints
+/// them, G4Helper does so when it is destroyed if it created the action.
+/// With sub-event tracking (G4Helper::SetSubEventTracking) each
+/// sub-event hands over the counts it added, keyed by region name, and
+/// the merge adds them to the totals of the process running the job.
+///
+/// The region of a step is the one of the volume at its pre-step point.
+/// Regions are looked up by pointer with the last one cached, there are
+/// rarely more than a handful.
+
+#ifndef G4BASE_REGIONSTEPACTION_H
+#define G4BASE_REGIONSTEPACTION_H
+
+#include <string>
+#include <vector>
+
+#include "G4Base/UserAction.h"
+
+// Forward declarations.
+class G4Run;
+class G4Event;
+class G4Track;
+class G4Step;
+class G4Region;
+
+namespace g4b {
+
+  class RegionStepAction : public g4b::UserAction {
+
+  public:
+    RegionStepAction();
+    virtual ~RegionStepAction();
+
+    void Config(fhicl::ParameterSet const& pset);
+    void PrintConfig(std::string const& opt);
+
+    void BeginOfEventAction(const G4Event*);
+    void PreTrackingAction(const G4Track*);
+    void SteppingAction(const G4Step*);
+
+    bool ProvidesSubEventMerge() { return true; }
+    void WriteSubEvent(std::string& buffer);
+    void ClearSubEvents();
+    void MergeSubEvent(std::string const& buffer, int trackIDOffset);
+
+    /// log the steps and tracks per region since construction or Reset()
+    void Summary() const;
+    void Reset();
+
+  private:
+
+    struct Counts {
+      const G4Region* region;   ///< 0 for steps outside any region
+      std::string     name;     ///< region name
+      long            nSteps;   ///< steps taken
+      long            nTracks;  ///< tracks started
+      long            evSteps;  ///< steps taken this event
+      long            evTracks; ///< tracks started this event
+    };
+
+    Counts& Find(const G4Region* region);
+
+    std::vector<Counts>  fCounts;  ///< per region, in order of appearance
+    size_t               fLast;    ///< index of the last region found
+  };
+
+} // namespace g4b
+
+#endif // G4BASE_REGIONSTEPACTION_H
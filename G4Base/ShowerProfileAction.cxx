@@ -0,0 +1,299 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  ShowerProfileAction.cxx
+/// \brief Record EM shower profiles to compare fast and full simulation
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+#include "G4Base/ShowerProfileAction.h"
+#include "G4Base/EnergySpot.h"
+#include "G4Base/SubEventBuffer.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+#include "cetlib/exception.h"
+
+// self-register with the factory
+#include "G4Base/UserActionFactory.h"
+USERACTIONREG3(g4b,ShowerProfileAction,g4b::ShowerProfileAction)
+
+// G4 includes
+#include "Geant4/G4Event.hh"
+#include "Geant4/G4Track.hh"
+#include "Geant4/G4Step.hh"
+#include "Geant4/G4StepPoint.hh"
+#include "Geant4/G4ParticleDefinition.hh"
+#include "Geant4/G4SystemOfUnits.hh"
+
+// ROOT includes
+#include "TFile.h"
+#include "TH1D.h"
+
+#include <cstdlib>
+#include <memory>
+
+namespace g4b {
+
+  //-------------------------------------------------------------
+  // Constructor.
+  ShowerProfileAction::ShowerProfileAction()
+    : fOutputFile("showerprofile.root")
+    , fX0(14.*cm)
+    , fRM(10.*cm)
+    , fNLongBins(60)
+    , fMaxDepth(30.)
+    , fNRadBins(50)
+    , fMaxRadius(5.)
+    , fMaxEnergy(10.)
+    , fHaveAxis(false)
+    , fEventEdep(0.)
+    , fEventStart(0)
+    , fEventCPU(0.)
+    , fPending(false)
+    , fNEvents(0)
+    , fLong(0)
+    , fRad(0)
+    , fEdep(0)
+    , fCPU(0)
+  {
+    this->Book();
+  }
+
+  //-------------------------------------------------------------
+  // Destructor.
+  ShowerProfileAction::~ShowerProfileAction()
+  {
+    this->Commit();
+    this->Write();
+
+    delete fLong;
+    delete fRad;
+    delete fEdep;
+    delete fCPU;
+  }
+
+  //-------------------------------------------------------------
+  void ShowerProfileAction::Config(fhicl::ParameterSet const& pset)
+  {
+    fOutputFile = pset.get< std::string >("OutputFile",      "showerprofile.root");
+    fX0         = pset.get< double      >("RadiationLength", 14.)*cm;
+    fRM         = pset.get< double      >("MoliereRadius",   10.)*cm;
+    fNLongBins  = pset.get< int         >("NLongBins",       60);
+    fMaxDepth   = pset.get< double      >("MaxDepth",        30.);
+    fNRadBins   = pset.get< int         >("NRadBins",        50);
+    fMaxRadius  = pset.get< double      >("MaxRadius",       5.);
+    fMaxEnergy  = pset.get< double      >("MaxEnergy",       10.);
+
+    this->Book();
+  }
+
+  //-------------------------------------------------------------
+  void ShowerProfileAction::PrintConfig(std::string const& /* opt */)
+  {
+    mf::LogInfo("ShowerProfileAction")
+      << "ShowerProfileAction::PrintConfig \n"
+      << "    OutputFile           " << fOutputFile      << "\n"
+      << "    RadiationLength      " << fX0/cm           << " cm\n"
+      << "    MoliereRadius        " << fRM/cm           << " cm\n"
+      << "    Longitudinal         " << fNLongBins       << " bins to " << fMaxDepth  << " X0\n"
+      << "    Radial               " << fNRadBins        << " bins to " << fMaxRadius << " RM\n"
+      << "    MaxEnergy            " << fMaxEnergy       << " GeV\n";
+  }
+
+  //-------------------------------------------------------------
+  void ShowerProfileAction::Book()
+  {
+    // the histograms belong to this action, not to whatever file is open
+    bool addDir = TH1::AddDirectoryStatus();
+    TH1::AddDirectory(false);
+
+    delete fLong;
+    delete fRad;
+    delete fEdep;
+    delete fCPU;
+    fLong = new TH1D("longitudinal", ";depth (X_{0});dE/dt (GeV/X_{0})",
+		     fNLongBins, 0., fMaxDepth);
+    fRad  = new TH1D("radial",       ";radius (R_{M});dE/dr (GeV/R_{M})",
+		     fNRadBins,  0., fMaxRadius);
+    fEdep = new TH1D("edep",         ";visible energy (GeV);events",
+		     200,        0., fMaxEnergy);
+    fCPU  = new TH1D("cpu",          ";cpu time per event (s);events",
+		     200,        0., 1.);
+    fCPU->SetBit(TH1::kCanRebin);
+
+    TH1::AddDirectory(addDir);
+    fNEvents = 0;
+    this->ResetEvent();
+  }
+
+  //-------------------------------------------------------------
+  void ShowerProfileAction::ResetEvent()
+  {
+    fHaveAxis  = false;
+    fEventEdep = 0.;
+    fEventCPU  = 0.;
+    fPending   = false;
+    // including under- and overflow
+    fEventLong.assign(fNLongBins + 2, 0.);
+    fEventRad .assign(fNRadBins  + 2, 0.);
+  }
+
+  //-------------------------------------------------------------
+  // Add the last event to the histograms.  This waits for the start
+  // of the next event so that sub-events can still be taken out and
+  // merged.
+  void ShowerProfileAction::Commit()
+  {
+    if ( !fPending ) return;
+    fPending = false;
+    if ( !fHaveAxis ) return;
+
+    ++fNEvents;
+    for ( size_t i = 0; i < fEventLong.size(); ++i )
+      if ( fEventLong[i] != 0. ) fLong->Fill(fLong->GetBinCenter(i), fEventLong[i]);
+    for ( size_t i = 0; i < fEventRad.size(); ++i )
+      if ( fEventRad[i]  != 0. ) fRad ->Fill(fRad ->GetBinCenter(i), fEventRad[i]);
+    fEdep->Fill(fEventEdep/GeV);
+    fCPU ->Fill(fEventCPU);
+  }
+
+  //-------------------------------------------------------------
+  void ShowerProfileAction::BeginOfEventAction(const G4Event* /* event */)
+  {
+    this->Commit();
+    this->ResetEvent();
+    fEventStart = std::clock();
+  }
+
+  //-------------------------------------------------------------
+  void ShowerProfileAction::PreTrackingAction(const G4Track* track)
+  {
+    if ( fHaveAxis || track->GetParentID() != 0 ) return;
+
+    int pdg = std::abs(track->GetDefinition()->GetPDGEncoding());
+    if ( pdg != 11 && pdg != 22 ) return;
+
+    fOrigin   = track->GetPosition();
+    fAxis     = track->GetMomentumDirection();
+    fHaveAxis = true;
+  }
+
+  //-------------------------------------------------------------
+  void ShowerProfileAction::Fill(G4ThreeVector const& pos, double edep)
+  {
+    if ( !fHaveAxis ) return;
+
+    G4ThreeVector d = pos - fOrigin;
+    double t = d.dot(fAxis);
+    double r = (d - t*fAxis).mag();
+
+    fEventLong[fLong->FindBin(t/fX0)] += edep/GeV;
+    fEventRad [fRad ->FindBin(r/fRM)] += edep/GeV;
+    fEventEdep += edep;
+  }
+
+  //-------------------------------------------------------------
+  void ShowerProfileAction::SteppingAction(const G4Step* step)
+  {
+    double edep = step->GetTotalEnergyDeposit();
+    if ( edep <= 0. ) return;
+
+    // weighted so that importance biasing leaves the profiles unbiased
+    this->Fill(0.5*(step->GetPreStepPoint()->GetPosition() +
+		    step->GetPostStepPoint()->GetPosition()),
+	       edep*step->GetTrack()->GetWeight());
+  }
+
+  //-------------------------------------------------------------
+  void ShowerProfileAction::EnergySpotAction(const EnergySpot& spot)
+  {
+    this->Fill(spot.position, spot.energy*spot.weight);
+  }
+
+  //-------------------------------------------------------------
+  void ShowerProfileAction::EndOfEventAction(const G4Event* /* event */)
+  {
+    fEventCPU = double(std::clock() - fEventStart)/CLOCKS_PER_SEC;
+    fPending  = true;
+  }
+
+  //-------------------------------------------------------------
+  // The sub-event is taken out here and comes back with the merge, so
+  // a sub-event tracked in this process is not counted twice.
+  void ShowerProfileAction::WriteSubEvent(std::string& buffer)
+  {
+    SubEventWriter out(buffer);
+    out.Put(fHaveAxis);
+    out.Put(fEventEdep);
+    out.Put(fEventCPU);
+    out.Put(fEventLong);
+    out.Put(fEventRad);
+    this->ResetEvent();
+  }
+
+  //-------------------------------------------------------------
+  void ShowerProfileAction::ClearSubEvents()
+  {
+    // the event before this one is still waiting when the sub-events
+    // ran in other processes
+    this->Commit();
+    this->ResetEvent();
+  }
+
+  //-------------------------------------------------------------
+  void ShowerProfileAction::MergeSubEvent(std::string const& buffer, int /* trackIDOffset */)
+  {
+    bool                haveAxis = false;
+    double              edep     = 0.;
+    double              cpu      = 0.;
+    std::vector<double> prof;
+    std::vector<double> rad;
+
+    SubEventReader in(buffer);
+    in.Get(haveAxis);
+    in.Get(edep);
+    in.Get(cpu);
+    in.Get(prof);
+    in.Get(rad);
+    if ( prof.size() != fEventLong.size() || rad.size() != fEventRad.size() )
+      throw cet::exception("ShowerProfileAction") << "sub-event profiles have "
+						  << prof.size() << " and " << rad.size()
+						  << " bins instead of " << fEventLong.size()
+						  << " and " << fEventRad.size();
+
+    fPending   = true;
+    fEventCPU += cpu;
+    if ( !haveAxis ) return;
+
+    fHaveAxis   = true;
+    fEventEdep += edep;
+    for ( size_t i = 0; i < prof.size(); ++i ) fEventLong[i] += prof[i];
+    for ( size_t i = 0; i < rad.size();  ++i ) fEventRad[i]  += rad[i];
+  }
+
+  //-------------------------------------------------------------
+  void ShowerProfileAction::Write() const
+  {
+    if ( fNEvents == 0 ) {
+      mf::LogWarning("ShowerProfileAction") << "no primary e+/e-/gamma seen, "
+					    << fOutputFile << " not written";
+      return;
+    }
+
+    // per event densities
+    std::unique_ptr<TH1D> lng(static_cast<TH1D*>(fLong->Clone()));
+    std::unique_ptr<TH1D> rad(static_cast<TH1D*>(fRad ->Clone()));
+    lng->Scale(1./(fNEvents*lng->GetBinWidth(1)));
+    rad->Scale(1./(fNEvents*rad->GetBinWidth(1)));
+
+    TFile f(fOutputFile.c_str(), "RECREATE");
+    lng ->Write();
+    rad ->Write();
+    fEdep->Write();
+    fCPU ->Write();
+    f.Close();
+
+    mf::LogInfo("ShowerProfileAction") << "wrote profiles of " << fNEvents
+				       << " showers to " << fOutputFile
+				       << ", mean cpu/event " << fCPU->GetMean() << " s";
+  }
+
+} // end namespace
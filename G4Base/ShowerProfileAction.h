@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  ShowerProfileAction.h
+/// \brief Record EM shower profiles to compare fast and full simulation
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+/// This UserAction histograms the longitudinal (in radiation lengths)
+/// and radial (in Moliere radii) energy profile of the shower started
+/// by the first primary e+, e- or gamma of each event, using both the
+/// G4Step deposits and the spots of a parameterized shower, together
+/// with the total visible energy and CPU time per event.  Deposits are
+/// weighted with the G4Track weight, as in VoxelEdepAction.  The
+/// histograms add up over all events of the job (G4Helper starts one
+/// Geant4 run per event) and are written to OutputFile when the action
+/// is deleted.
+///
+/// With sub-event tracking (G4Helper::SetSubEventTracking) each
+/// sub-event hands over its profiles, energy and CPU time and the
+/// merge adds them up into one event.  Every sub-event takes its shower
+/// axis from its own first e+, e- or gamma primary, so the profiles are
+/// only those of the full event when one sub-event holds the shower,
+/// as in the single particle samples this action is meant for.
+///
+/// Running the same single particle sample once with full simulation
+/// and once with G4Helper::SetFastShower, then comparing the two files
+/// with G4Base/scripts/compareShowerProfiles.C, validates the shower
+/// parameterization and measures the speed up.
+
+#ifndef G4BASE_SHOWERPROFILEACTION_H
+#define G4BASE_SHOWERPROFILEACTION_H
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "G4Base/UserAction.h"
+#include "Geant4/G4ThreeVector.hh"
+
+// Forward declarations.
+class G4Event;
+class G4Track;
+class G4Step;
+class TH1D;
+
+namespace g4b {
+
+  class ShowerProfileAction : public g4b::UserAction {
+
+  public:
+    ShowerProfileAction();
+    virtual ~ShowerProfileAction();
+
+    void Config(fhicl::ParameterSet const& pset);
+    void PrintConfig(std::string const& opt);
+
+    void BeginOfEventAction(const G4Event*);
+    void EndOfEventAction(const G4Event*);
+    void PreTrackingAction(const G4Track*);
+    void SteppingAction(const G4Step*);
+    void EnergySpotAction(const EnergySpot& spot);
+
+    bool ProvidesSubEventMerge() { return true; }
+    void WriteSubEvent(std::string& buffer);
+    void ClearSubEvents();
+    void MergeSubEvent(std::string const& buffer, int trackIDOffset);
+
+  private:
+
+    void Book();
+    void ResetEvent();
+    void Commit();
+    void Write() const;
+    void Fill(G4ThreeVector const& pos, double edep);
+
+    std::string         fOutputFile; ///< file the histograms are written to
+    double              fX0;         ///< radiation length of the detector material
+    double              fRM;         ///< Moliere radius of the detector material
+    int                 fNLongBins;  ///< number of longitudinal bins
+    double              fMaxDepth;   ///< longitudinal range, radiation lengths
+    int                 fNRadBins;   ///< number of radial bins
+    double              fMaxRadius;  ///< radial range, Moliere radii
+    double              fMaxEnergy;  ///< range of the visible energy histogram, GeV
+
+    bool                fHaveAxis;   ///< shower axis found for this event
+    G4ThreeVector       fOrigin;     ///< shower start
+    G4ThreeVector       fAxis;       ///< shower direction
+    double              fEventEdep;  ///< visible energy this event
+    std::clock_t        fEventStart; ///< cpu clock at the start of the event
+    double              fEventCPU;   ///< cpu time of this event, s
+    std::vector<double> fEventLong;  ///< this event's longitudinal profile, by bin of fLong
+    std::vector<double> fEventRad;   ///< this event's radial profile, by bin of fRad
+    bool                fPending;    ///< event done but not yet added to the histograms
+    int                 fNEvents;    ///< events with a shower
+
+    TH1D*               fLong;       ///< GeV per depth bin, summed over events
+    TH1D*               fRad;        ///< GeV per radius bin, summed over events
+    TH1D*               fEdep;       ///< visible energy per event
+    TH1D*               fCPU;        ///< cpu time per event
+  };
+
+} // namespace g4b
+
+#endif // G4BASE_SHOWERPROFILEACTION_H
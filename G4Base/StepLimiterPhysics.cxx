@@ -0,0 +1,51 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  StepLimiterPhysics.cxx
+/// \brief Attach G4StepLimiter to all charged particles
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+#include "G4Base/StepLimiterPhysics.h"
+
+#include "Geant4/G4StepLimiter.hh"
+#include "Geant4/G4ProcessManager.hh"
+#include "Geant4/G4ParticleDefinition.hh"
+#include "Geant4/G4ParticleTable.hh"
+
+namespace g4b {
+
+  //-------------------------------------------------------------
+  StepLimiterPhysics::StepLimiterPhysics(G4String const& name)
+    : G4VPhysicsConstructor(name)
+  {
+  }
+
+  //-------------------------------------------------------------
+  StepLimiterPhysics::~StepLimiterPhysics()
+  {
+  }
+
+  //-------------------------------------------------------------
+  void StepLimiterPhysics::ConstructParticle()
+  {
+    // the particles are constructed by the rest of the list
+  }
+
+  //-------------------------------------------------------------
+  void StepLimiterPhysics::ConstructProcess()
+  {
+    // neutral particles travel in straight lines and deposit nothing
+    // along the step, limiting them would only cost time
+    G4StepLimiter* limiter = new G4StepLimiter();
+
+    G4ParticleTable::G4PTblDicIterator* itr = G4ParticleTable::GetParticleTable()->GetIterator();
+    itr->reset();
+    while ( (*itr)() ) {
+      G4ParticleDefinition* particle = itr->value();
+      G4ProcessManager*     pmanager = particle->GetProcessManager();
+      if ( !pmanager || particle->GetPDGCharge() == 0. || particle->IsShortLived() ) continue;
+      pmanager->AddDiscreteProcess(limiter);
+    }
+  }
+
+} // namespace g4b
@@ -0,0 +1,32 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  StepLimiterPhysics.h
+/// \brief Attach G4StepLimiter to all charged particles
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+/// The maximum step length of a G4UserLimits is only honoured by
+/// particles that have G4StepLimiter in their process list.  G4Helper
+/// registers this constructor with the physics list when a region
+/// with a MaxStepLength has been configured (see G4Helper::SetRegions).
+
+#ifndef G4BASE_STEPLIMITERPHYSICS_H
+#define G4BASE_STEPLIMITERPHYSICS_H
+
+#include "Geant4/G4VPhysicsConstructor.hh"
+
+namespace g4b {
+
+  class StepLimiterPhysics : public G4VPhysicsConstructor {
+
+  public:
+    StepLimiterPhysics(G4String const& name = "StepLimiterPhysics");
+    virtual ~StepLimiterPhysics();
+
+    void ConstructParticle();
+    void ConstructProcess();
+  };
+
+} // namespace g4b
+
+#endif // G4BASE_STEPLIMITERPHYSICS_H
@@ -0,0 +1,93 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  SubEventBuffer.h
+/// \brief Byte buffers for the results of sub-events
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+/// With sub-event tracking (G4Helper::SetSubEventTracking) a
+/// UserAction hands the results of one Geant4 event over as a byte
+/// string, possibly to another process of the same executable.
+/// SubEventWriter appends plain values, strings and vectors of plain
+/// values to such a string; SubEventReader reads them back in the same
+/// order.  Values are copied bytewise, so only the layout of this
+/// build matters.
+
+#ifndef G4BASE_SUBEVENTBUFFER_H
+#define G4BASE_SUBEVENTBUFFER_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include "cetlib/exception.h"
+
+namespace g4b {
+
+  class SubEventWriter {
+  public:
+    explicit SubEventWriter(std::string& buffer) : fBuffer(buffer) {}
+
+    template <class T> void Put(T const& value)
+    {
+      fBuffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    void Put(std::string const& s)
+    {
+      this->Put<size_t>(s.size());
+      fBuffer.append(s);
+    }
+    template <class T> void Put(std::vector<T> const& v)
+    {
+      this->Put<size_t>(v.size());
+      if ( !v.empty() ) fBuffer.append(reinterpret_cast<const char*>(&v[0]), v.size()*sizeof(T));
+    }
+
+  private:
+    std::string& fBuffer;
+  };
+
+  class SubEventReader {
+  public:
+    explicit SubEventReader(std::string const& buffer) : fBuffer(buffer), fPos(0) {}
+
+    bool AtEnd() const { return fPos >= fBuffer.size(); }
+
+    template <class T> void Get(T& value)
+    {
+      this->Check(sizeof(T));
+      std::memcpy(&value, fBuffer.data() + fPos, sizeof(T));
+      fPos += sizeof(T);
+    }
+    void Get(std::string& s)
+    {
+      size_t n = 0;
+      this->Get<size_t>(n);
+      this->Check(n);
+      s.assign(fBuffer.data() + fPos, n);
+      fPos += n;
+    }
+    template <class T> void Get(std::vector<T>& v)
+    {
+      size_t n = 0;
+      this->Get<size_t>(n);
+      this->Check(n*sizeof(T));
+      v.resize(n);
+      if ( n ) std::memcpy(&v[0], fBuffer.data() + fPos, n*sizeof(T));
+      fPos += n*sizeof(T);
+    }
+
+  private:
+    void Check(size_t n) const
+    {
+      if ( fPos + n > fBuffer.size() )
+	throw cet::exception("SubEventReader") << "read past the end of a "
+					       << fBuffer.size() << " byte sub-event buffer";
+    }
+
+    std::string const& fBuffer;
+    size_t             fPos;
+  };
+
+} // namespace g4b
+
+#endif // G4BASE_SUBEVENTBUFFER_H
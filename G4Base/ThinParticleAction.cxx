@@ -0,0 +1,336 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  ThinParticleAction.cxx
+/// \brief Build simb::MCParticles with thinned trajectories while tracking
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+#include "G4Base/ThinParticleAction.h"
+#include "G4Base/SubEventBuffer.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+// self-register with the factory
+#include "G4Base/UserActionFactory.h"
+USERACTIONREG3(g4b,ThinParticleAction,g4b::ThinParticleAction)
+
+// G4 includes
+#include "Geant4/G4Event.hh"
+#include "Geant4/G4Track.hh"
+#include "Geant4/G4Step.hh"
+#include "Geant4/G4StepPoint.hh"
+#include "Geant4/G4VProcess.hh"
+#include "Geant4/G4ParticleDefinition.hh"
+#include "Geant4/G4SystemOfUnits.hh"
+
+#include <cstdlib>
+
+namespace g4b {
+
+  //-------------------------------------------------------------
+  // Constructor.
+  ThinParticleAction::ThinParticleAction()
+    : fMargin(0.1)
+    , fMinKE(0.001)
+    , fEMMinKE(0.01)
+    , fMaxBuffer(64)
+    , fReserve(1000)
+    , fNParticles(0)
+    , fCurrent(0)
+    , fHaveLast(false)
+  {
+  }
+
+  //-------------------------------------------------------------
+  // Destructor.
+  ThinParticleAction::~ThinParticleAction()
+  {
+  }
+
+  //-------------------------------------------------------------
+  void ThinParticleAction::Config(fhicl::ParameterSet const& pset)
+  {
+    fMargin    = pset.get< double >("Margin",             0.1  );
+    fMinKE     = pset.get< double >("MinKineticEnergy",   0.001);
+    fEMMinKE   = pset.get< double >("EMMinKineticEnergy", 0.01 );
+    fMaxBuffer = pset.get< size_t >("MaxBuffer",          64   );
+    fReserve   = pset.get< size_t >("ReserveParticles",   1000 );
+
+    fParticles   .resize(fReserve);
+    fFoldedEnergy.resize(fReserve, 0.);
+    fTracks      .reserve(4*fReserve);
+    fBuffer      .reserve(fMaxBuffer);
+  }
+
+  //-------------------------------------------------------------
+  void ThinParticleAction::PrintConfig(std::string const& /* opt */)
+  {
+    mf::LogInfo("ThinParticleAction")
+      << "ThinParticleAction::PrintConfig \n"
+      << "    Margin               " << fMargin    << " cm\n"
+      << "    MinKineticEnergy     " << fMinKE     << " GeV\n"
+      << "    EMMinKineticEnergy   " << fEMMinKE   << " GeV\n"
+      << "    MaxBuffer            " << fMaxBuffer << "\n"
+      << "    ReserveParticles     " << fReserve   << "\n";
+  }
+
+  //-------------------------------------------------------------
+  void ThinParticleAction::BeginOfEventAction(const G4Event* /* event */)
+  {
+    // keep the arena, only forget what is in it
+    fNParticles = 0;
+    fTracks.clear();
+    fCurrent = 0;
+  }
+
+  //-------------------------------------------------------------
+  ThinParticleAction::TrackInfo& ThinParticleAction::Info(int trackID)
+  {
+    if ( (size_t)trackID >= fTracks.size() ) {
+      TrackInfo unknown = { -1, false };
+      fTracks.resize(trackID + 1, unknown);
+    }
+    return fTracks[trackID];
+  }
+
+  //-------------------------------------------------------------
+  void ThinParticleAction::PreTrackingAction(const G4Track* track)
+  {
+    const int    trackID  = track->GetTrackID();
+    const int    parentID = track->GetParentID();
+    const int    pdg      = track->GetDefinition()->GetPDGEncoding();
+    const double ke       = track->GetKineticEnergy()/GeV;
+
+    fCurrent  = 0;
+    fHaveLast = false;
+    fBuffer.clear();
+
+    // the parent's bookkeeping, copied since Info() may grow fTracks;
+    // slot is the nearest recorded ancestor, -1 for primaries
+    TrackInfo parent = { -1, false };
+    if ( parentID > 0 ) parent = this->Info(parentID);
+    const int ancestor = parent.slot;
+
+    if ( parentID > 0 && ancestor >= 0 ) {
+      // whatever a dropped track produces is dropped with it: the
+      // kinetic energy folded for the dropped track already includes
+      // theirs, so they are neither recorded nor folded again
+      bool drop = !parent.recorded;
+      if ( !drop ) {
+	int    apdg = std::abs(pdg);
+	double thr  = ( apdg == 11 || apdg == 22 ) ? fEMMinKE : fMinKE;
+	if ( ke < thr ) {
+	  fFoldedEnergy[ancestor] += ke;
+	  drop = true;
+	}
+      }
+      if ( drop ) {
+	TrackInfo& info = this->Info(trackID);
+	info.slot     = ancestor;
+	info.recorded = false;
+	return;
+      }
+    }
+
+    fCurrent = &this->NextSlot();
+    const int slot = fNParticles - 1;
+
+    std::string process("primary");
+    if ( track->GetCreatorProcess() ) process = track->GetCreatorProcess()->GetProcessName();
+
+    // the parent of a recorded secondary is always recorded
+    int mother = ( ancestor >= 0 ) ? fParticles[ancestor].TrackId() : parentID;
+
+    *fCurrent = simb::MCParticle(trackID, pdg, process, mother,
+				 track->GetDefinition()->GetPDGMass()/GeV);
+    // not 1 with importance biasing (G4Helper::SetImportanceBiasing)
+    fCurrent->SetWeight(track->GetWeight());
+    if ( ancestor >= 0 ) fParticles[ancestor].AddDaughter(trackID);
+
+    TrackInfo& info = this->Info(trackID);
+    info.slot     = slot;
+    info.recorded = true;
+
+    const G4ThreeVector& pos = track->GetPosition();
+    const G4ThreeVector& mom = track->GetMomentum();
+    fAnchorPos.SetXYZT(pos.x()/cm, pos.y()/cm, pos.z()/cm, track->GetGlobalTime()/ns);
+    fCurrent->AddTrajectoryPoint(fAnchorPos,
+				 TLorentzVector(mom.x()/GeV, mom.y()/GeV, mom.z()/GeV,
+						track->GetTotalEnergy()/GeV));
+  }
+
+  //-------------------------------------------------------------
+  // take the next slot of the arena, growing it only when needed
+  simb::MCParticle& ThinParticleAction::NextSlot()
+  {
+    if ( fNParticles == fParticles.size() ) {
+      fParticles   .resize(2*fParticles.size() + 1);
+      fFoldedEnergy.resize(fParticles.size(), 0.);
+    }
+    fFoldedEnergy[fNParticles] = 0.;
+    return fParticles[fNParticles++];
+  }
+
+  //-------------------------------------------------------------
+  void ThinParticleAction::AddPoint(TLorentzVector const& pos, TLorentzVector const& mom)
+  {
+    if ( fHaveLast ) {
+      // can the line from the anchor to the new point stand in for
+      // the last point and everything skipped before it?
+      bool ok = ( fBuffer.size() < fMaxBuffer );
+      const TVector3 a   = fAnchorPos.Vect();
+      const TVector3 ab  = pos.Vect() - a;
+      const double   len = ab.Mag();
+      const double   m2  = fMargin*fMargin;
+      if ( ok && len > 0. ) {
+	const TVector3 dir = ab*(1./len);
+	fBuffer.push_back(fLastPos.Vect());
+	for ( size_t i = 0; i < fBuffer.size() && ok; ++i ) {
+	  const TVector3 d = fBuffer[i] - a;
+	  ok = ( (d - dir.Dot(d)*dir).Mag2() <= m2 );
+	}
+	if ( !ok ) fBuffer.pop_back();
+      }
+      else ok = false;
+
+      if ( !ok ) {
+	fCurrent->AddTrajectoryPoint(fLastPos, fLastMom);
+	fAnchorPos = fLastPos;
+	fBuffer.clear();
+      }
+    }
+
+    fLastPos  = pos;
+    fLastMom  = mom;
+    fHaveLast = true;
+  }
+
+  //-------------------------------------------------------------
+  void ThinParticleAction::SteppingAction(const G4Step* step)
+  {
+    if ( !fCurrent ) return;
+
+    const G4StepPoint*   post = step->GetPostStepPoint();
+    const G4ThreeVector& pos  = post->GetPosition();
+    const G4ThreeVector& mom  = post->GetMomentum();
+
+    this->AddPoint(TLorentzVector(pos.x()/cm,  pos.y()/cm,  pos.z()/cm,  post->GetGlobalTime()/ns),
+		   TLorentzVector(mom.x()/GeV, mom.y()/GeV, mom.z()/GeV, post->GetTotalEnergy()/GeV));
+  }
+
+  //-------------------------------------------------------------
+  void ThinParticleAction::PostTrackingAction(const G4Track* track)
+  {
+    if ( !fCurrent ) return;
+
+    // the end point is always kept
+    if ( fHaveLast ) fCurrent->AddTrajectoryPoint(fLastPos, fLastMom);
+
+    // importance biasing changes the weight of a track when it is split
+    // or survives Russian roulette, so take it again at the end
+    fCurrent->SetWeight(track->GetWeight());
+
+    const G4Step* step = track->GetStep();
+    if ( step && step->GetPostStepPoint()->GetProcessDefinedStep() )
+      fCurrent->SetEndProcess(step->GetPostStepPoint()->GetProcessDefinedStep()->GetProcessName());
+
+    fCurrent  = 0;
+    fHaveLast = false;
+    fBuffer.clear();
+  }
+
+  //-------------------------------------------------------------
+  void ThinParticleAction::EndOfEventAction(const G4Event* /* event */)
+  {
+    LOG_DEBUG("ThinParticleAction") << fNParticles << " particles recorded of "
+				    << fTracks.size() << " track ids";
+  }
+
+  //-------------------------------------------------------------
+  // only what PreTrackingAction and PostTrackingAction fill in
+  void ThinParticleAction::WriteSubEvent(std::string& buffer)
+  {
+    SubEventWriter out(buffer);
+    out.Put(fNParticles);
+    std::vector<int>    daughters;
+    std::vector<double> points;
+    for ( size_t i = 0; i < fNParticles; ++i ) {
+      simb::MCParticle const& part = fParticles[i];
+      out.Put(part.TrackId());
+      out.Put(part.PdgCode());
+      out.Put(part.Mother());
+      out.Put(part.Mass());
+      out.Put(part.Weight());
+      out.Put(part.Process());
+      out.Put(part.EndProcess());
+      out.Put(fFoldedEnergy[i]);
+
+      daughters.resize(part.NumberDaughters());
+      for ( size_t d = 0; d < daughters.size(); ++d ) daughters[d] = part.Daughter(d);
+      out.Put(daughters);
+
+      points.clear();
+      for ( unsigned int p = 0; p < part.NumberTrajectoryPoints(); ++p ) {
+	TLorentzVector const& pos = part.Position(p);
+	TLorentzVector const& mom = part.Momentum(p);
+	double pt[8] = { pos.X(), pos.Y(), pos.Z(), pos.T(),
+			 mom.Px(), mom.Py(), mom.Pz(), mom.E() };
+	points.insert(points.end(), pt, pt + 8);
+      }
+      out.Put(points);
+    }
+  }
+
+  //-------------------------------------------------------------
+  void ThinParticleAction::ClearSubEvents()
+  {
+    fNParticles = 0;
+    fTracks.clear();
+    fCurrent = 0;
+  }
+
+  //-------------------------------------------------------------
+  void ThinParticleAction::MergeSubEvent(std::string const& buffer, int trackIDOffset)
+  {
+    SubEventReader in(buffer);
+    size_t n = 0;
+    in.Get(n);
+    std::vector<int>    daughters;
+    std::vector<double> points;
+    for ( size_t i = 0; i < n; ++i ) {
+      int         trackID, pdg, mother;
+      double      mass, weight, folded;
+      std::string process, endProcess;
+      in.Get(trackID);
+      in.Get(pdg);
+      in.Get(mother);
+      in.Get(mass);
+      in.Get(weight);
+      in.Get(process);
+      in.Get(endProcess);
+      in.Get(folded);
+      in.Get(daughters);
+      in.Get(points);
+
+      // primaries keep their mother 0
+      if ( mother > 0 ) mother += trackIDOffset;
+
+      simb::MCParticle& part = this->NextSlot();
+      part = simb::MCParticle(trackID + trackIDOffset, pdg, process, mother, mass);
+      part.SetEndProcess(endProcess);
+      part.SetWeight(weight);
+      fFoldedEnergy[fNParticles - 1] = folded;
+      for ( size_t d = 0; d < daughters.size(); ++d ) part.AddDaughter(daughters[d] + trackIDOffset);
+      for ( size_t p = 0; p + 8 <= points.size(); p += 8 )
+	part.AddTrajectoryPoint(TLorentzVector(points[p],   points[p+1], points[p+2], points[p+3]),
+				TLorentzVector(points[p+4], points[p+5], points[p+6], points[p+7]));
+    }
+  }
+
+  //-------------------------------------------------------------
+  void ThinParticleAction::CopyParticles(std::vector<simb::MCParticle>& particles) const
+  {
+    particles.reserve(particles.size() + fNParticles);
+    particles.insert(particles.end(), fParticles.begin(), fParticles.begin() + fNParticles);
+  }
+
+} // end namespace
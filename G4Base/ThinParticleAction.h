@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  ThinParticleAction.h
+/// \brief Build simb::MCParticles with thinned trajectories while tracking
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+/// This class implements the G4Base::UserAction interface to fill
+/// simb::MCParticles directly from Geant4 tracks.
+///
+/// Rather than storing every step and calling
+/// MCTrajectory::Sparsify() at the end of the event, the trajectory is
+/// thinned as the track is stepped: the last kept point is held as an
+/// anchor and the points seen since are kept in a small buffer.  A new
+/// step point is accepted as long as every buffered point lies within
+/// Margin of the straight line from the anchor to it; otherwise the
+/// previous point is written to the trajectory and becomes the new
+/// anchor.  The result satisfies the same margin guarantee as
+/// Sparsify() without ever holding the full trajectory.
+///
+/// The Weight() of each particle is the G4Track weight at the end of
+/// its tracking, which differs from 1 with importance biasing.
+///
+/// Secondaries of recorded particles with a kinetic energy below
+/// threshold are not recorded, and neither is anything they produce,
+/// whatever its energy.  The kinetic energy of the dropped secondary,
+/// which already includes that of its descendants, is added to the
+/// FoldedEnergy() of its recorded parent; nothing else is folded, so
+/// no energy is counted twice.  The dropped tracks are still tracked,
+/// so other UserActions see all of their steps.
+///
+/// The MCParticles live in an arena that is reserved in Config() and
+/// reused from event to event, so the trajectory storage of earlier
+/// events is recycled rather than reallocated.  Units are cm, ns and
+/// GeV as in the rest of nutools.
+///
+/// Geant4 in nutools runs sequentially; each instance keeps its own
+/// state, so one action per worker thread needs no locking.
+///
+/// With sub-event tracking the particles of each sub-event are merged
+/// in sub-event order, with their track ids (and those of their mothers
+/// and daughters) shifted past the ones of the sub-events before.
+
+#ifndef G4BASE_THINPARTICLEACTION_H
+#define G4BASE_THINPARTICLEACTION_H
+
+#include <vector>
+#include <string>
+
+#include "G4Base/UserAction.h"
+#include "SimulationBase/MCParticle.h"
+
+#include "TLorentzVector.h"
+
+// Forward declarations.
+class G4Event;
+class G4Track;
+class G4Step;
+
+namespace g4b {
+
+  class ThinParticleAction : public g4b::UserAction {
+
+  public:
+    ThinParticleAction();
+    virtual ~ThinParticleAction();
+
+    void Config(fhicl::ParameterSet const& pset);
+    void PrintConfig(std::string const& opt);
+
+    void BeginOfEventAction(const G4Event*);
+    void EndOfEventAction(const G4Event*);
+    void PreTrackingAction(const G4Track*);
+    void PostTrackingAction(const G4Track*);
+    void SteppingAction(const G4Step*);
+
+    bool ProvidesSubEventMerge() { return true; }
+    void WriteSubEvent(std::string& buffer);
+    void ClearSubEvents();
+    void MergeSubEvent(std::string const& buffer, int trackIDOffset);
+
+    /// particles recorded in the current event, in the order they were
+    /// tracked; valid until the next BeginOfEventAction
+    size_t                    NParticles()              const { return fNParticles;      }
+    simb::MCParticle   const& Particle(size_t i)        const { return fParticles[i];    }
+    /// kinetic energy (GeV) of the dropped secondaries of particle i
+    double                    FoldedEnergy(size_t i)    const { return fFoldedEnergy[i]; }
+
+    /// append copies of the recorded particles to a data product
+    void CopyParticles(std::vector<simb::MCParticle>& particles) const;
+
+  private:
+
+    /// slot of a recorded particle, or of the recorded ancestor of a
+    /// dropped one; indexed by G4 track id
+    struct TrackInfo {
+      int  slot;
+      bool recorded;
+    };
+
+    TrackInfo&        Info(int trackID);
+    void              AddPoint(TLorentzVector const& pos, TLorentzVector const& mom);
+    simb::MCParticle& NextSlot();
+
+    double                         fMargin;        ///< thinning margin (cm)
+    double                         fMinKE;         ///< threshold for secondaries (GeV)
+    double                         fEMMinKE;       ///< threshold for secondary e+/e-/gamma (GeV)
+    size_t                         fMaxBuffer;     ///< force a point after this many skipped
+    size_t                         fReserve;       ///< particles reserved in the arena
+
+    std::vector<simb::MCParticle>  fParticles;     ///< arena, only the first fNParticles are valid
+    std::vector<double>            fFoldedEnergy;  ///< folded kinetic energy per slot (GeV)
+    size_t                         fNParticles;    ///< particles recorded this event
+    std::vector<TrackInfo>         fTracks;        ///< per G4 track id bookkeeping
+
+    // thinning state of the track being stepped
+    simb::MCParticle*              fCurrent;       ///< particle being filled, 0 if not recorded
+    TLorentzVector                 fAnchorPos;     ///< last kept position
+    TLorentzVector                 fLastPos;       ///< last seen position
+    TLorentzVector                 fLastMom;       ///< last seen momentum
+    bool                           fHaveLast;      ///< fLastPos holds an unwritten point
+    std::vector<TVector3>          fBuffer;        ///< skipped points since the anchor
+  };
+
+} // namespace g4b
+
+#endif // G4BASE_THINPARTICLEACTION_H
@@ -0,0 +1,309 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  TrackKillAction.cxx
+/// \brief Stacking policy that kills or defers tracks by type, energy and region
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+#include "G4Base/TrackKillAction.h"
+#include "G4Base/SubEventBuffer.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+#include "cetlib/exception.h"
+
+// self-register with the factory
+#include "G4Base/UserActionFactory.h"
+USERACTIONREG3(g4b,TrackKillAction,g4b::TrackKillAction)
+
+// G4 includes
+#include "Geant4/G4Run.hh"
+#include "Geant4/G4Event.hh"
+#include "Geant4/G4Track.hh"
+#include "Geant4/G4ParticleDefinition.hh"
+#include "Geant4/G4VPhysicalVolume.hh"
+#include "Geant4/G4LogicalVolume.hh"
+#include "Geant4/G4LogicalVolumeStore.hh"
+#include "Geant4/G4Region.hh"
+#include "Geant4/G4RegionStore.hh"
+#include "Geant4/G4SystemOfUnits.hh"
+
+// C/C++ includes
+#include <algorithm>
+
+namespace g4b {
+
+  //-------------------------------------------------------------
+  // Constructor.
+  TrackKillAction::TrackKillAction()
+    : fKeepPrimaries(true)
+    , fVerbose(0)
+    , fEventKilledEnergy(0.)
+    , fEventKilledTracks(0)
+  {
+  }
+
+  //-------------------------------------------------------------
+  // Destructor.
+  TrackKillAction::~TrackKillAction()
+  {
+  }
+
+  //-------------------------------------------------------------
+  void TrackKillAction::Config(fhicl::ParameterSet const& pset)
+  {
+    fKeepPrimaries = pset.get< bool >("KeepPrimaries", true);
+    fVerbose       = pset.get< int  >("Verbose",       0);
+
+    std::vector<fhicl::ParameterSet> rules = pset.get< std::vector<fhicl::ParameterSet> >("Rules");
+
+    fRules.clear();
+    for ( size_t i = 0; i < rules.size(); ++i ) {
+      Rule r;
+      r.name        = rules[i].get< std::string              >("Name",             "rule");
+      r.pdgCodes    = rules[i].get< std::vector<int>         >("PDGCodes",         std::vector<int>());
+      r.maxKE       = rules[i].get< double                   >("MaxKineticEnergy", 1.e30)*GeV;
+      r.volumeNames = rules[i].get< std::vector<std::string> >("Volumes",          std::vector<std::string>());
+      r.regionNames = rules[i].get< std::vector<std::string> >("Regions",          std::vector<std::string>());
+      r.anywhere    = ( r.volumeNames.empty() && r.regionNames.empty() );
+      r.nTracks     = 0;
+      r.energy      = 0.;
+
+      std::string action = rules[i].get< std::string >("Action", "Kill");
+      if      ( action == "Kill" ) r.action = fKill;
+      else if ( action == "Wait" ) r.action = fWaiting;
+      else
+	throw cet::exception("TrackKillAction") << "rule " << r.name
+						<< ": Action must be Kill or Wait, not " << action;
+
+      std::sort(r.pdgCodes.begin(), r.pdgCodes.end());
+      fRules.push_back(r);
+    }
+  }
+
+  //-------------------------------------------------------------
+  void TrackKillAction::PrintConfig(std::string const& /* opt */)
+  {
+    mf::LogInfo log("TrackKillAction");
+    log << "TrackKillAction::PrintConfig \n"
+	<< "    KeepPrimaries        " << fKeepPrimaries << "\n"
+	<< "    Verbose              " << fVerbose       << "\n";
+    for ( size_t i = 0; i < fRules.size(); ++i ) {
+      Rule const& r = fRules[i];
+      log << "    Rule " << r.name << ": "
+	  << ( r.action == fKill ? "Kill" : "Wait" )
+	  << " KE < " << r.maxKE/GeV << " GeV, pdg";
+      if ( r.pdgCodes.empty() ) log << " any";
+      for ( size_t j = 0; j < r.pdgCodes.size(); ++j ) log << " " << r.pdgCodes[j];
+      if ( r.anywhere ) log << ", anywhere";
+      for ( size_t j = 0; j < r.volumeNames.size(); ++j ) log << ", volume " << r.volumeNames[j];
+      for ( size_t j = 0; j < r.regionNames.size(); ++j ) log << ", region " << r.regionNames[j];
+      log << "\n";
+    }
+  }
+
+  //-------------------------------------------------------------
+  void TrackKillAction::BeginOfRunAction(const G4Run* /* run */)
+  {
+    /// Resolve the volume and region names of every rule to logical
+    /// volume pointers; the geometry is closed by now.
+
+    G4LogicalVolumeStore* lvStore  = G4LogicalVolumeStore::GetInstance();
+    G4RegionStore*        regStore = G4RegionStore::GetInstance();
+
+    for ( size_t i = 0; i < fRules.size(); ++i ) {
+      Rule& r = fRules[i];
+      r.volumes.clear();
+      r.nTracks = 0;
+      r.energy  = 0.;
+
+      for ( size_t j = 0; j < r.volumeNames.size(); ++j ) {
+	size_t nfound = 0;
+	for ( G4LogicalVolumeStore::iterator lv = lvStore->begin(); lv != lvStore->end(); ++lv ) {
+	  if ( (*lv)->GetName() == r.volumeNames[j] ) {
+	    r.volumes.push_back(*lv);
+	    ++nfound;
+	  }
+	}
+	if ( nfound == 0 )
+	  mf::LogWarning("TrackKillAction") << "rule " << r.name
+					    << ": no logical volume named " << r.volumeNames[j];
+      }
+
+      // a region owns every logical volume whose region pointer is set to it,
+      // including daughters that inherited it from a root volume
+      for ( size_t j = 0; j < r.regionNames.size(); ++j ) {
+	G4Region* region = regStore->GetRegion(r.regionNames[j], false);
+	if ( !region ) {
+	  mf::LogWarning("TrackKillAction") << "rule " << r.name
+					    << ": no region named " << r.regionNames[j];
+	  continue;
+	}
+	for ( G4LogicalVolumeStore::iterator lv = lvStore->begin(); lv != lvStore->end(); ++lv )
+	  if ( (*lv)->GetRegion() == region ) r.volumes.push_back(*lv);
+      }
+
+      std::sort(r.volumes.begin(), r.volumes.end());
+      r.volumes.erase(std::unique(r.volumes.begin(), r.volumes.end()), r.volumes.end());
+
+      if ( !r.anywhere && r.volumes.empty() )
+	mf::LogWarning("TrackKillAction") << "rule " << r.name << " matches no volumes and will never fire";
+
+      LOG_DEBUG("TrackKillAction") << "rule " << r.name << " covers "
+				   << r.volumes.size() << " logical volumes";
+    }
+
+    fKilledByPDG.clear();
+  }
+
+  //-------------------------------------------------------------
+  void TrackKillAction::BeginOfEventAction(const G4Event* /* event */)
+  {
+    fEventKilledEnergy = 0.;
+    fEventKilledTracks = 0;
+  }
+
+  //-------------------------------------------------------------
+  G4ClassificationOfNewTrack
+  TrackKillAction::StackClassifyNewTrack(const G4Track* track)
+  {
+    if ( fKeepPrimaries && track->GetParentID() == 0 ) return fUrgent;
+
+    const double ke  = track->GetKineticEnergy();
+    const int    pdg = track->GetDefinition()->GetPDGEncoding();
+    // the energy sums stand for the unbiased event, so weight them
+    const double wke = ke*track->GetWeight()/GeV;
+
+    // primaries have no touchable yet, secondaries carry the one of
+    // the step that created them
+    const G4VPhysicalVolume* pv = track->GetVolume();
+    const G4LogicalVolume*   lv = ( pv ) ? pv->GetLogicalVolume() : 0;
+
+    for ( size_t i = 0; i < fRules.size(); ++i ) {
+      Rule& r = fRules[i];
+      if ( ke >= r.maxKE ) continue;
+      if ( !r.pdgCodes.empty() &&
+	   !std::binary_search(r.pdgCodes.begin(), r.pdgCodes.end(), pdg) ) continue;
+      if ( !r.anywhere &&
+	   ( !lv || !std::binary_search(r.volumes.begin(), r.volumes.end(), lv) ) ) continue;
+
+      ++r.nTracks;
+      r.energy += wke;
+      if ( r.action == fKill ) {
+	fEventKilledEnergy += wke;
+	++fEventKilledTracks;
+	std::pair<long,double>& byPDG = fKilledByPDG[pdg];
+	++byPDG.first;
+	byPDG.second += wke;
+      }
+
+      if ( fVerbose > 1 )
+	mf::LogInfo("TrackKillAction") << "rule " << r.name << " "
+				       << ( r.action == fKill ? "killed" : "deferred" )
+				       << " track " << track->GetTrackID()
+				       << " pdg " << pdg << " KE " << ke/GeV << " GeV";
+
+      return r.action;
+    }
+
+    return fUrgent;
+  }
+
+  //-------------------------------------------------------------
+  void TrackKillAction::EndOfRunAction(const G4Run* /* run */)
+  {
+    if ( fVerbose < 1 ) return;
+
+    mf::LogInfo log("TrackKillAction");
+    log << "TrackKillAction summary \n";
+    for ( size_t i = 0; i < fRules.size(); ++i )
+      log << "    rule " << fRules[i].name << ": "
+	  << fRules[i].nTracks << " tracks, "
+	  << fRules[i].energy  << " GeV kinetic energy\n";
+    for ( std::map<int, std::pair<long,double> >::const_iterator itr = fKilledByPDG.begin();
+	  itr != fKilledByPDG.end(); ++itr )
+      log << "    killed pdg " << itr->first << ": "
+	  << itr->second.first  << " tracks, "
+	  << itr->second.second << " GeV\n";
+  }
+
+  //-------------------------------------------------------------
+  // Every sub-event is a Geant4 run of its own, so the run counters
+  // hold the ones of the sub-event when it is written.
+  void TrackKillAction::WriteSubEvent(std::string& buffer)
+  {
+    std::vector<long>   nTracks(fRules.size());
+    std::vector<double> energy (fRules.size());
+    for ( size_t i = 0; i < fRules.size(); ++i ) {
+      nTracks[i] = fRules[i].nTracks;
+      energy[i]  = fRules[i].energy;
+    }
+
+    std::vector<int>    pdg;
+    std::vector<long>   pdgTracks;
+    std::vector<double> pdgEnergy;
+    for ( std::map<int, std::pair<long,double> >::const_iterator itr = fKilledByPDG.begin();
+	  itr != fKilledByPDG.end(); ++itr ) {
+      pdg      .push_back(itr->first);
+      pdgTracks.push_back(itr->second.first);
+      pdgEnergy.push_back(itr->second.second);
+    }
+
+    SubEventWriter out(buffer);
+    out.Put(fEventKilledTracks);
+    out.Put(fEventKilledEnergy);
+    out.Put(nTracks);
+    out.Put(energy);
+    out.Put(pdg);
+    out.Put(pdgTracks);
+    out.Put(pdgEnergy);
+  }
+
+  //-------------------------------------------------------------
+  void TrackKillAction::ClearSubEvents()
+  {
+    this->BeginOfEventAction(0);
+    for ( size_t i = 0; i < fRules.size(); ++i ) {
+      fRules[i].nTracks = 0;
+      fRules[i].energy  = 0.;
+    }
+    fKilledByPDG.clear();
+  }
+
+  //-------------------------------------------------------------
+  void TrackKillAction::MergeSubEvent(std::string const& buffer, int /* trackIDOffset */)
+  {
+    long                eventTracks = 0;
+    double              eventEnergy = 0.;
+    std::vector<long>   nTracks;
+    std::vector<double> energy;
+    std::vector<int>    pdg;
+    std::vector<long>   pdgTracks;
+    std::vector<double> pdgEnergy;
+
+    SubEventReader in(buffer);
+    in.Get(eventTracks);
+    in.Get(eventEnergy);
+    in.Get(nTracks);
+    in.Get(energy);
+    in.Get(pdg);
+    in.Get(pdgTracks);
+    in.Get(pdgEnergy);
+
+    if ( nTracks.size() != fRules.size() || energy.size() != fRules.size() ||
+	 pdgTracks.size() != pdg.size()  || pdgEnergy.size() != pdg.size() )
+      throw cet::exception("TrackKillAction") << "sub-event buffer does not match the "
+					      << fRules.size() << " configured rules";
+
+    fEventKilledTracks += eventTracks;
+    fEventKilledEnergy += eventEnergy;
+    for ( size_t i = 0; i < fRules.size(); ++i ) {
+      fRules[i].nTracks += nTracks[i];
+      fRules[i].energy  += energy[i];
+    }
+    for ( size_t i = 0; i < pdg.size(); ++i ) {
+      std::pair<long,double>& byPDG = fKilledByPDG[pdg[i]];
+      byPDG.first  += pdgTracks[i];
+      byPDG.second += pdgEnergy[i];
+    }
+  }
+
+} // end namespace
@@ -0,0 +1,99 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  TrackKillAction.h
+/// \brief Stacking policy that kills or defers tracks by type, energy and region
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+/// This class implements the G4Base::UserAction stacking interface to
+/// kill, or move to the waiting stack, new tracks that match one of a
+/// list of rules.  Each rule selects on particle type, on kinetic energy
+/// below a threshold, and on the logical volume or G4Region the track
+/// starts in.  Volume and region names are resolved to G4LogicalVolume
+/// pointers once in BeginOfRunAction, so classifying a track involves
+/// no string comparisons.  Rules are tried in the order given and the
+/// first match decides.
+///
+/// Example configuration:
+///
+///   Rules: [ { Name: "rock_neutrons"  PDGCodes: [ 2112 ]
+///              MaxKineticEnergy: 0.01 Regions: [ "Rock" ] Action: "Kill" },
+///            { Name: "rock_gammas"    PDGCodes: [ 22 ]
+///              MaxKineticEnergy: 0.001 Volumes: [ "volRock" ] Action: "Kill" } ]
+///
+/// The number of tracks and the kinetic energy removed by each rule are
+/// counted per event and per run for validation.  With sub-event
+/// tracking (G4Helper::SetSubEventTracking) the counts of the
+/// sub-events are summed, so they stand for the whole event.
+
+#ifndef G4BASE_TRACKKILLACTION_H
+#define G4BASE_TRACKKILLACTION_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "G4Base/UserAction.h"
+
+// Forward declarations.
+class G4Run;
+class G4Event;
+class G4Track;
+class G4LogicalVolume;
+
+namespace g4b {
+
+  class TrackKillAction : public g4b::UserAction {
+
+  public:
+    TrackKillAction();
+    virtual ~TrackKillAction();
+
+    void Config(fhicl::ParameterSet const& pset);
+    void PrintConfig(std::string const& opt);
+
+    void BeginOfRunAction(const G4Run*);
+    void EndOfRunAction(const G4Run*);
+    void BeginOfEventAction(const G4Event*);
+
+    bool ProvidesStacking() { return true; }
+    G4ClassificationOfNewTrack StackClassifyNewTrack(const G4Track*);
+
+    bool ProvidesSubEventMerge() { return true; }
+    void WriteSubEvent(std::string& buffer);
+    void ClearSubEvents();
+    void MergeSubEvent(std::string const& buffer, int trackIDOffset);
+
+    /// kinetic energy (GeV) of the tracks killed in the current event,
+    /// weighted with the G4Track weight
+    double EventKilledEnergy() const { return fEventKilledEnergy; }
+    /// number of tracks killed in the current event
+    long   EventKilledTracks() const { return fEventKilledTracks; }
+
+  private:
+
+    struct Rule {
+      std::string                          name;        ///< label used in the summary
+      std::vector<int>                     pdgCodes;    ///< sorted, empty = any particle
+      double                               maxKE;       ///< act below this kinetic energy (G4 units)
+      std::vector<std::string>             volumeNames; ///< logical volume names
+      std::vector<std::string>             regionNames; ///< G4Region names
+      std::vector<const G4LogicalVolume*>  volumes;     ///< resolved volumes, sorted by address
+      bool                                 anywhere;    ///< no volume or region given
+      G4ClassificationOfNewTrack           action;      ///< fKill or fWaiting
+      long                                 nTracks;     ///< tracks acted on this run
+      double                               energy;      ///< kinetic energy acted on this run (GeV)
+    };
+
+    std::vector<Rule>                      fRules;             ///< rules, tried in order
+    bool                                   fKeepPrimaries;     ///< never touch primaries
+    int                                    fVerbose;           ///< verbosity
+
+    double                                 fEventKilledEnergy; ///< killed KE this event (GeV)
+    long                                   fEventKilledTracks; ///< killed tracks this event
+    std::map<int, std::pair<long,double> > fKilledByPDG;       ///< run totals per particle type
+  };
+
+} // namespace g4b
+
+#endif // G4BASE_TRACKKILLACTION_H
@@ -12,6 +12,10 @@
 ///
 /// 2012-08-17 <rhatcher@fnal.gov> Add G4UserStackingAction-like interfaces
 ///
+/// Add EnergySpotAction to receive deposits from parameterized showers
+///
+/// Add the sub-event merge interfaces used by sub-event tracking
+///
 /// This is an abstract base class to be used with Geant 4.0.1 (and
 /// possibly higher, if the User classes don't change).  
 ///
@@ -48,6 +52,8 @@ class G4Track;
 class G4Step;
 #include "Geant4/G4ClassificationOfNewTrack.hh"
 
+namespace g4b { struct EnergySpot; }
+
 #include <string>
 #include "fhiclcpp/ParameterSet.h"
 
@@ -94,6 +100,25 @@ namespace g4b {
     virtual void StackNewStage() {};
     virtual void StackPrepareNewEvent() {};
 
+    /// Energy deposited by a fast simulation model (see EMShowerModel)
+    /// rather than by G4Steps; actions that sum energy should override
+    virtual void EnergySpotAction(const EnergySpot&) {};
+
+    /// Sub-event tracking (see G4Helper::SetSubEventTracking) tracks the
+    /// primaries of one logical event as several Geant4 events, possibly
+    /// in other processes.  Actions with per event results override these
+    /// to have them merged: WriteSubEvent() serializes the results of the
+    /// Geant4 event just ended (see SubEventBuffer.h), ClearSubEvents()
+    /// starts the logical event and MergeSubEvent() adds one sub-event to
+    /// it, adding trackIDOffset to its Geant4 track ids.  Sub-events are
+    /// merged in a fixed order after the results are complete.  G4Helper
+    /// refuses to track sub-events while any action does not provide
+    /// the merge.
+    virtual bool ProvidesSubEventMerge() { return false; }
+    virtual void WriteSubEvent(std::string& /* buffer */) {};
+    virtual void ClearSubEvents() {};
+    virtual void MergeSubEvent(std::string const& /* buffer */, int /* trackIDOffset */) {};
+
     // allow self-identification
     std::string const & GetName() const { return myName; }
     void                SetName(std::string const& name) { myName = name; }
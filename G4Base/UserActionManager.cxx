@@ -13,6 +13,7 @@
 
 #include "G4Base/UserActionManager.h"
 #include "G4Base/UserAction.h"
+#include "G4Base/EnergySpot.h"
 
 #include "Geant4/G4Run.hh"
 #include "Geant4/G4Event.hh"
@@ -28,6 +29,7 @@ namespace g4b {
 
   //-------------------------------------------------
   UserActionManager::UserActionManager() 
+    : fMaxTrackID(0)
   {
   }
 
@@ -121,6 +123,7 @@ namespace g4b {
   //-------------------------------------------------
   void UserActionManager::BeginOfEventAction(const G4Event* a_event)
   {
+    fMaxTrackID = 0;
     for ( fuserActions_ptr_t i = fuserActions.begin(); i != fuserActions.end(); i++ ){
       (*i)->BeginOfEventAction(a_event);
     }
@@ -137,6 +140,7 @@ namespace g4b {
   //-------------------------------------------------
   void UserActionManager::PreUserTrackingAction(const G4Track* a_track)
   {
+    if ( a_track->GetTrackID() > fMaxTrackID ) fMaxTrackID = a_track->GetTrackID();
     for ( fuserActions_ptr_t i = fuserActions.begin(); i != fuserActions.end(); i++ ){
       (*i)->PreTrackingAction(a_track);
     }
@@ -220,4 +224,54 @@ namespace g4b {
     return doany;
   }
 
+  //-------------------------------------------------
+  void UserActionManager::EnergySpotAction(const EnergySpot& a_spot)
+  {
+    for ( fuserActions_ptr_t i = fuserActions.begin(); i != fuserActions.end(); i++ ){
+      (*i)->EnergySpotAction(a_spot);
+    }
+  }
+
+  //-------------------------------------------------
+  void UserActionManager::WriteSubEvent(std::vector<std::string>& buffers) const
+  {
+    buffers.assign(fuserActions.size(), std::string());
+    for ( size_t i = 0; i < fuserActions.size(); ++i ){
+      if ( fuserActions[i]->ProvidesSubEventMerge() ) {
+        fuserActions[i]->WriteSubEvent(buffers[i]);
+      }
+    }
+  }
+
+  //-------------------------------------------------
+  void UserActionManager::ClearSubEvents()
+  {
+    for ( fuserActions_ptr_t i = fuserActions.begin(); i != fuserActions.end(); i++ ){
+      if ( (*i)->ProvidesSubEventMerge() ) {
+        (*i)->ClearSubEvents();
+      }
+    }
+  }
+
+  //-------------------------------------------------
+  void UserActionManager::MergeSubEvent(std::vector<std::string> const& buffers, 
+                                        int trackIDOffset)
+  {
+    for ( size_t i = 0; i < fuserActions.size() && i < buffers.size(); ++i ){
+      if ( fuserActions[i]->ProvidesSubEventMerge() ) {
+        fuserActions[i]->MergeSubEvent(buffers[i],trackIDOffset);
+      }
+    }
+  }
+
+  //-------------------------------------------------
+  std::vector<std::string> UserActionManager::ActionsWithoutSubEventMerge() const
+  {
+    std::vector<std::string> names;
+    for ( fuserActions_ptr_t i = fuserActions.begin(); i != fuserActions.end(); i++ ){
+      if ( ! (*i)->ProvidesSubEventMerge() ) names.push_back((*i)->GetName());
+    }
+    return names;
+  }
+
 }// namespace
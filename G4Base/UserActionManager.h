@@ -54,6 +54,7 @@
 #include "Geant4/G4SteppingManager.hh"
 
 #include <vector>
+#include <string>
 
 namespace g4b {
 
@@ -97,6 +98,17 @@ namespace g4b {
     virtual void NewStage();
     virtual void PrepareNewEvent();
     virtual bool DoesAnyActionProvideStacking();  // do any managed UserActions do stacking
+    // energy deposits from fast simulation models
+    virtual void EnergySpotAction      (const EnergySpot&);
+
+    // Sub-event tracking (see G4Helper::SetSubEventTracking): one buffer
+    // per managed action, empty for actions without ProvidesSubEventMerge()
+    void WriteSubEvent(std::vector<std::string>& buffers) const;
+    void ClearSubEvents();
+    void MergeSubEvent(std::vector<std::string> const& buffers, int trackIDOffset);
+    std::vector<std::string> ActionsWithoutSubEventMerge() const;
+    // largest Geant4 track id seen in the current event
+    G4int MaxTrackID() const { return fMaxTrackID; }
 
     // "Mysterious accessors": Where do the pointers to these managers
     // come from?  They are all defined in the G4User*Action classes.
@@ -111,6 +123,7 @@ namespace g4b {
     typedef std::vector<UserAction*>       fuserActions_t;
     typedef fuserActions_t::const_iterator fuserActions_ptr_t;
     static  fuserActions_t                 fuserActions; 
+    G4int                                  fMaxTrackID;
 
   protected:
     // The constructor is protected according to the standard
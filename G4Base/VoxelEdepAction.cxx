@@ -0,0 +1,312 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  VoxelEdepAction.cxx
+/// \brief Accumulate step energy deposits in a sparse voxel grid
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+#include "G4Base/VoxelEdepAction.h"
+#include "G4Base/EnergySpot.h"
+#include "G4Base/SubEventBuffer.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+#include "cetlib/exception.h"
+
+// self-register with the factory
+#include "G4Base/UserActionFactory.h"
+USERACTIONREG3(g4b,VoxelEdepAction,g4b::VoxelEdepAction)
+
+// G4 includes
+#include "Geant4/G4Run.hh"
+#include "Geant4/G4Event.hh"
+#include "Geant4/G4Step.hh"
+#include "Geant4/G4StepPoint.hh"
+#include "Geant4/G4ThreeVector.hh"
+#include "Geant4/G4VPhysicalVolume.hh"
+#include "Geant4/G4LogicalVolume.hh"
+#include "Geant4/G4LogicalVolumeStore.hh"
+#include "Geant4/G4TouchableHandle.hh"
+#include "Geant4/G4SystemOfUnits.hh"
+
+// C/C++ includes
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+  // voxel indices are stored offset by kOffset in 21 bits each, the
+  // top bit marks an occupied slot so that a key is never 0
+  const int64_t  kOffset   = 1 << 20;
+  const uint64_t kMask21   = (1 << 21) - 1;
+  const uint64_t kOccupied = (uint64_t)1 << 63;
+
+  inline uint64_t PackKey(int64_t ix, int64_t iy, int64_t iz)
+  {
+    return kOccupied
+      | ((uint64_t)(ix + kOffset) << 42)
+      | ((uint64_t)(iy + kOffset) << 21)
+      |  (uint64_t)(iz + kOffset);
+  }
+
+  // finalizer of splitmix64, spreads neighbouring voxels over the table
+  inline uint64_t Mix(uint64_t k)
+  {
+    k ^= k >> 30; k *= 0xbf58476d1ce4e5b9ULL;
+    k ^= k >> 27; k *= 0x94d049bb133111ebULL;
+    k ^= k >> 31;
+    return k;
+  }
+
+}
+
+namespace g4b {
+
+  //-------------------------------------------------------------
+  // Constructor.
+  VoxelEdepAction::VoxelEdepAction()
+    : fVoxelSize(1.)
+    , fInvVoxelSize(1./(1.*cm))
+    , fInitialSize(1 << 16)
+    , fMask(0)
+    , fTotalEdep(0.)
+  {
+    // usable without Config(), e.g. when only merging sub-events
+    this->AllocateTable();
+  }
+
+  //-------------------------------------------------------------
+  // Destructor.
+  VoxelEdepAction::~VoxelEdepAction()
+  {
+  }
+
+  //-------------------------------------------------------------
+  void VoxelEdepAction::Config(fhicl::ParameterSet const& pset)
+  {
+    fVoxelSize   = pset.get< double                   >("VoxelSize",   1.); // cm
+    fVolumeNames = pset.get< std::vector<std::string> >("Volumes",     std::vector<std::string>());
+    fInitialSize = pset.get< size_t                   >("InitialSize", 1 << 16);
+
+    if ( fVoxelSize <= 0. )
+      throw cet::exception("VoxelEdepAction") << "VoxelSize must be positive, not " << fVoxelSize;
+
+    fInvVoxelSize = 1./(fVoxelSize*cm);
+
+    this->AllocateTable();
+  }
+
+  //-------------------------------------------------------------
+  void VoxelEdepAction::AllocateTable()
+  {
+    // round the table up to a power of two so the probe can use a mask
+    size_t nslots = 16;
+    while ( nslots < fInitialSize ) nslots <<= 1;
+    fKeys.assign(nslots, 0);
+    fEdep.assign(nslots, 0.);
+    fUsed.clear();
+    fUsed.reserve(nslots/2);
+    fMask = nslots - 1;
+  }
+
+  //-------------------------------------------------------------
+  void VoxelEdepAction::PrintConfig(std::string const& /* opt */)
+  {
+    mf::LogInfo log("VoxelEdepAction");
+    log << "VoxelEdepAction::PrintConfig \n"
+	<< "    VoxelSize            " << fVoxelSize << " cm\n"
+	<< "    InitialSize          " << fKeys.size() << " slots\n"
+	<< "    Volumes             ";
+    if ( fVolumeNames.empty() ) log << " all";
+    for ( size_t i = 0; i < fVolumeNames.size(); ++i ) log << " " << fVolumeNames[i];
+  }
+
+  //-------------------------------------------------------------
+  void VoxelEdepAction::BeginOfRunAction(const G4Run* /* run */)
+  {
+    // resolve the volume names once so the step only compares pointers
+    fVolumes.clear();
+    G4LogicalVolumeStore* store = G4LogicalVolumeStore::GetInstance();
+    for ( size_t i = 0; i < fVolumeNames.size(); ++i ) {
+      size_t nfound = 0;
+      for ( G4LogicalVolumeStore::iterator lv = store->begin(); lv != store->end(); ++lv ) {
+	if ( (*lv)->GetName() == fVolumeNames[i] ) {
+	  fVolumes.push_back(*lv);
+	  ++nfound;
+	}
+      }
+      if ( nfound == 0 )
+	mf::LogWarning("VoxelEdepAction") << "no logical volume named " << fVolumeNames[i];
+    }
+    std::sort(fVolumes.begin(), fVolumes.end());
+
+    if ( !fVolumeNames.empty() && fVolumes.empty() )
+      throw cet::exception("VoxelEdepAction") << "none of the requested volumes exist";
+  }
+
+  //-------------------------------------------------------------
+  void VoxelEdepAction::BeginOfEventAction(const G4Event* /* event */)
+  {
+    // only touch the slots that were filled in the last event
+    for ( size_t i = 0; i < fUsed.size(); ++i ) {
+      fKeys[fUsed[i]] = 0;
+      fEdep[fUsed[i]] = 0.;
+    }
+    fUsed.clear();
+  }
+
+  //-------------------------------------------------------------
+  bool VoxelEdepAction::Accept(const G4LogicalVolume* lv) const
+  {
+    if ( fVolumeNames.empty() ) return true;
+    return std::binary_search(fVolumes.begin(), fVolumes.end(), lv);
+  }
+
+  //-------------------------------------------------------------
+  void VoxelEdepAction::SteppingAction(const G4Step* step)
+  {
+    double edep = step->GetTotalEnergyDeposit();
+    if ( edep <= 0. ) return;
+
+    const G4StepPoint* pre = step->GetPreStepPoint();
+    if ( !this->Accept(pre->GetTouchableHandle()->GetVolume()->GetLogicalVolume()) ) return;
+
+    // assign the deposit to the voxel holding the step mid point,
+    // weighted so that importance biasing leaves the sums unbiased
+    this->Deposit(0.5*(pre->GetPosition() + step->GetPostStepPoint()->GetPosition()),
+		  edep*step->GetTrack()->GetWeight());
+  }
+
+  //-------------------------------------------------------------
+  void VoxelEdepAction::EnergySpotAction(const EnergySpot& spot)
+  {
+    if ( spot.energy <= 0. || !this->Accept(spot.volume) ) return;
+
+    this->Deposit(spot.position, spot.energy*spot.weight);
+  }
+
+  //-------------------------------------------------------------
+  void VoxelEdepAction::Deposit(G4ThreeVector const& pos, double edep)
+  {
+    int64_t ix = (int64_t)std::floor(pos.x()*fInvVoxelSize);
+    int64_t iy = (int64_t)std::floor(pos.y()*fInvVoxelSize);
+    int64_t iz = (int64_t)std::floor(pos.z()*fInvVoxelSize);
+
+    if ( ix < -kOffset || ix >= kOffset ||
+	 iy < -kOffset || iy >= kOffset ||
+	 iz < -kOffset || iz >= kOffset ) return;
+
+    this->Insert(PackKey(ix, iy, iz), edep);
+  }
+
+  //-------------------------------------------------------------
+  void VoxelEdepAction::Insert(uint64_t key, double edep)
+  {
+    size_t slot = Mix(key) & fMask;
+    while ( true ) {
+      if ( fKeys[slot] == key ) {
+	fEdep[slot] += edep;
+	return;
+      }
+      if ( fKeys[slot] == 0 ) break;
+      slot = (slot + 1) & fMask;
+    }
+
+    fKeys[slot] = key;
+    fEdep[slot] = edep;
+    fUsed.push_back(slot);
+
+    // keep the load factor below one half
+    if ( 2*fUsed.size() > fKeys.size() ) this->Grow();
+  }
+
+  //-------------------------------------------------------------
+  void VoxelEdepAction::Grow()
+  {
+    std::vector<uint64_t> keys;
+    std::vector<double>   edep;
+    keys.swap(fKeys);
+    edep.swap(fEdep);
+    std::vector<uint32_t> used;
+    used.swap(fUsed);
+
+    size_t nslots = 2*keys.size();
+    fKeys.assign(nslots, 0);
+    fEdep.assign(nslots, 0.);
+    fUsed.reserve(nslots/2);
+    fMask = nslots - 1;
+
+    for ( size_t i = 0; i < used.size(); ++i ) {
+      size_t slot = Mix(keys[used[i]]) & fMask;
+      while ( fKeys[slot] != 0 ) slot = (slot + 1) & fMask;
+      fKeys[slot] = keys[used[i]];
+      fEdep[slot] = edep[used[i]];
+      fUsed.push_back(slot);
+    }
+
+    mf::LogDebug("VoxelEdepAction") << "grew voxel table to " << nslots << " slots";
+  }
+
+  //-------------------------------------------------------------
+  void VoxelEdepAction::EndOfEventAction(const G4Event* /* event */)
+  {
+    this->Compact();
+  }
+
+  //-------------------------------------------------------------
+  void VoxelEdepAction::Compact()
+  {
+    // compact the table into the output, sorted by packed key
+    std::vector<uint64_t> keys;
+    keys.reserve(fUsed.size());
+    for ( size_t i = 0; i < fUsed.size(); ++i ) keys.push_back(fKeys[fUsed[i]]);
+    std::sort(keys.begin(), keys.end());
+
+    fDeposits.clear();
+    fDeposits.reserve(keys.size());
+    fTotalEdep = 0.;
+    for ( size_t i = 0; i < keys.size(); ++i ) {
+      // find the slot again, the table is at most half full
+      size_t slot = Mix(keys[i]) & fMask;
+      while ( fKeys[slot] != keys[i] ) slot = (slot + 1) & fMask;
+
+      VoxelDeposit vd;
+      vd.ix   = (int)((int64_t)((keys[i] >> 42) & kMask21) - kOffset);
+      vd.iy   = (int)((int64_t)((keys[i] >> 21) & kMask21) - kOffset);
+      vd.iz   = (int)((int64_t)( keys[i]        & kMask21) - kOffset);
+      vd.edep = fEdep[slot]/GeV;
+      fDeposits.push_back(vd);
+      fTotalEdep += vd.edep;
+    }
+
+    LOG_DEBUG("VoxelEdepAction") << fDeposits.size() << " voxels, "
+				 << fTotalEdep << " GeV deposited";
+  }
+
+  //-------------------------------------------------------------
+  void VoxelEdepAction::WriteSubEvent(std::string& buffer)
+  {
+    SubEventWriter out(buffer);
+    out.Put(fDeposits);
+  }
+
+  //-------------------------------------------------------------
+  void VoxelEdepAction::ClearSubEvents()
+  {
+    this->BeginOfEventAction(0);
+    fDeposits.clear();
+    fTotalEdep = 0.;
+  }
+
+  //-------------------------------------------------------------
+  void VoxelEdepAction::MergeSubEvent(std::string const& buffer, int /* trackIDOffset */)
+  {
+    std::vector<VoxelDeposit> deposits;
+    SubEventReader in(buffer);
+    in.Get(deposits);
+    for ( size_t i = 0; i < deposits.size(); ++i ) {
+      VoxelDeposit const& vd = deposits[i];
+      this->Insert(PackKey(vd.ix, vd.iy, vd.iz), vd.edep*GeV);
+    }
+    this->Compact();
+  }
+
+} // end namespace
@@ -0,0 +1,103 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  VoxelEdepAction.h
+/// \brief Accumulate step energy deposits in a sparse voxel grid
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+/// This class implements the G4Base::UserAction interface to sum the
+/// energy deposited in each step into cubic voxels.  The voxels live
+/// in an open-addressing (linear probing) hash table keyed on the
+/// packed voxel indices, so a step costs one floor() per coordinate
+/// and a couple of probes; no memory is allocated per step once the
+/// table has reached its working size.  Deposits can be restricted to
+/// a list of logical volumes, resolved to pointers at the start of
+/// the run.  At the end of each event the table is compacted into a
+/// sorted vector of VoxelDeposit that can be retrieved with
+/// GetDeposits().  Spots from parameterized showers are summed the
+/// same way, filtered on the volume the shower started in.
+///
+/// Each instance owns its own table, so with one action per worker
+/// thread no locking is required.
+///
+/// With sub-event tracking the deposits of the sub-events are summed
+/// back into the table in sub-event order and compacted again.
+
+#ifndef G4BASE_VOXELEDEPACTION_H
+#define G4BASE_VOXELEDEPACTION_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#include "G4Base/UserAction.h"
+#include "Geant4/G4ThreeVector.hh"
+
+// Forward declarations.
+class G4Run;
+class G4Event;
+class G4Step;
+class G4LogicalVolume;
+
+namespace g4b {
+
+  /// energy summed over one voxel in an event
+  struct VoxelDeposit {
+    int   ix;    ///< voxel index in x
+    int   iy;    ///< voxel index in y
+    int   iz;    ///< voxel index in z
+    float edep;  ///< deposited energy in GeV
+  };
+
+  class VoxelEdepAction : public g4b::UserAction {
+
+  public:
+    VoxelEdepAction();
+    virtual ~VoxelEdepAction();
+
+    void Config(fhicl::ParameterSet const& pset);
+    void PrintConfig(std::string const& opt);
+
+    void BeginOfRunAction(const G4Run*);
+    void BeginOfEventAction(const G4Event*);
+    void EndOfEventAction(const G4Event*);
+    void SteppingAction(const G4Step*);
+    void EnergySpotAction(const EnergySpot& spot);
+
+    bool ProvidesSubEventMerge() { return true; }
+    void WriteSubEvent(std::string& buffer);
+    void ClearSubEvents();
+    void MergeSubEvent(std::string const& buffer, int trackIDOffset);
+
+    /// deposits of the last completed event, sorted by (ix, iy, iz)
+    std::vector<VoxelDeposit> const& GetDeposits() const { return fDeposits;  }
+    double                           VoxelSize()   const { return fVoxelSize; } ///< in cm
+    double                           TotalEdep()   const { return fTotalEdep; } ///< in GeV
+
+  private:
+
+    void     AllocateTable();
+    void     Deposit(G4ThreeVector const& pos, double edep);
+    void     Insert(uint64_t key, double edep);
+    void     Grow();
+    void     Compact();
+    bool     Accept(const G4LogicalVolume* lv) const;
+
+    double                               fVoxelSize;     ///< voxel edge length (cm)
+    double                               fInvVoxelSize;  ///< 1/voxel size in G4 length units
+    std::vector<std::string>             fVolumeNames;   ///< logical volumes to accept, empty = all
+    std::vector<const G4LogicalVolume*>  fVolumes;       ///< resolved volumes, sorted by address
+    size_t                               fInitialSize;   ///< initial number of hash slots
+
+    std::vector<uint64_t>                fKeys;          ///< hash slots: packed voxel index, 0 = empty
+    std::vector<double>                  fEdep;          ///< hash slots: summed energy (G4 units)
+    std::vector<uint32_t>                fUsed;          ///< occupied slots in insertion order
+    size_t                               fMask;          ///< number of slots - 1
+
+    std::vector<VoxelDeposit>            fDeposits;      ///< compacted output of the last event
+    double                               fTotalEdep;     ///< total energy of the last event (GeV)
+  };
+
+} // namespace g4b
+
+#endif // G4BASE_VOXELEDEPACTION_H
@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  EMShowerModel_test.cc
+/// \brief Energy bookkeeping of the parameterized EM shower
+///
+/// Tracks electrons and photons that start inside a large block of
+/// liquid argon with g4b::EMShowerModel parameterizing the showers,
+/// and checks that the energy summed by g4b::VoxelEdepAction, from
+/// steps and shower spots together, is the kinetic energy of the
+/// primary.  The shower is contained, so any difference means energy
+/// is lost or counted twice.
+///
+///   EMShowerModel_test [geometry.gdml]
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// ROOT includes
+#include "TLorentzVector.h"
+
+// Framework includes
+#include "fhiclcpp/ParameterSet.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+// Geant4 includes
+#include "Geant4/G4UImanager.hh"
+
+// NuTools includes
+#include "SimulationBase/MCTruth.h"
+#include "SimulationBase/MCParticle.h"
+#include "G4Base/G4Helper.h"
+#include "G4Base/UserActionManager.h"
+#include "G4Base/VoxelEdepAction.h"
+
+//......................................................................
+int main(int argc, char** argv)
+{
+  std::string gdml = ( argc > 1 ) ? argv[1] : "g4base_test.gdml";
+
+  mf::StartMessageFacility(mf::MessageFacilityService::SingleThread,
+                           mf::MessageFacilityService::logConsole());
+
+  g4b::G4Helper helper("", "QGSP_BERT", gdml);
+  helper.SetValidateGDMLSchema(false);
+  helper.SetUseFieldService(false);
+
+  fhicl::ParameterSet shower;
+  shower.put("Volumes",   std::vector<std::string>(1, "volLAr"));
+  shower.put("MinEnergy", 1.);
+  helper.SetFastShower(shower);
+  helper.InitPhysics();
+
+  g4b::VoxelEdepAction* voxels = new g4b::VoxelEdepAction;
+  voxels->SetName("g4b::VoxelEdepAction");
+  voxels->Config(fhicl::ParameterSet());
+  g4b::UserActionManager::Instance()->AddAndAdoptAction(voxels);
+  helper.SetUserAction();
+
+  G4UImanager* ui = G4UImanager::GetUIpointer();
+  ui->ApplyCommand("/run/verbose 0");
+  ui->ApplyCommand("/event/verbose 0");
+  ui->ApplyCommand("/tracking/verbose 0");
+
+  // pdg, mass (GeV), momentum (GeV/c)
+  struct Primary { int pdg; double mass, p; };
+  const Primary primaries[] = { { 11, 0.000511,  2. },
+                                { 11, 0.000511, 10. },
+                                { 22, 0.,        5. } };
+
+  int nfail = 0;
+  for ( size_t i = 0; i < sizeof(primaries)/sizeof(primaries[0]); ++i ) {
+    const Primary& pr = primaries[i];
+    const double e  = std::sqrt(pr.p*pr.p + pr.mass*pr.mass);
+    const double ke = e - pr.mass;
+
+    simb::MCTruth truth;
+    simb::MCParticle part(0, pr.pdg, "primary", -1, pr.mass, 1);
+    part.AddTrajectoryPoint(TLorentzVector(0., 0., -500., 0.),
+                            TLorentzVector(0., 0., pr.p, e));
+    truth.Add(part);
+
+    helper.G4Run(&truth);
+
+    const double sum = voxels->TotalEdep();
+    const bool   ok  = std::abs(sum - ke) < 1.e-4*ke;
+    std::printf("%-5d %8.3f GeV kinetic, %10.6f GeV in voxels  %s\n",
+                pr.pdg, ke, sum, ok ? "ok" : "FAIL");
+    if ( !ok ) ++nfail;
+  }
+
+  return nfail;
+}
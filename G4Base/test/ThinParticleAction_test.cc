@@ -0,0 +1,105 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  ThinParticleAction_test.cc
+/// \brief Bookkeeping of dropped secondaries in g4b::ThinParticleAction
+///
+/// Feeds a hand-made family of G4Tracks through the tracking hooks of
+/// g4b::ThinParticleAction, without running Geant4, and checks which
+/// particles are recorded and how much kinetic energy is folded into
+/// them.  The family includes secondaries of dropped tracks, both below
+/// and above threshold, which must be neither recorded nor folded
+/// again.
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#include <cmath>
+#include <cstdio>
+
+// Framework includes
+#include "fhiclcpp/ParameterSet.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+// Geant4 includes
+#include "Geant4/G4Track.hh"
+#include "Geant4/G4DynamicParticle.hh"
+#include "Geant4/G4ParticleDefinition.hh"
+#include "Geant4/G4MuonMinus.hh"
+#include "Geant4/G4PionPlus.hh"
+#include "Geant4/G4Proton.hh"
+#include "Geant4/G4Electron.hh"
+#include "Geant4/G4Gamma.hh"
+#include "Geant4/G4SystemOfUnits.hh"
+
+// NuTools includes
+#include "G4Base/ThinParticleAction.h"
+
+namespace {
+
+  int nfail = 0;
+
+  void Check(bool ok, const char* what)
+  {
+    std::printf("%-60s %s\n", what, ok ? "ok" : "FAIL");
+    if ( !ok ) ++nfail;
+  }
+
+  /// track one particle of kinetic energy ke (GeV) along z
+  void Track(g4b::ThinParticleAction&    action,
+             int                         trackID,
+             int                         parentID,
+             G4ParticleDefinition*       def,
+             double                      ke)
+  {
+    G4DynamicParticle* dyn = new G4DynamicParticle(def, G4ThreeVector(0., 0., 1.), ke*GeV);
+    G4Track track(dyn, 0., G4ThreeVector(0., 0., 0.));
+    track.SetTrackID(trackID);
+    track.SetParentID(parentID);
+    action.PreTrackingAction(&track);
+    action.PostTrackingAction(&track);
+  }
+
+}
+
+//......................................................................
+int main()
+{
+  mf::StartMessageFacility(mf::MessageFacilityService::SingleThread,
+                           mf::MessageFacilityService::logConsole());
+
+  fhicl::ParameterSet pset;
+  pset.put("MinKineticEnergy",   0.001);
+  pset.put("EMMinKineticEnergy", 0.01 );
+
+  g4b::ThinParticleAction action;
+  action.Config(pset);
+  action.BeginOfEventAction(0);
+
+  //   1 mu-    1 GeV      primary, recorded
+  //   2 e-     5 MeV      below threshold, folded into 1
+  //   3 gamma  3 MeV      daughter of dropped 2, nothing more folded
+  //   4 proton 2 MeV      above threshold but daughter of dropped 2
+  //   5 e-     1 MeV      daughter of dropped 4
+  //   6 pi+    100 MeV    recorded, daughter of 1
+  //   7 gamma  2 MeV      below threshold, folded into 6
+  Track(action, 1, 0, G4MuonMinus::Definition(), 1.   );
+  Track(action, 2, 1, G4Electron ::Definition(), 0.005);
+  Track(action, 3, 2, G4Gamma    ::Definition(), 0.003);
+  Track(action, 4, 2, G4Proton   ::Definition(), 0.002);
+  Track(action, 5, 4, G4Electron ::Definition(), 0.001);
+  Track(action, 6, 1, G4PionPlus ::Definition(), 0.1  );
+  Track(action, 7, 6, G4Gamma    ::Definition(), 0.002);
+
+  action.EndOfEventAction(0);
+
+  Check(action.NParticles() == 2,                          "only the muon and the pion are recorded");
+  if ( action.NParticles() == 2 ) {
+    Check(action.Particle(0).TrackId() == 1,               "first particle is the muon");
+    Check(action.Particle(1).TrackId() == 6,               "second particle is the pion");
+    Check(action.Particle(1).Mother()  == 1,               "the pion's mother is the muon");
+    Check(action.Particle(0).NumberDaughters() == 1 &&
+          action.Particle(0).Daughter(0) == 6,             "the muon's only recorded daughter is the pion");
+    Check(std::abs(action.FoldedEnergy(0) - 0.005) < 1.e-9, "muon folds only the 5 MeV electron");
+    Check(std::abs(action.FoldedEnergy(1) - 0.002) < 1.e-9, "pion folds the 2 MeV gamma");
+  }
+
+  return nfail;
+}
@@ -0,0 +1,171 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  CachedINukeReweight.cxx
+/// \brief Intranuke (hA) reweighting from cached per-hadron survival probabilities
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+// C/C++ includes
+#include <math.h>
+
+//GENIE includes
+#include "EVGCore/EventRecord.h"
+#include "GHEP/GHepParticle.h"
+#include "GHEP/GHepStatus.h"
+#include "Interaction/Interaction.h"
+#include "Interaction/InitialState.h"
+#include "PDG/PDGUtils.h"
+#include "HadronTransport/INukeHadroFates.h"
+#include "HadronTransport/INukeUtils.h"
+#include "ReWeight/GSyst.h"
+#include "Messenger/Messenger.h"
+// Necessary because the GENIE LOG_* macros don't fully qualify Messenger
+using genie::Messenger;
+
+//NuTools includes
+#include "NuReweight/CachedINukeReweight.h"
+
+namespace rwgt {
+
+  std::vector<CachedINukeReweight::Hadron> CachedINukeReweight::fgHadrons;
+  double CachedINukeReweight::fgA        = 0.;
+  double CachedINukeReweight::fgZ        = 0.;
+  long   CachedINukeReweight::fgNStepped = 0;
+  long   CachedINukeReweight::fgNReused  = 0;
+
+  ///<constructor
+  CachedINukeReweight::CachedINukeReweight() {
+    this->Reset();
+  }
+
+  ///<destructor
+  CachedINukeReweight::~CachedINukeReweight() {
+  }
+
+  ///<The same dials as GReWeightINuke
+  bool CachedINukeReweight::IsHandled(genie::rew::GSyst_t syst) {
+    switch(syst) {
+    case genie::rew::kINukeTwkDial_MFP_pi:
+    case genie::rew::kINukeTwkDial_MFP_N:
+    case genie::rew::kINukeTwkDial_FrCEx_pi:
+    case genie::rew::kINukeTwkDial_FrElas_pi:
+    case genie::rew::kINukeTwkDial_FrInel_pi:
+    case genie::rew::kINukeTwkDial_FrAbs_pi:
+    case genie::rew::kINukeTwkDial_FrPiProd_pi:
+    case genie::rew::kINukeTwkDial_FrCEx_N:
+    case genie::rew::kINukeTwkDial_FrElas_N:
+    case genie::rew::kINukeTwkDial_FrInel_N:
+    case genie::rew::kINukeTwkDial_FrAbs_N:
+    case genie::rew::kINukeTwkDial_FrPiProd_N:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  ///<Set a dial value
+  void CachedINukeReweight::SetSystematic(genie::rew::GSyst_t syst, double val) {
+    if(this->IsHandled(syst)) fINukeRwParams.SetTwkDial(syst, val);
+  }
+
+  ///<Back to nominal
+  void CachedINukeReweight::Reset() {
+    fINukeRwParams.Reset();
+    this->Reconfigure();
+  }
+
+  ///<Recompute the fate scale factors for the current dials
+  void CachedINukeReweight::Reconfigure() {
+    fINukeRwParams.Reconfigure();
+  }
+
+  ///<No penalty terms
+  double CachedINukeReweight::CalcChisq() {
+    return 0.;
+  }
+
+  ///<Collect the pions and nucleons leaving the primary vertex inside the
+  ///<nucleus and step them through it, unless they are the ones cached.
+  void CachedINukeReweight::Update(const genie::EventRecord& event) {
+    const genie::Target& tgt = event.Summary()->InitState().Tgt();
+
+    static std::vector<Hadron> hadrons;
+    hadrons.clear();
+    for(int ip = 0; ip < event.GetEntries(); ip++) {
+      genie::GHepParticle* p = event.Particle(ip);
+      if(p->Status() != genie::kIStHadronInTheNucleus) continue;
+      int pdgc = p->Pdg();
+      if(!genie::pdg::IsPion(pdgc) && !genie::pdg::IsNucleon(pdgc)) continue;
+
+      Hadron h;
+      h.pdg   = pdgc;
+      h.fate  = p->RescatterCode();
+      h.x4.SetXYZT(p->Vx(), p->Vy(), p->Vz(), 0.);
+      h.p4.SetPxPyPzE(p->Px(), p->Py(), p->Pz(), p->E());
+      h.psurv = 1.;
+      hadrons.push_back(h);
+    }
+
+    bool same = ( tgt.A() == fgA && tgt.Z() == fgZ && hadrons.size() == fgHadrons.size() );
+    for(unsigned int i = 0; same && i < hadrons.size(); i++) {
+      same = ( hadrons[i].pdg  == fgHadrons[i].pdg  &&
+	       hadrons[i].fate == fgHadrons[i].fate &&
+	       hadrons[i].x4   == fgHadrons[i].x4   &&
+	       hadrons[i].p4   == fgHadrons[i].p4   );
+    }
+    if(same) {
+      ++fgNReused;
+      return;
+    }
+
+    for(unsigned int i = 0; i < hadrons.size(); i++) {
+      hadrons[i].psurv = genie::intranuke::ProbSurvival(hadrons[i].pdg, hadrons[i].x4, hadrons[i].p4,
+							 tgt.A(), tgt.Z(), 1.);
+    }
+    fgHadrons.swap(hadrons);
+    fgA = tgt.A();
+    fgZ = tgt.Z();
+    ++fgNStepped;
+  }
+
+  ///<Event weight, the product of the mean free path and fate weights of
+  ///<each hadron as in GReWeightINuke::CalcWeight
+  double CachedINukeReweight::CalcWeight(const genie::EventRecord& event) {
+    const genie::Target& tgt = event.Summary()->InitState().Tgt();
+    if(!tgt.IsNucleus()) return 1.;
+
+    this->Update(event);
+
+    double weight = 1.;
+    for(unsigned int i = 0; i < fgHadrons.size(); i++) {
+      const Hadron& h = fgHadrons[i];
+
+      if(h.fate == -1 || h.fate == (int)genie::kIHAFtUndefined) {
+	LOG_WARN("CachedINukeReweight") << "hadron without an hA fate, event not generated in hA mode?";
+	continue;
+      }
+      bool interacted = ( h.fate != (int)genie::kIHAFtNoInteraction );
+
+      //survival probability for a scaled mean free path is P^(1/f)
+      double w_mfp = 1.;
+      double f = fINukeRwParams.MeanFreePathParams(h.pdg)->ScaleFactor();
+      if(h.psurv > 0. && f > 0.) {
+	double ptwk = exp(log(h.psurv)/f);
+	if(ptwk > 0.) {
+	  if(interacted) w_mfp = ( h.psurv < 1. ) ? (1. - ptwk)/(1. - h.psurv) : 1.;
+	  else           w_mfp = ptwk/h.psurv;
+	}
+      }
+
+      double w_fate = 1.;
+      if(interacted) {
+	genie::rew::GSyst_t syst = genie::rew::GSyst::INukeFate2GSyst((genie::INukeFateHA_t)h.fate, h.pdg);
+	w_fate = fINukeRwParams.FateParams(h.pdg)->ScaleFactor(syst, h.p4);
+      }
+
+      weight *= w_mfp * w_fate;
+    }
+    return weight;
+  }
+
+} // namespace rwgt
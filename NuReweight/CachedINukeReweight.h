@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  CachedINukeReweight.h
+/// \brief Intranuke (hA) reweighting from cached per-hadron survival probabilities
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+/// GENIE's GReWeightINuke re-steps every hadron produced in the nucleus
+/// through the nuclear density (intranuke::ProbSurvival) twice for every
+/// event and every set of tweak dials.  The survival probability for a
+/// mean free path scaled by f is a product of per-step factors
+/// exp(-step/(f*mfp)), so it equals P^(1/f) where P is the nominal
+/// survival probability.  This calculator steps each hadron once per
+/// event to get P, keeps it together with the hadron's fate, and
+/// evaluates the mean free path and fate weights for any dial values
+/// from that.  The result matches GReWeightINuke up to rounding.
+///
+/// The cache holds the hadrons of the last event seen and is shared by
+/// all instances, so a job that weights each event for many universes
+/// (one GENIEReweight per universe) only steps the hadrons once.  The
+/// cached hadrons are compared with the event's own, so a new event is
+/// always recognised.
+
+#ifndef RWGT_CACHEDINUKEREWEIGHT_H
+#define RWGT_CACHEDINUKEREWEIGHT_H
+
+#include <vector>
+
+#include "TLorentzVector.h"
+
+#include "ReWeight/GReWeightI.h"
+#include "ReWeight/GReWeightINukeParams.h"
+
+namespace rwgt {
+
+  class CachedINukeReweight : public genie::rew::GReWeightI {
+
+  public:
+    CachedINukeReweight();
+    ~CachedINukeReweight();
+
+    // implement the GReWeightI interface
+    bool   IsHandled    (genie::rew::GSyst_t syst);
+    void   SetSystematic(genie::rew::GSyst_t syst, double val);
+    void   Reset        ();
+    void   Reconfigure  ();
+    double CalcWeight   (const genie::EventRecord& event);
+    double CalcChisq    ();
+
+    /// number of events for which the hadrons were stepped / reused
+    static long NStepped() { return fgNStepped; }
+    static long NReused()  { return fgNReused;  }
+
+  private:
+
+    /// what is needed of one hadron to recompute its weight
+    struct Hadron {
+      int            pdg;
+      int            fate;       ///< GHepParticle::RescatterCode()
+      TLorentzVector x4;         ///< position in the nucleus (fm)
+      TLorentzVector p4;
+      double         psurv;      ///< nominal survival probability
+    };
+
+    /// fill fgHadrons for this event unless they are already there
+    void Update(const genie::EventRecord& event);
+
+    genie::rew::GReWeightINukeParams fINukeRwParams;  ///< dials and fate scale factors
+
+    static std::vector<Hadron> fgHadrons;   ///< hadrons of the last event
+    static double              fgA;         ///< target of the last event
+    static double              fgZ;
+    static long                fgNStepped;
+    static long                fgNReused;
+  };
+
+} // namespace rwgt
+
+#endif // RWGT_CACHEDINUKEREWEIGHT_H
@@ -66,6 +66,7 @@ using genie::Messenger;
 #include "SimulationBase/MCNeutrino.h"
 #include "SimulationBase/GTruth.h"
 #include "NuReweight/GENIEReweight.h"
+#include "NuReweight/CachedINukeReweight.h"
 
 // Framework includes
 //#include "messagefacility/MessageLogger/MessageLogger.h"
@@ -95,7 +96,10 @@ namespace rwgt {
     fMaCCResShape(false),
     fMaNCResShape(false),
     fDISshape(false),
-    fUseSigmaDef(true) {
+    fUseSigmaDef(true),
+    fDispatchByType(true),
+    fWcalcShared(false),
+    fINukeCached(false) {
     
     LOG_INFO("GENIEReweight") << "Create GENIEReweight object";
     
@@ -432,8 +436,23 @@ namespace rwgt {
   void GENIEReweight::Reconfigure() {
     delete fWcalc;
     fWcalc = new genie::rew::GReWeight();
+    fCalcType.clear();
+    fCalculators.clear();
+    fWcalcShared = false;
     this->Configure();
   }
+
+  ///<Hand out the GReWeight; anything adopted through it directly has no
+  ///<ECalcType mask, so from now on every event goes to all calculators.
+  genie::rew::GReWeight* GENIEReweight::WeightCalculator() {
+    if(fDispatchByType && !fWcalcShared) {
+      LOG_WARNING("GENIEReweight") << "WeightCalculator() handed out: calculators adopted "
+				   << "through it are not dispatched by type, every event now "
+				   << "goes to GReWeight::CalcWeight; use AdoptCalculator() instead";
+    }
+    fWcalcShared = true;
+    return fWcalc;
+  }
   
   ///<Simple Configuration functions for configuring a single weight calculator
   
@@ -655,13 +674,13 @@ namespace rwgt {
   ///<Configure the NCEL weight calculator
   void GENIEReweight::ConfigureNCEL() {
     LOG_INFO("GENIEReweight") << "Adding NC elastic weight calculator";
-    fWcalc->AdoptWghtCalc( "xsec_ncel",       new GReWeightNuXSecNCEL      );
+    this->AdoptCalculator( "xsec_ncel",       new GReWeightNuXSecNCEL,      kCalcNC | kCalcQE | kCalcEL );
   }
   
   ///<Configure the MaQE weight calculator
   void GENIEReweight::ConfigureQEMA() {
     LOG_INFO("GENIEReweight") << "Adding CCQE axial FF weight calculator";
-    fWcalc->AdoptWghtCalc( "xsec_ccqe",       new GReWeightNuXSecCCQE      );
+    this->AdoptCalculator( "xsec_ccqe",       new GReWeightNuXSecCCQE,      kCalcCC | kCalcQE );
     if(!fMaQEshape) {
       LOG_INFO("GENIEReweight") << "in axial mass (QE) rate+shape mode";
       GReWeightNuXSecCCQE *rwccqe = dynamic_cast <GReWeightNuXSecCCQE*> (fWcalc->WghtCalc("xsec_ccqe"));
@@ -675,13 +694,13 @@ namespace rwgt {
   ///<Configure the QE vector FF weightcalculator
   void GENIEReweight::ConfigureQEVec() {
     LOG_INFO("GENIEReweight") << "Adding CCQE vector FF weight calculator";
-    fWcalc->AdoptWghtCalc( "xsec_ccqe_vec",   new GReWeightNuXSecCCQEvec   );
+    this->AdoptCalculator( "xsec_ccqe_vec",   new GReWeightNuXSecCCQEvec,   kCalcCC | kCalcQE );
   }
 
   ///<Configure the CCRES calculator
   void GENIEReweight::ConfigureCCRes() {
     LOG_INFO("GENIEReweight") << "Adding CC resonance weight calculator";
-    fWcalc->AdoptWghtCalc( "xsec_ccres",      new GReWeightNuXSecCCRES     );
+    this->AdoptCalculator( "xsec_ccres",      new GReWeightNuXSecCCRES,     kCalcCC | kCalcRES );
     if(!fMaCCResShape) {
       LOG_INFO("GENIEReweight") << "in axial mass (Res) rate+shape mode";
       GReWeightNuXSecCCRES * rwccres = dynamic_cast<GReWeightNuXSecCCRES *> (fWcalc->WghtCalc("xsec_ccres")); 
@@ -695,7 +714,7 @@ namespace rwgt {
   ///<Configure the NCRES calculator
   void GENIEReweight::ConfigureNCRes() {
     LOG_INFO("GENIEReweight") << "Adding NC resonance weight calculator";
-    fWcalc->AdoptWghtCalc( "xsec_ncres",      new GReWeightNuXSecNCRES     );
+    this->AdoptCalculator( "xsec_ncres",      new GReWeightNuXSecNCRES,     kCalcNC | kCalcRES );
     if(!fMaNCResShape) {
       LOG_INFO("GENIEReweight") << "in axial mass (Res) rate+shape mode";
       GReWeightNuXSecNCRES * rwncres = dynamic_cast<GReWeightNuXSecNCRES *> (fWcalc->WghtCalc("xsec_ncres")); 
@@ -709,25 +728,25 @@ namespace rwgt {
   ///<Configure the ResBkg (kno) weight calculator
   void GENIEReweight::ConfigureResBkg() {
     LOG_INFO("GENIEReweight") << "Adding low Q^2 DIS (KNO) weight calculator";
-    fWcalc->AdoptWghtCalc( "xsec_nonresbkg",  new GReWeightNonResonanceBkg );
+    this->AdoptCalculator( "xsec_nonresbkg",  new GReWeightNonResonanceBkg, kCalcDIS );
   }
 
   ///<Configure the ResDecay weight calculator
   void GENIEReweight::ConfgureResDecay() {
     LOG_INFO("GENIEReweight") << "Adding resonance decay weight calculator";
-    fWcalc->AdoptWghtCalc( "hadro_res_decay", new GReWeightResonanceDecay  );
+    this->AdoptCalculator( "hadro_res_decay", new GReWeightResonanceDecay,  kCalcRES );
   }
 
   ///<Configure the NC weight calculator
   void GENIEReweight::ConfigureNC() {
     LOG_INFO("GENIEReweight") << "Adding NC total cross section weight calculator";
-    fWcalc->AdoptWghtCalc( "xsec_nc", new GReWeightNuXSecNC );
+    this->AdoptCalculator( "xsec_nc",         new GReWeightNuXSecNC,        kCalcNC );
   }
 
   ///<Configure the DIS (Bodek-Yang) weight calculator
   void GENIEReweight::ConfigureDIS() {
     LOG_INFO("GENIEReweight") << "Adding DIS (Bodek-Yang) weight calculator";
-    fWcalc->AdoptWghtCalc( "xsec_dis",        new GReWeightNuXSecDIS       );
+    this->AdoptCalculator( "xsec_dis",        new GReWeightNuXSecDIS,       kCalcDIS );
     if(!fDISshape) {
       LOG_INFO("GENIEReweight") << "in shape+rate mode";
       GReWeightNuXSecDIS * rwdis = dynamic_cast<GReWeightNuXSecDIS *> (fWcalc->WghtCalc("xsec_dis"));
@@ -741,37 +760,52 @@ namespace rwgt {
   ///<Configure the Coherant model weight calculator
   void GENIEReweight::ConfigureCoh() {
     LOG_INFO("GENIEReweight") << "Adding coherant interaction model weight calculator";
-    fWcalc->AdoptWghtCalc( "xsec_coh",        new GReWeightNuXSecCOH       );
+    this->AdoptCalculator( "xsec_coh",        new GReWeightNuXSecCOH,       kCalcCOH );
   }
 
   ///<Configure the hadronization (AGKY) weight calculator
   void GENIEReweight::ConfigureAGKY() {
     LOG_INFO("GENIEReweight") << "Adding hadronization (AGKY) model weight calculator";
-    fWcalc->AdoptWghtCalc( "hadro_agky",      new GReWeightAGKY            );
+    this->AdoptCalculator( "hadro_agky",      new GReWeightAGKY,            kCalcDIS );
   }
 
   ///<Configure the DIS nuclear model weight calculator
   void GENIEReweight::ConfigureDISNucMod() {
     LOG_INFO("GENIEReweight") << "Adding DIS nuclear model weight calculator";
-    fWcalc->AdoptWghtCalc( "nuclear_dis",     new GReWeightDISNuclMod      );
+    this->AdoptCalculator( "nuclear_dis",     new GReWeightDISNuclMod,      kCalcDIS );
   }
 
   ///<Configure the FG model weight calculator
   void GENIEReweight::ConfigureFGM() {
     LOG_INFO("GENIEReweight") << "Adding Fermi Gas Model (FGM) weight calculator";
-    fWcalc->AdoptWghtCalc( "nuclear_qe",      new GReWeightFGM             );
+    this->AdoptCalculator( "nuclear_qe",      new GReWeightFGM,             kCalcQE | kCalcEL );
   }
 
   ///<Configure the Formation Zone weight calculator
   void GENIEReweight::ConfigureFZone() {
     LOG_INFO("GENIEReweight") << "Adding Formation Zone weight calculator";
-    fWcalc->AdoptWghtCalc( "hadro_fzone",     new GReWeightFZone           );
+    this->AdoptCalculator( "hadro_fzone",     new GReWeightFZone,           kCalcFSI );
   }
 
   ///<Configure the intranuke weight calculator
   void GENIEReweight::ConfigureINuke() {
     LOG_INFO("GENIEReweight") << "Adding the Intra-Nuke weight calculator";
-    fWcalc->AdoptWghtCalc( "hadro_intranuke", new GReWeightINuke           );
+    if(fINukeCached) {
+      LOG_INFO("GENIEReweight") << "using cached hadron survival probabilities";
+      this->AdoptCalculator( "hadro_intranuke", new CachedINukeReweight,    kCalcFSI );
+    }
+    else {
+      this->AdoptCalculator( "hadro_intranuke", new GReWeightINuke,         kCalcFSI );
+    }
+  }
+
+  ///<Hand a weight calculator to GReWeight and remember which interaction
+  ///<types it can change the weight of (kCalcAll: called for every event).
+  void GENIEReweight::AdoptCalculator(std::string const& name, 
+				      genie::rew::GReWeightI* calc, 
+				      int type) {
+    fWcalc->AdoptWghtCalc(name, calc);
+    fCalcType[name] = type;
   }
 
   ///<configure the weight parameters being used
@@ -788,6 +822,14 @@ namespace rwgt {
       }
     }
     fWcalc->Reconfigure();
+
+    //GReWeight keeps its calculators in a map keyed by name and multiplies
+    //their weights in that order; keep the same order so skipping the
+    //calculators that would return 1 leaves the product unchanged.
+    fCalculators.clear();
+    for(std::map<std::string, int>::const_iterator it = fCalcType.begin(); it != fCalcType.end(); ++it) {
+      fCalculators.push_back(std::make_pair(fWcalc->WghtCalc(it->first), it->second));
+    }
   }
 
   ///Used in parameter value mode (instead of parameter sigma mode) Given a user passed parameter value calculate the corresponding sigma value 
@@ -819,11 +861,46 @@ namespace rwgt {
   //double GENIEReweight::CalcWeight(simb::MCTruth truth, simb::GTruth gtruth) {
   double GENIEReweight::CalculateWeight(const genie::EventRecord& evr) {
     //genie::EventRecord evr = this->RetrieveGHEP(truth, gtruth);
-    double wgt = fWcalc->CalcWeight(evr);
+    if(!fDispatchByType || fWcalcShared || fCalculators.empty()) return fWcalc->CalcWeight(evr);
+
+    int type = this->ClassifyEvent(evr);
+    double wgt = 1.0;
+    for(unsigned int i = 0; i < fCalculators.size(); i++) {
+      int need = fCalculators[i].second;
+      if( (need & kCalcCurrent) && !(need & kCalcCurrent & type) ) continue;
+      if( (need & kCalcProcess) && !(need & kCalcProcess & type) ) continue;
+      if( (need & kCalcFSI)     && !(type & kCalcFSI) )            continue;
+      wgt *= fCalculators[i].first->CalcWeight(evr);
+    }
     //mf::LogVerbatim("GENIEReweight") << "New Event Weight is: " << wgt;
     return wgt;
   }
 
+  ///<Classify the event once for CalculateWeight: current, scattering type
+  ///<and whether any hadron was propagated through the nucleus.
+  int GENIEReweight::ClassifyEvent(const genie::EventRecord& evr) const {
+    const genie::Interaction* interaction = evr.Summary();
+    const genie::ProcessInfo& proc = interaction->ProcInfo();
+    int type = 0;
+    if(proc.IsWeakCC())        type |= kCalcCC;
+    if(proc.IsWeakNC())        type |= kCalcNC;
+    if(proc.IsQuasiElastic())  type |= kCalcQE;
+    if(proc.IsElastic())       type |= kCalcEL;
+    if(proc.IsResonant())      type |= kCalcRES;
+    if(proc.IsDeepInelastic()) type |= kCalcDIS;
+    if(proc.IsCoherent())      type |= kCalcCOH;
+
+    if(interaction->InitState().Tgt().IsNucleus()) {
+      for(int i = 0; i < evr.GetEntries(); i++) {
+	if(evr.Particle(i)->Status() == genie::kIStHadronInTheNucleus) {
+	  type |= kCalcFSI;
+	  break;
+	}
+      }
+    }
+    return type;
+  }
+
   /*
   ///< Recreate the a genie::EventRecord from the MCTruth and GTruth objects.
   genie::EventRecord GENIEReweight::RetrieveGHEP(simb::MCTruth truth, simb::GTruth gtruth) {
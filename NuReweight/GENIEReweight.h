@@ -10,6 +10,7 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <string>
 #include <fstream>
 #include "NuReweight/ReweightLabels.h"
 
@@ -19,13 +20,31 @@
 ///GENIE neutrino interaction simulation
 namespace genie { class EventRecord; }
 namespace genie { class AlgFactory;  }
-namespace genie{namespace rew   { class GReWeight; }}
+namespace genie{namespace rew   { class GReWeight; class GReWeightI; }}
 
 namespace rwgt{
 
   class GENIEReweight {
 
   public:
+    ///Interaction types a weight calculator can change the weight of.
+    ///A calculator is called for an event if the event matches one of its
+    ///current bits (if any), one of its process bits (if any) and its FSI
+    ///bit (if set).
+    enum ECalcType {
+      kCalcCC  = 0x01,  ///< weak charged current
+      kCalcNC  = 0x02,  ///< weak neutral current
+      kCalcQE  = 0x04,  ///< quasi-elastic
+      kCalcEL  = 0x08,  ///< elastic
+      kCalcRES = 0x10,  ///< resonant
+      kCalcDIS = 0x20,  ///< deep inelastic
+      kCalcCOH = 0x40,  ///< coherent
+      kCalcFSI = 0x80,  ///< hadrons propagated through the target nucleus
+      kCalcCurrent = kCalcCC | kCalcNC,
+      kCalcProcess = kCalcQE | kCalcEL | kCalcRES | kCalcDIS | kCalcCOH,
+      kCalcAll     = 0
+    };
+
     GENIEReweight();
     ~GENIEReweight();
 
@@ -37,7 +56,14 @@ namespace rwgt{
     double NominalParameterValue(ReweightLabel_t rLabel);
     double ReweightParameterValue(ReweightLabel_t rLabel);
     
-    genie::rew::GReWeight* WeightCalculator() {return fWcalc;}
+    //Calculators adopted through the returned GReWeight are unknown to
+    //the dispatch by type, so once it is handed out every event goes to
+    //GReWeight::CalcWeight (until Reconfigure()).  Prefer AdoptCalculator().
+    genie::rew::GReWeight* WeightCalculator();
+
+    //Add a weight calculator of one's own; it is called only for events
+    //matching the ECalcType mask type, or for every event with kCalcAll
+    void AdoptCalculator(std::string const& name, genie::rew::GReWeightI* calc, int type = kCalcAll);
     
     void Configure();
     void Reconfigure();
@@ -87,10 +113,21 @@ namespace rwgt{
     void UseSigmaDef()    {fUseSigmaDef=true;}
     void UseStandardDef() {fUseSigmaDef=false;}
 
+    //Only call the weight calculators relevant to the interaction type
+    //(default), or hand every event to GReWeight.
+    void DispatchByType() {fDispatchByType=true;}
+    void DispatchAll()    {fDispatchByType=false;}
+
+    //Intranuke weights from per-event cached hadron survival probabilities
+    //(see CachedINukeReweight) or from GENIE's GReWeightINuke (default)
+    void INukeCached() {fINukeCached=true;}
+    void INukeFull()   {fINukeCached=false;}
+
     void SetNominalValues();
     double CalculateSigma(ReweightLabel_t label, double value);
 
     double CalculateWeight(const genie::EventRecord& evr);
+    int    ClassifyEvent(const genie::EventRecord& evr) const;
       
     //genie::EventRecord RetrieveGHEP(simb::MCTruth truth, simb::GTruth gtruth);
     
@@ -139,6 +176,9 @@ namespace rwgt{
     bool fDISshape;
 
     bool fUseSigmaDef;
+    bool fDispatchByType;
+    bool fWcalcShared;     ///< WeightCalculator() was handed out, calculators may be unknown
+    bool fINukeCached;
        
     std::vector<int> fReWgtParameterName;
     std::vector<double> fReWgtParameterValue;
@@ -146,6 +186,9 @@ namespace rwgt{
     std::map<int, double> fNominalParameters;
 
     genie::rew::GReWeight* fWcalc;
+
+    std::map<std::string, int> fCalcType;  ///< ECalcType mask of each adopted calculator
+    std::vector<std::pair<genie::rew::GReWeightI*, int> > fCalculators; ///< in GReWeight order
     
 
   };
@@ -10,14 +10,17 @@
 #include <map>
 #include <fstream>
 #include <memory>
+#include <iostream>
 
 //ROOT includes
 #include "TVector3.h"
 #include "TLorentzVector.h"
 #include "TSystem.h"
+#include "TBufferFile.h"
 
 //GENIE includes
 #include "Conventions/Units.h"
+#include "Conventions/GVersion.h"
 #include "EVGCore/EventRecord.h"
 #include "GHEP/GHepUtils.h"
 
@@ -63,8 +66,12 @@
 #include "SimulationBase/MCParticle.h"
 #include "SimulationBase/MCNeutrino.h"
 #include "SimulationBase/GTruth.h"
+#include "SimulationBase/GHEPRecord.h"
 #include "NuReweight/art/NuReweight.h"
 
+// Framework includes
+#include "cetlib/exception.h"
+
 namespace rwgt {
 
   ///<constructor
@@ -86,6 +93,34 @@ namespace rwgt {
     return wgt;
   }
 
+  double NuReweight::CalcWeight(simb::GHEPRecord const& ghep) {
+    genie::EventRecord evr = this->RetrieveGHEP(ghep);
+    return this->CalculateWeight(evr);
+  }
+
+  genie::EventRecord NuReweight::RetrieveGHEP(simb::GHEPRecord const& ghep) {
+
+    genie::EventRecord newEvent;
+    if(ghep.IsEmpty()) {
+      throw cet::exception("NuReweight") << "RetrieveGHEP: empty simb::GHEPRecord";
+    }
+#ifdef __GENIE_RELEASE_CODE__
+    // the streamed classes carry no schema information of their own, so
+    // a record from another GENIE release can not be read back safely
+    if(ghep.GENIEVersion() != 0 && ghep.GENIEVersion() != __GENIE_RELEASE_CODE__) {
+      throw cet::exception("NuReweight") << "RetrieveGHEP: simb::GHEPRecord written by GENIE release code "
+                                         << ghep.GENIEVersion() << ", can not be read with "
+                                         << __GENIE_RELEASE_CODE__;
+    }
+#endif
+
+    // TBufferFile does not take ownership of the buffer (adopt = false)
+    TBufferFile buf(TBuffer::kRead, ghep.Size(), const_cast<char*>(ghep.Buffer()), false);
+    newEvent.Streamer(buf);
+
+    return newEvent;
+  }
+
   genie::EventRecord NuReweight::RetrieveGHEP(simb::MCTruth truth, simb::GTruth gtruth) {
     
     genie::EventRecord newEvent;
@@ -9,6 +9,7 @@
 
 namespace simb  { class MCTruth;      }
 namespace simb  { class GTruth;       }
+namespace simb  { class GHEPRecord;   }
 
 namespace rwgt{
 
@@ -19,9 +20,17 @@ namespace rwgt{
     ~NuReweight();
     
     double CalcWeight(simb::MCTruth truth, simb::GTruth gtruth);
-    
-  private:
+
+    // Rebuild the genie::EventRecord; build it once and pass it to
+    // CalculateWeight() when weighting the same event for many universes
     genie::EventRecord RetrieveGHEP(simb::MCTruth truth, simb::GTruth gtruth);
+
+    // Weight / read back the record stored at generation time
+    // (evgb::GENIEHelper::PackGHEPRecord); exact and without the
+    // reconstruction above.  Throws if the record was written by
+    // another GENIE release.
+    double CalcWeight(simb::GHEPRecord const& ghep);
+    genie::EventRecord RetrieveGHEP(simb::GHEPRecord const& ghep);
     
     
   };
@@ -0,0 +1,352 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  nureweight.cc
+/// \brief Standalone GENIE reweighting of MCTruth/GTruth in art files
+///
+/// Reads the simb::MCTruth and simb::GTruth products of one module
+/// label straight from the Events tree of art ROOT files (only the
+/// dictionaries are needed, not the framework) and writes one entry
+/// per MCTruth with the event id, a few neutrino quantities and one
+/// float branch per universe, w0, w1, ...:
+///
+///   nureweight -o weights.root [-l generator] [-j nworkers] [-c]
+///              -u MaCCQE=1 -u MaCCQE=-1 -u MaCCRES=1,MaNCRES=1 ...
+///              file1.root [file2.root ...]
+///
+/// Each -u defines a universe as a comma separated list of GENIE
+/// systematic names (genie::rew::GSyst) and sigma values; the names are
+/// stored in the output as TNamed w<i>.  -c uses the cached intranuke
+/// calculator.  If the files also hold simb::GHEPRecords with the same
+/// label the stored genie::EventRecord is used as is instead of being
+/// rebuilt from MCTruth and GTruth.
+///
+/// GENIE keeps its algorithms, random numbers and messenger in process
+/// wide singletons that are not thread safe, so the -j workers are
+/// forked processes rather than threads.  The reweighters are
+/// configured before forking so the workers share the loaded GENIE
+/// state; each worker takes a contiguous block of the input entries and
+/// writes its own file, and the blocks are merged in order at the end.
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+// ROOT includes
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TNamed.h"
+#include "TFileMerger.h"
+#include "TSystem.h"
+#include "TROOT.h"
+#include "Cintex/Cintex.h"
+
+// GENIE includes
+#include "EVGCore/EventRecord.h"
+#include "ReWeight/GSyst.h"
+
+// art includes, for the persistent classes only
+#include "art/Persistency/Common/Wrapper.h"
+#include "art/Persistency/Provenance/EventAuxiliary.h"
+
+// NuTools includes
+#include "SimulationBase/MCTruth.h"
+#include "SimulationBase/GTruth.h"
+#include "SimulationBase/GHEPRecord.h"
+#include "SimulationBase/MCNeutrino.h"
+#include "NuReweight/art/NuReweight.h"
+
+namespace {
+
+  typedef art::Wrapper< std::vector<simb::MCTruth> > MCTruthWrapper;
+  typedef art::Wrapper< std::vector<simb::GTruth>  > GTruthWrapper;
+  typedef art::Wrapper< std::vector<simb::GHEPRecord> > GHEPWrapper;
+
+  //......................................................................
+  void Usage()
+  {
+    std::cerr << "usage: nureweight -o out.root [-l label] [-j nworkers] [-c]\n"
+              << "                  -u Syst=sigma[,Syst=sigma...] [-u ...] file.root [...]"
+              << std::endl;
+    std::exit(1);
+  }
+
+  //......................................................................
+  /// A configured reweighter for "MaCCQE=1,MaCCRES=-1"
+  rwgt::NuReweight* MakeUniverse(std::string const& spec, bool cachedINuke)
+  {
+    rwgt::NuReweight* rw = new rwgt::NuReweight();
+    if (cachedINuke) rw->INukeCached();
+
+    std::stringstream ss(spec);
+    std::string knob;
+    while (std::getline(ss, knob, ',')) {
+      size_t ieq = knob.find('=');
+      if (ieq == std::string::npos) {
+        std::cerr << "nureweight: no sigma in \"" << knob << "\"" << std::endl;
+        std::exit(1);
+      }
+      genie::rew::GSyst_t syst = genie::rew::GSyst::FromString(knob.substr(0, ieq));
+      if (syst == genie::rew::kNullSystematic) {
+        std::cerr << "nureweight: unknown systematic \"" << knob.substr(0, ieq) << "\"" << std::endl;
+        std::exit(1);
+      }
+      rw->AddReweightValue((rwgt::ReweightLabel_t)syst, std::atof(knob.substr(ieq+1).c_str()));
+    }
+    rw->Configure();
+    return rw;
+  }
+
+  //......................................................................
+  /// the branch of the Events tree holding "simb::<type>s_<label>__*"
+  TBranch* FindProduct(TTree* events, std::string const& type, std::string const& label)
+  {
+    std::string prefix = "simb::" + type + "s_" + label + "__";
+    TObjArray* branches = events->GetListOfBranches();
+    for (int i = 0; i < branches->GetEntriesFast(); ++i) {
+      TBranch* b = (TBranch*)branches->At(i);
+      if (std::strncmp(b->GetName(), prefix.c_str(), prefix.size()) == 0) return b;
+    }
+    return 0;
+  }
+
+  //......................................................................
+  /// Weight the global entries [first, last) of the input files into
+  /// outname.  Returns the number of MCTruths weighted.
+  long Process(std::vector<std::string>        const& files,
+               std::vector<Long64_t>           const& nentries,
+               Long64_t first, Long64_t last,
+               std::string                     const& label,
+               std::vector<std::string>        const& specs,
+               std::vector<rwgt::NuReweight*>  const& universes,
+               std::string                     const& outname,
+               bool                                   writeNames)
+  {
+    TFile out(outname.c_str(), "RECREATE");
+    TTree* tree = new TTree("rwgt", "GENIE weights per MCTruth");
+
+    UInt_t  run = 0, subrun = 0, event = 0;
+    Int_t   truthIdx = 0, nuPdg = 0, ccnc = 0, mode = 0;
+    Float_t enu = 0.;
+    std::vector<Float_t> w(universes.size(), 1.);
+
+    tree->Branch("run",    &run,      "run/i");
+    tree->Branch("subrun", &subrun,   "subrun/i");
+    tree->Branch("event",  &event,    "event/i");
+    tree->Branch("truth",  &truthIdx, "truth/I");
+    tree->Branch("nupdg",  &nuPdg,    "nupdg/I");
+    tree->Branch("ccnc",   &ccnc,     "ccnc/I");
+    tree->Branch("mode",   &mode,     "mode/I");
+    tree->Branch("enu",    &enu,      "enu/F");
+    for (size_t u = 0; u < universes.size(); ++u) {
+      std::stringstream name;
+      name << "w" << u;
+      tree->Branch(name.str().c_str(), &w[u], (name.str() + "/F").c_str());
+      if (writeNames) TNamed(name.str().c_str(), specs[u].c_str()).Write();
+    }
+
+    long     nweighted = 0;
+    Long64_t offset    = 0;
+    for (size_t f = 0; f < files.size(); offset += nentries[f], ++f) {
+      if (offset + nentries[f] <= first || offset >= last) continue;
+
+      TFile* in = TFile::Open(files[f].c_str());
+      TTree* events = in ? (TTree*)in->Get("Events") : 0;
+      if (!events) {
+        std::cerr << "nureweight: no Events tree in " << files[f] << std::endl;
+        delete in;
+        continue;
+      }
+      TBranch* mcBranch  = FindProduct(events, "MCTruth", label);
+      TBranch* gtBranch  = FindProduct(events, "GTruth",  label);
+      TBranch* ghBranch  = FindProduct(events, "GHEPRecord", label);
+      TBranch* auxBranch = events->GetBranch("EventAuxiliary");
+      if (!mcBranch || !gtBranch || !auxBranch) {
+        std::cerr << "nureweight: no MCTruth/GTruth with label " << label
+                  << " in " << files[f] << std::endl;
+        delete in;
+        continue;
+      }
+
+      MCTruthWrapper*      mcw = 0;
+      GTruthWrapper*       gtw = 0;
+      GHEPWrapper*         ghw = 0;
+      art::EventAuxiliary* aux = 0;
+      mcBranch ->SetAddress(&mcw);
+      gtBranch ->SetAddress(&gtw);
+      if (ghBranch) ghBranch->SetAddress(&ghw);
+      auxBranch->SetAddress(&aux);
+
+      Long64_t begin = std::max(first - offset, (Long64_t)0);
+      Long64_t end   = std::min(last  - offset, nentries[f]);
+      for (Long64_t i = begin; i < end; ++i) {
+        mcBranch ->GetEntry(i);
+        gtBranch ->GetEntry(i);
+        auxBranch->GetEntry(i);
+        if (ghBranch) ghBranch->GetEntry(i);
+        if (!mcw->isPresent() || !gtw->isPresent()) continue;
+
+        std::vector<simb::MCTruth> const& mclist = *mcw->product();
+        std::vector<simb::GTruth>  const& gtlist = *gtw->product();
+        std::vector<simb::GHEPRecord> const* ghlist =
+          (ghw && ghw->isPresent()) ? ghw->product() : 0;
+
+        run    = aux->id().run();
+        subrun = aux->id().subRun();
+        event  = aux->id().event();
+
+        for (size_t t = 0; t < mclist.size() && t < gtlist.size(); ++t) {
+          simb::MCNeutrino const& nu = mclist[t].GetNeutrino();
+          truthIdx = t;
+          nuPdg    = nu.Nu().PdgCode();
+          ccnc     = nu.CCNC();
+          mode     = nu.Mode();
+          enu      = nu.Nu().E();
+
+          // one GHEP record for all universes, the stored one if there is one
+          bool stored = ( ghlist && t < ghlist->size() && !(*ghlist)[t].IsEmpty() );
+          genie::EventRecord evr = stored ?
+            universes[0]->RetrieveGHEP((*ghlist)[t]) :
+            universes[0]->RetrieveGHEP(mclist[t], gtlist[t]);
+          for (size_t u = 0; u < universes.size(); ++u)
+            w[u] = universes[u]->CalculateWeight(evr);
+
+          tree->Fill();
+          ++nweighted;
+        }
+      }
+
+      mcBranch ->ResetAddress();
+      gtBranch ->ResetAddress();
+      auxBranch->ResetAddress();
+      if (ghBranch) ghBranch->ResetAddress();
+      delete mcw;
+      delete gtw;
+      delete ghw;
+      delete aux;
+      delete in;
+    }
+
+    out.cd();
+    tree->Write();
+    out.Close();
+    return nweighted;
+  }
+
+}
+
+//......................................................................
+int main(int argc, char** argv)
+{
+  std::string              outname;
+  std::string              label    = "generator";
+  int                      nworkers = 1;
+  bool                     cached   = false;
+  std::vector<std::string> specs;
+  std::vector<std::string> files;
+
+  for (int i = 1; i < argc; ++i) {
+    if      (std::strcmp(argv[i], "-o") == 0 && i+1 < argc) outname  = argv[++i];
+    else if (std::strcmp(argv[i], "-l") == 0 && i+1 < argc) label    = argv[++i];
+    else if (std::strcmp(argv[i], "-j") == 0 && i+1 < argc) nworkers = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "-u") == 0 && i+1 < argc) specs.push_back(argv[++i]);
+    else if (std::strcmp(argv[i], "-c") == 0)               cached   = true;
+    else if (argv[i][0] == '-')                             Usage();
+    else                                                    files.push_back(argv[i]);
+  }
+  if (outname.empty() || specs.empty() || files.empty()) Usage();
+  if (nworkers < 1) nworkers = 1;
+
+  gROOT->SetBatch(true);
+  ROOT::Cintex::Cintex::Enable();
+  gSystem->Load("libart_Persistency_Provenance_dict");
+  gSystem->Load("libart_Persistency_Common_dict");
+  gSystem->Load("libSimulationBase_dict");
+
+  // count the entries so the workers can split them evenly
+  std::vector<Long64_t> nentries(files.size(), 0);
+  Long64_t total = 0;
+  for (size_t f = 0; f < files.size(); ++f) {
+    TFile* in = TFile::Open(files[f].c_str());
+    TTree* events = in ? (TTree*)in->Get("Events") : 0;
+    if (events) nentries[f] = events->GetEntries();
+    total += nentries[f];
+    delete in;
+  }
+
+  // configure every universe once, before forking
+  std::vector<rwgt::NuReweight*> universes;
+  for (size_t u = 0; u < specs.size(); ++u)
+    universes.push_back(MakeUniverse(specs[u], cached));
+
+  if (nworkers > total) nworkers = std::max(total, (Long64_t)1);
+
+  if (nworkers == 1) {
+    long n = Process(files, nentries, 0, total, label, specs, universes, outname, true);
+    std::cout << "nureweight: " << n << " interactions, "
+              << universes.size() << " universes -> " << outname << std::endl;
+    return 0;
+  }
+
+  std::vector<std::string> parts;
+  std::vector<pid_t>       pids;
+  for (int iw = 0; iw < nworkers; ++iw) {
+    std::stringstream part;
+    part << outname << ".part" << iw;
+    parts.push_back(part.str());
+
+    std::cout.flush();
+    std::fflush(0);
+    pid_t pid = fork();
+    if (pid < 0) {
+      std::perror("nureweight: fork");
+      return 1;
+    }
+    if (pid == 0) {
+      Long64_t first = total*iw/nworkers;
+      Long64_t last  = total*(iw+1)/nworkers;
+      long n = Process(files, nentries, first, last, label, specs, universes,
+                       part.str(), iw == 0);
+      std::cout << "nureweight: worker " << iw << " entries [" << first << ","
+                << last << ") " << n << " interactions" << std::endl;
+      std::cout.flush();
+      std::fflush(0);
+      _exit(0);
+    }
+    pids.push_back(pid);
+  }
+
+  bool ok = true;
+  for (size_t iw = 0; iw < pids.size(); ++iw) {
+    int status = 0;
+    waitpid(pids[iw], &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      std::cerr << "nureweight: worker " << iw << " failed" << std::endl;
+      ok = false;
+    }
+  }
+  if (!ok) return 1;
+
+  // the parts are contiguous blocks, so merging them in order keeps the
+  // input order
+  TFileMerger merger(false);
+  merger.OutputFile(outname.c_str());
+  for (size_t iw = 0; iw < parts.size(); ++iw) merger.AddFile(parts[iw].c_str());
+  if (!merger.Merge()) {
+    std::cerr << "nureweight: merging the worker outputs failed" << std::endl;
+    return 1;
+  }
+  for (size_t iw = 0; iw < parts.size(); ++iw) gSystem->Unlink(parts[iw].c_str());
+
+  std::cout << "nureweight: " << universes.size() << " universes, "
+            << nworkers << " workers -> " << outname << std::endl;
+  return 0;
+}
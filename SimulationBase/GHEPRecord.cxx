@@ -0,0 +1,37 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  GHEPRecord.cxx
+/// \brief Serialized copy of the genie::EventRecord of an interaction
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+#include "SimulationBase/GHEPRecord.h"
+
+namespace simb {
+
+  //---------------------------------------------------------------
+  GHEPRecord::GHEPRecord()
+    : fGENIEVersion(0)
+  {
+  }
+
+  //---------------------------------------------------------------
+  void GHEPRecord::SetBuffer(const char* data, unsigned int size)
+  {
+    fBuffer.assign(data, data + size);
+  }
+
+  //---------------------------------------------------------------
+  void GHEPRecord::Clear()
+  {
+    fBuffer.clear();
+    fGENIEVersion = 0;
+  }
+
+  //---------------------------------------------------------------
+  const char* GHEPRecord::Buffer() const
+  {
+    return fBuffer.empty() ? 0 : &fBuffer[0];
+  }
+
+} // namespace simb
@@ -0,0 +1,47 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  GHEPRecord.h
+/// \brief Serialized copy of the genie::EventRecord of an interaction
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+/// GTruth holds enough to rebuild an approximate genie::EventRecord
+/// for reweighting; some of the record (e.g. the kinematic phase space
+/// of the differential cross section) is lost on the way.  GHEPRecord
+/// instead keeps the record itself, streamed by ROOT into a byte
+/// buffer at generation time (evgb::GENIEHelper::PackGHEPRecord) and
+/// read back without any reconstruction (rwgt::NuReweight).  The bytes
+/// are only interpreted by code linked against GENIE, so this class
+/// does not depend on it.
+
+#ifndef SIMB_GHEPRECORD_H
+#define SIMB_GHEPRECORD_H
+
+#include <vector>
+
+namespace simb {
+
+  class GHEPRecord {
+
+  public:
+    GHEPRecord();
+
+    void         SetBuffer(const char* data, unsigned int size);
+    void         SetGENIEVersion(int v) { fGENIEVersion = v;     }
+    void         Clear();
+
+    const char*  Buffer()       const;
+    unsigned int Size()         const { return fBuffer.size();  }
+    bool         IsEmpty()      const { return fBuffer.empty(); }
+    int          GENIEVersion() const { return fGENIEVersion;   }
+
+  private:
+
+    std::vector<char> fBuffer;       ///< genie::EventRecord as written by its Streamer
+    int               fGENIEVersion; ///< GENIE version code of the writer, 0 if unknown
+
+  };
+
+} // end simb namespace
+
+#endif // SIMB_GHEPRECORD_H
@@ -84,6 +84,9 @@ namespace simb{
     , fgenz(-999.)
     , fdk2gen(-999.)
     , fgen2vtx(-999.)
+    , fFluxFile(-1)
+    , fFluxEntry(-1)
+    , fIsFluxRef(false)
   {
 
     for (int i=0; i<6; ++i) fFluxGen[i]=fFluxPos[i]=fFluxNeg[i]= 0;
@@ -162,6 +165,10 @@ namespace simb{
     fdk2gen   = -999.;
     fgen2vtx  = -999.;
 
+    fFluxFile  = -1;
+    fFluxEntry = -1;
+    fIsFluxRef = false;
+
     return;
   }
 
@@ -102,6 +102,12 @@ namespace simb{
     double fdk2gen;   ///< distance from decay to ray origin
     double fgen2vtx;  ///< distance from ray origin to event vtx
 
+    int       fFluxFile;  ///< flux file this neutrino came from, index into the
+                          ///< SubRun's simb::MCFluxFiles
+    long long fFluxEntry; ///< entry of that flux file
+    bool      fIsFluxRef; ///< only the file, entry and a few fields are filled, see 
+                          ///< evgb::FluxMaterializer for the rest
+
    private:
 
     float fFluxPos[6]; ///< e,ebar,mu,mubar,tau,taubar flux, +horn focus
@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  MCFluxFiles.cxx
+/// \brief Ordered list of the flux files a set of MCFlux objects refer to
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+#include "SimulationBase/MCFluxFiles.h"
+
+#include <iostream>
+
+namespace {
+
+  std::string BaseName(std::string const& path)
+  {
+    std::string::size_type slash = path.find_last_of('/');
+    return ( slash == std::string::npos ) ? path : path.substr(slash+1);
+  }
+
+}
+
+namespace simb {
+
+  //---------------------------------------------------------------
+  MCFluxFiles::MCFluxFiles()
+  {
+  }
+
+  //---------------------------------------------------------------
+  MCFluxFiles::MCFluxFiles(std::string const& fluxType)
+    : fFluxType(fluxType)
+  {
+  }
+
+  //---------------------------------------------------------------
+  void MCFluxFiles::Add(std::string const& file, long long entries)
+  {
+    fFiles.push_back(file);
+    fEntries.push_back(entries);
+  }
+
+  //---------------------------------------------------------------
+  long long MCFluxFiles::TotalEntries() const
+  {
+    long long n = 0;
+    for ( size_t i = 0; i < fEntries.size(); ++i ) n += fEntries[i];
+    return n;
+  }
+
+  //---------------------------------------------------------------
+  bool MCFluxFiles::Locate(long long  chainEntry,
+                           int&       file,
+                           long long& entry) const
+  {
+    file  = -1;
+    entry = -1;
+    if ( chainEntry < 0 ) return false;
+
+    for ( size_t i = 0; i < fEntries.size(); ++i ) {
+      if ( chainEntry < fEntries[i] ) {
+        file  = i;
+        entry = chainEntry;
+        return true;
+      }
+      chainEntry -= fEntries[i];
+    }
+
+    return false;
+  }
+
+  //---------------------------------------------------------------
+  long long MCFluxFiles::ChainEntry(int file, long long entry) const
+  {
+    if ( file < 0 || file >= (int)fEntries.size() ||
+         entry < 0 || entry >= fEntries[file] ) return -1;
+
+    long long offset = 0;
+    for ( int i = 0; i < file; ++i ) offset += fEntries[i];
+
+    return offset + entry;
+  }
+
+  //---------------------------------------------------------------
+  bool MCFluxFiles::SameFiles(MCFluxFiles const& other) const
+  {
+    if ( fFluxType != other.fFluxType  ) return false;
+    if ( fFiles.size() != other.fFiles.size() ) return false;
+
+    for ( size_t i = 0; i < fFiles.size(); ++i ) {
+      if ( fEntries[i] != other.fEntries[i] ) return false;
+      if ( BaseName(fFiles[i]) != BaseName(other.fFiles[i]) ) return false;
+    }
+
+    return true;
+  }
+
+  //---------------------------------------------------------------
+  std::ostream& operator<< (std::ostream& output, MCFluxFiles const& files)
+  {
+    output << files.fFluxType << " flux, " << files.fFiles.size() << " files" << std::endl;
+    for ( size_t i = 0; i < files.fFiles.size(); ++i )
+      output << "  " << i << " " << files.fFiles[i]
+             << " (" << files.fEntries[i] << " entries)" << std::endl;
+
+    return output;
+  }
+
+} // namespace simb
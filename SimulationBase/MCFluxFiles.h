@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  MCFluxFiles.h
+/// \brief Ordered list of the flux files a set of MCFlux objects refer to
+///
+/// \version $Id$
+////////////////////////////////////////////////////////////////////////
+
+/// When evgb::GENIEHelper runs with FluxRefMode set, each simb::MCFlux
+/// only records which flux file (MCFlux::fFluxFile, an index into this
+/// list) and which entry of that file (MCFlux::fFluxEntry) the neutrino
+/// came from.  The generating module puts the list in the SubRun
+/// (evgb::GENIEHelper::FluxFileList()) so that evgb::FluxMaterializer
+/// can check it is reading the same files, in the same order, before it
+/// fills in the rest of the record.
+///
+/// Files are identified by their base name and number of entries, so
+/// the list still matches when the files have been copied to another
+/// directory.
+
+#ifndef SIMB_MCFLUXFILES_H
+#define SIMB_MCFLUXFILES_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace simb {
+
+  class MCFluxFiles {
+
+  public:
+    MCFluxFiles();
+
+  private:
+
+    std::string               fFluxType;  ///< GENIEHelper flux type of the files
+    std::vector<std::string>  fFiles;     ///< flux files, in the order the flux driver chained them
+    std::vector<long long>    fEntries;   ///< number of flux entries in each file
+
+#ifndef __GCCXML__
+
+  public:
+
+    explicit MCFluxFiles(std::string const& fluxType);
+
+    void               Add(std::string const& file, long long entries);
+
+    std::string const& FluxType()           const { return fFluxType;       }
+    unsigned int       NFiles()             const { return fFiles.size();   }
+    std::string const& File(unsigned int i) const { return fFiles[i];       }
+    long long          Entries(unsigned int i) const { return fEntries[i];  }
+    long long          TotalEntries()       const;
+
+    /// convert an entry of the chain of all files into a file index and
+    /// an entry of that file; returns false if the entry is out of range
+    bool               Locate(long long chainEntry,
+                              int&      file,
+                              long long& entry) const;
+
+    /// entry of the chain of all files of the given file index and entry
+    long long          ChainEntry(int file, long long entry) const;
+
+    /// true if both lists hold the same flux type and, in the same order,
+    /// files with the same base names and numbers of entries
+    bool               SameFiles(MCFluxFiles const& other) const;
+
+    friend std::ostream& operator<< (std::ostream& output, MCFluxFiles const& files);
+
+#endif
+
+  };
+
+} // end simb namespace
+
+#endif // SIMB_MCFLUXFILES_H
@@ -37,12 +37,12 @@ namespace simb {
     , fprocess()
     , fendprocess()
     , fmass(s_uninitialized)
-    , fpolarization()
     , fdaughters()
     , fWeight(s_uninitialized)
-    , fGvtx()
     , frescatter(s_uninitialized)
   {
+    SetPolarization(TVector3());
+    SetGvtx(0, 0, 0, 0);
   }
 
   //------------------------------------------------------------
@@ -60,12 +60,12 @@ namespace simb {
     , fprocess(process)
     , fendprocess(std::string())
     , fmass(mass)
-    , fpolarization()
     , fdaughters()
     , fWeight(0.)
-    , fGvtx()
     , frescatter(s_uninitialized)
   {
+    SetPolarization(TVector3());
+
     // If the user has supplied a mass, use it.  Otherwise, get the
     // particle mass from the PDG table.
     if ( mass < 0 ){
@@ -93,9 +93,10 @@ namespace simb {
     , ftrajectory(p.Trajectory())
     , fmass(p.Mass())
     , fWeight(p.Weight())
-    , fGvtx(p.GetGvtx())
     , frescatter(p.Rescatter())
   {
+    SetPolarization(p.Polarization());
+    SetGvtx(p.GetGvtx());
     for(int i=0; i<p.NumberDaughters(); i++)
       fdaughters.insert(p.Daughter(i)+offset);
   }
@@ -139,16 +140,16 @@ namespace simb {
   //----------------------------------------------------------------------------
   void MCParticle::SetGvtx(TLorentzVector v)
   {
-    fGvtx = v;
+    v.GetXYZT(fGvtx);
   }
   
   //----------------------------------------------------------------------------
   void MCParticle::SetGvtx(double x, double y, double z, double t) 
   {
-    fGvtx.SetX(x);
-    fGvtx.SetY(y);
-    fGvtx.SetZ(z);
-    fGvtx.SetT(t);
+    fGvtx[0] = x;
+    fGvtx[1] = y;
+    fGvtx[2] = z;
+    fGvtx[3] = t;
   }
 
   //------------------------------------------------------------
@@ -7,6 +7,13 @@
 
 /// This class describes a particle created in the detector Monte
 /// Carlo simulation.
+///
+/// The polarization and generator vertex are stored as plain double
+/// arrays rather than TVector3/TLorentzVector so that they are written
+/// without TObject headers; Polarization() and GetGvtx() return them
+/// by value, as Position() and Momentum() return the points of the
+/// packed MCTrajectory.  Files written with ClassVersion 18 and earlier are
+/// converted by a read rule in classes_def.xml.
 
 #ifndef SIMB_MCPARTICLE_H
 #define SIMB_MCPARTICLE_H
@@ -43,10 +50,10 @@ namespace simb {
     std::string             fendprocess;    ///< end process for the particle
     simb::MCTrajectory      ftrajectory;    ///< particle trajectory (position,momentum)
     double                  fmass;          ///< Mass; from PDG unless overridden Should be in GeV
-    TVector3                fpolarization;  ///< Polarization
+    double                  fpolarization[3]; ///< Polarization (x,y,z)
     daughters_type          fdaughters;     ///< Sorted list of daughters of this particle.
     double                  fWeight;        ///< Assigned weight to this particle for MC tests
-    TLorentzVector          fGvtx;          ///< Vertex needed by generater (genie) to rebuild 
+    double                  fGvtx[4];       ///< Vertex (x,y,z,t) needed by generater (genie) to rebuild 
                                             ///< genie::EventRecord for event reweighting
     int                     frescatter;     ///< rescatter code
 
@@ -93,7 +100,7 @@ namespace simb {
     // emits a photon with high kinetic energy.
     int Mother() const;
 
-    const TVector3& Polarization() const;
+    TVector3        Polarization() const;
     void            SetPolarization( const TVector3& p );
 
     // The detector-simulation physics process that created the
@@ -118,19 +125,19 @@ namespace simb {
     // To avoid confusion with the X() and Y() methods of MCTruth
     // (which return Feynmann x and y), use "Vx,Vy,Vz" for the
     // vertex.
-    const TLorentzVector& Position( const int i = 0 ) const;
+    TLorentzVector        Position( const int i = 0 ) const;
     double                Vx(const int i = 0)         const;
     double 		  Vy(const int i = 0) 	      const;
     double 		  Vz(const int i = 0) 	      const;
     double 		   T(const int i = 0) 	      const;
 				                                                     
-    const TLorentzVector& EndPosition() const;
+    TLorentzVector        EndPosition() const;
     double                EndX()        const;
     double          	  EndY()        const;
     double          	  EndZ()        const;
     double          	  EndT()        const;
 
-    const TLorentzVector& Momentum( const int i = 0 ) const;
+    TLorentzVector        Momentum( const int i = 0 ) const;
     double                Px(const int i = 0)         const;
     double          	  Py(const int i = 0) 	      const;
     double          	  Pz(const int i = 0) 	      const;
@@ -139,7 +146,7 @@ namespace simb {
     double          	  Pt(const int i = 0) 	      const;
     double          	  Mass()                      const;
 
-    const TLorentzVector& EndMomentum() const;
+    TLorentzVector        EndMomentum() const;
     double                EndPx()       const;
     double          	  EndPy()       const;
     double          	  EndPz()       const;
@@ -213,44 +220,44 @@ inline       int             simb::MCParticle::TrackId()                const {
 inline 	     int             simb::MCParticle::StatusCode()    	    	const { return fstatus;            		   }
 inline 	     int             simb::MCParticle::PdgCode()       	    	const { return fpdgCode;           		   }
 inline 	     int             simb::MCParticle::Mother()        	    	const { return fmother;            		   }
-inline const TVector3&       simb::MCParticle::Polarization()  	    	const { return fpolarization;      		   }
+inline       TVector3        simb::MCParticle::Polarization()  	    	const { return TVector3(fpolarization);		   }
 inline       std::string     simb::MCParticle::Process()       	    	const { return fprocess;           		   }
 inline       std::string     simb::MCParticle::EndProcess()       	const { return fendprocess;           		   }
 inline       int             simb::MCParticle::NumberDaughters() 	const { return fdaughters.size();  		   }
 inline       unsigned int    simb::MCParticle::NumberTrajectoryPoints() const { return ftrajectory.size(); 		   }
-inline const TLorentzVector& simb::MCParticle::Position( const int i )  const { return ftrajectory.Position(i);            }
-inline const TLorentzVector& simb::MCParticle::Momentum( const int i )  const { return ftrajectory.Momentum(i);            }
-inline       double          simb::MCParticle::Vx(const int i)          const { return Position(i).X();    		   }
-inline       double          simb::MCParticle::Vy(const int i)          const { return Position(i).Y();    		   }
-inline       double          simb::MCParticle::Vz(const int i)          const { return Position(i).Z();    		   }
-inline       double          simb::MCParticle::T(const int i)           const { return Position(i).T();    		   }
-inline const TLorentzVector& simb::MCParticle::EndPosition()            const { return Position(ftrajectory.size()-1);     }
-inline       double          simb::MCParticle::EndX()                   const { return Position(ftrajectory.size()-1).X(); }
-inline       double          simb::MCParticle::EndY()                   const { return Position(ftrajectory.size()-1).Y(); }
-inline       double          simb::MCParticle::EndZ()                   const { return Position(ftrajectory.size()-1).Z(); }
-inline       double          simb::MCParticle::EndT()                   const { return Position(ftrajectory.size()-1).T(); }
-inline       double          simb::MCParticle::Px(const int i)          const { return Momentum(i).Px();                   }
-inline       double          simb::MCParticle::Py(const int i)          const { return Momentum(i).Py();    	           }
-inline       double          simb::MCParticle::Pz(const int i)          const { return Momentum(i).Pz();    	           }
-inline       double          simb::MCParticle::E(const int i)           const { return Momentum(i).E();     	           }
-inline       double          simb::MCParticle::P(const int i)           const { return std::sqrt(std::pow(Momentum(i).E(),
+inline       TLorentzVector  simb::MCParticle::Position( const int i )  const { return ftrajectory.Position(i);            }
+inline       TLorentzVector  simb::MCParticle::Momentum( const int i )  const { return ftrajectory.Momentum(i);            }
+inline       double          simb::MCParticle::Vx(const int i)          const { return ftrajectory.X(i);    		   }
+inline       double          simb::MCParticle::Vy(const int i)          const { return ftrajectory.Y(i);    		   }
+inline       double          simb::MCParticle::Vz(const int i)          const { return ftrajectory.Z(i);    		   }
+inline       double          simb::MCParticle::T(const int i)           const { return ftrajectory.T(i);    		   }
+inline       TLorentzVector  simb::MCParticle::EndPosition()            const { return Position(ftrajectory.size()-1);     }
+inline       double          simb::MCParticle::EndX()                   const { return ftrajectory.X(ftrajectory.size()-1); }
+inline       double          simb::MCParticle::EndY()                   const { return ftrajectory.Y(ftrajectory.size()-1); }
+inline       double          simb::MCParticle::EndZ()                   const { return ftrajectory.Z(ftrajectory.size()-1); }
+inline       double          simb::MCParticle::EndT()                   const { return ftrajectory.T(ftrajectory.size()-1); }
+inline       double          simb::MCParticle::Px(const int i)          const { return ftrajectory.Px(i);                   }
+inline       double          simb::MCParticle::Py(const int i)          const { return ftrajectory.Py(i);    	           }
+inline       double          simb::MCParticle::Pz(const int i)          const { return ftrajectory.Pz(i);    	           }
+inline       double          simb::MCParticle::E(const int i)           const { return ftrajectory.E(i);     	           }
+inline       double          simb::MCParticle::P(const int i)           const { return std::sqrt(std::pow(ftrajectory.E(i),
        											      2.)  
        										     - std::pow(fmass,2.));                }
-inline       double          simb::MCParticle::Pt(const int i)          const { return std::sqrt(std::pow(Momentum(i).Px(),
+inline       double          simb::MCParticle::Pt(const int i)          const { return std::sqrt(std::pow(ftrajectory.Px(i),
        											      2.) 
-       										     + std::pow(Momentum(i).Py(),
+       										     + std::pow(ftrajectory.Py(i),
        												2.));                      }
 inline       double          simb::MCParticle::Mass()                   const { return fmass;                              }
-inline const TLorentzVector& simb::MCParticle::EndMomentum()            const { return Momentum(ftrajectory.size()-1);     }
-inline       double          simb::MCParticle::EndPx()                  const { return Momentum(ftrajectory.size()-1).X(); }
-inline       double          simb::MCParticle::EndPy()                  const { return Momentum(ftrajectory.size()-1).Y(); }
-inline       double          simb::MCParticle::EndPz()                  const { return Momentum(ftrajectory.size()-1).Z(); }
-inline       double          simb::MCParticle::EndE()                   const { return Momentum(ftrajectory.size()-1).T(); }
-inline       TLorentzVector  simb::MCParticle::GetGvtx()                const { return fGvtx;                              }
-inline       double          simb::MCParticle::Gvx()                    const { return fGvtx.X();                          }
-inline       double          simb::MCParticle::Gvy()                    const { return fGvtx.Y();                          }
-inline       double          simb::MCParticle::Gvz()                    const { return fGvtx.Z();                          }
-inline       double          simb::MCParticle::Gvt()                    const { return fGvtx.T();                          }
+inline       TLorentzVector  simb::MCParticle::EndMomentum()            const { return Momentum(ftrajectory.size()-1);     }
+inline       double          simb::MCParticle::EndPx()                  const { return ftrajectory.Px(ftrajectory.size()-1); }
+inline       double          simb::MCParticle::EndPy()                  const { return ftrajectory.Py(ftrajectory.size()-1); }
+inline       double          simb::MCParticle::EndPz()                  const { return ftrajectory.Pz(ftrajectory.size()-1); }
+inline       double          simb::MCParticle::EndE()                   const { return ftrajectory.E(ftrajectory.size()-1);  }
+inline       TLorentzVector  simb::MCParticle::GetGvtx()                const { return TLorentzVector(fGvtx);              }
+inline       double          simb::MCParticle::Gvx()                    const { return fGvtx[0];                           }
+inline       double          simb::MCParticle::Gvy()                    const { return fGvtx[1];                           }
+inline       double          simb::MCParticle::Gvz()                    const { return fGvtx[2];                           }
+inline       double          simb::MCParticle::Gvt()                    const { return fGvtx[3];                           }
 inline       int             simb::MCParticle::FirstDaughter()          const { return *(fdaughters.begin());              }
 inline       int             simb::MCParticle::LastDaughter()           const { return *(fdaughters.rbegin());             }
 inline       int             simb::MCParticle::Rescatter()              const { return frescatter;                         }
@@ -263,7 +270,7 @@ inline       void            simb::MCParticle::AddTrajectoryPoint(const TLorentz
                                                                                   { ftrajectory.Add( position, momentum ); }
 inline       void            simb::MCParticle::SparsifyTrajectory()               { ftrajectory.Sparsify();                }
 inline       void            simb::MCParticle::AddDaughter(const int trackID)     { fdaughters.insert(trackID); 	   }
-inline       void            simb::MCParticle::SetPolarization(TVector3 const& p) { fpolarization = p;          	   }
+inline       void            simb::MCParticle::SetPolarization(TVector3 const& p) { p.GetXYZ(fpolarization);   	   }
 inline       void            simb::MCParticle::SetRescatter(int code)             { frescatter    = code;       	   }
 inline       void            simb::MCParticle::SetWeight(double wt)               { fWeight       = wt;         	   }
 
@@ -10,7 +10,9 @@
 #include "SimulationBase/MCTrajectory.h"
 
 #include <TLorentzVector.h>
+#include <TVector3.h>
 
+#include <algorithm>
 #include <cmath>
 #include <deque>
 #include <iterator>
@@ -20,30 +22,62 @@ namespace simb {
 
   // Nothing special need be done for the default constructor or destructor.
   MCTrajectory::MCTrajectory() 
-    : ftrajectory()
+    : fPoints()
+    , fView()
   {}
 
   //----------------------------------------------------------------------------
   MCTrajectory::MCTrajectory( const TLorentzVector& position, 
 			      const TLorentzVector& momentum )
   {
-    ftrajectory.push_back( value_type( position, momentum ) );
+    push_back( position, momentum );
   }
 
   //----------------------------------------------------------------------------
-  const TLorentzVector& MCTrajectory::Position( const size_type index ) const
+  const MCTrajectory::list_type& MCTrajectory::View() const
   {
-    const_iterator i = ftrajectory.begin();
-    std::advance(i,index);
-    return (*i).first;
+    // the view is either empty or has every point, see push_back
+    const size_type n = size();
+    if ( fView.size() == n ) return fView;
+
+    fView.clear();
+    fView.reserve(n);
+    const double* p = &fPoints[0];
+    for ( size_type i = 0; i < n; ++i, p += kNPacked )
+      fView.push_back( value_type( TLorentzVector(p[0], p[1], p[2], p[3]),
+				   TLorentzVector(p[4], p[5], p[6], p[7]) ) );
+    return fView;
   }
 
   //----------------------------------------------------------------------------
-  const TLorentzVector& MCTrajectory::Momentum( const size_type index ) const
+  void MCTrajectory::push_back( const TLorentzVector& p, const TLorentzVector& m )
   {
-    const_iterator i = ftrajectory.begin();
-    std::advance(i,index);
-    return (*i).second;
+    // keep a view that is already built in step, it is cheaper than
+    // building it again
+    if ( !fView.empty() ) fView.push_back( value_type(p, m) );
+
+    fPoints.push_back(p.X());
+    fPoints.push_back(p.Y());
+    fPoints.push_back(p.Z());
+    fPoints.push_back(p.T());
+    fPoints.push_back(m.Px());
+    fPoints.push_back(m.Py());
+    fPoints.push_back(m.Pz());
+    fPoints.push_back(m.E());
+  }
+
+  //----------------------------------------------------------------------------
+  TLorentzVector MCTrajectory::Position( const size_type index ) const
+  {
+    const double* p = &fPoints[kNPacked*index];
+    return TLorentzVector(p[0], p[1], p[2], p[3]);
+  }
+
+  //----------------------------------------------------------------------------
+  TLorentzVector MCTrajectory::Momentum( const size_type index ) const
+  {
+    const double* p = &fPoints[kNPacked*index + 4];
+    return TLorentzVector(p[0], p[1], p[2], p[3]);
   }
 
   //----------------------------------------------------------------------------
@@ -54,8 +88,12 @@ namespace simb {
 
     // We take the sum of the straight lines between the trajectory points
     double dist = 0;
-    for(int n = 0; n < N-1; ++n){
-      dist += (Position(n+1)-Position(n)).Vect().Mag();
+    const double* p = &fPoints[0];
+    for(int n = 0; n < N-1; ++n, p += kNPacked){
+      const double dx = p[kNPacked  ] - p[0];
+      const double dy = p[kNPacked+1] - p[1];
+      const double dz = p[kNPacked+2] - p[2];
+      dist += std::sqrt(dx*dx + dy*dy + dz*dz);
     }
 
     return dist;
@@ -127,15 +165,15 @@ namespace simb {
       if(hiIdx < loIdx+2)
 	throw cet::exception("MCTrajectory") << "Degnerate range in Sparsify method";
 
-      const TVector3 loVec = at(loIdx).first.Vect();
-      const TVector3 hiVec = at(hiIdx).first.Vect();
+      const TVector3 loVec(X(loIdx), Y(loIdx), Z(loIdx));
+      const TVector3 hiVec(X(hiIdx), Y(hiIdx), Z(hiIdx));
 
       const TVector3 dir = (hiVec-loVec).Unit();
 
       // Are all the points in between close enough?
       bool ok = true;
       for(int i = loIdx+1; i < hiIdx; ++i){
-	const TVector3 toHere = at(i).first.Vect()-loVec;
+	const TVector3 toHere = TVector3(X(i), Y(i), Z(i))-loVec;
 	// Perpendicular distance^2 from the line joining loVec to hiVec
 	const double impact = (toHere-dir.Dot(toHere)*dir).Mag2();
 	if(impact > margin){ok = false; break;}
@@ -180,14 +218,18 @@ namespace simb {
     // Look up the trajectory points at the stored indices, write them to a new
     // trajectory
     const unsigned int I = done.size();
-    list_type newTraj;
-    newTraj.reserve(I+1);
-    for(unsigned int i = 0; i < I; ++i) newTraj.push_back(at(done[i]));
+    std::vector<double> newTraj;
+    newTraj.reserve(kNPacked*(I+1));
+    for(unsigned int i = 0; i < I; ++i)
+      newTraj.insert(newTraj.end(),
+		     fPoints.begin() + kNPacked*done[i],
+		     fPoints.begin() + kNPacked*(done[i]+1));
     // Remember to add the very last point in
-    newTraj.push_back(*rbegin());
+    newTraj.insert(newTraj.end(), fPoints.end() - kNPacked, fPoints.end());
 
     // Replace trajectory with new version
-    ftrajectory = newTraj;
+    fPoints.swap(newTraj);
+    fView.clear();
   }
 
 } // namespace sim
@@ -45,6 +45,21 @@
 /// Geant4, the units will be (mm,ns,GeV), but this class does not
 /// enforce this.
 
+/// - The points are stored (and written to ROOT files) as a packed
+///   array of doubles, (x,y,z,t,Px,Py,Pz,E) per point, so reading a
+///   trajectory does not have to stream a pair of TLorentzVectors,
+///   with their TObject headers, for every point.  Position(i) and
+///   Momentum(i) return a TLorentzVector by value, made from the packed
+///   array; the components, size() and TotalLength() read it directly.
+///   The iterators, operator[] and at() go through a
+///   vector< pair<TLorentzVector,TLorentzVector> > view that is only
+///   built on the first such call and dropped whenever the points
+///   change, so code that never iterates never pays for it.  Only const
+///   iterators are provided: a point written through an iterator would
+///   change the view, not the stored trajectory.  Files written with
+///   ClassVersion 11 and earlier are converted by a read rule in
+///   classes_def.xml.
+
 #ifndef SIMB_MCTRAJECTORY_H
 #define SIMB_MCTRAJECTORY_H
 
@@ -62,9 +77,9 @@ namespace simb {
     /// you can ignore these definitions.)
     typedef std::vector< std::pair<TLorentzVector, TLorentzVector> >  list_type;
     typedef list_type::value_type                   value_type;
-    typedef list_type::iterator                     iterator;
+    typedef list_type::const_iterator               iterator;
     typedef list_type::const_iterator               const_iterator;
-    typedef list_type::reverse_iterator             reverse_iterator;
+    typedef list_type::const_reverse_iterator       reverse_iterator;
     typedef list_type::const_reverse_iterator       const_reverse_iterator;
     typedef list_type::size_type                    size_type;
     typedef list_type::difference_type              difference_type;
@@ -74,7 +89,8 @@ namespace simb {
     MCTrajectory();
 
   private:
-    list_type ftrajectory;
+    std::vector<double> fPoints;       ///< packed (x,y,z,t,Px,Py,Pz,E) per point
+    mutable list_type   fView;         ///< TLorentzVector view of fPoints, built on demand, not written
 
 #ifndef __GCCXML__
   public:
@@ -83,8 +99,8 @@ namespace simb {
 		  const TLorentzVector& momentum );
 
     /// The accessor methods described above.
-    const TLorentzVector& Position( const size_type ) const;
-    const TLorentzVector& Momentum( const size_type ) const;
+    TLorentzVector Position( const size_type ) const;
+    TLorentzVector Momentum( const size_type ) const;
     double  X( const size_type i ) const;
     double  Y( const size_type i ) const;
     double  Z( const size_type i ) const;
@@ -100,14 +116,11 @@ namespace simb {
 
     /// Standard STL methods, to make this class look like an STL map.
     /// Again, if you don't know STL, you can just ignore these
-    /// methods.
-    iterator               begin();
+    /// methods.  Only const iterators are provided, for the same
+    /// reason there is no non-const operator[].
     const_iterator         begin()      const;
-    iterator               end();
     const_iterator         end()        const;
-    reverse_iterator       rbegin();
     const_reverse_iterator rbegin()     const;
-    reverse_iterator       rend();
     const_reverse_iterator rend()       const;
 
     size_type size()                    const;
@@ -131,6 +144,15 @@ namespace simb {
     /// points.
     void Sparsify(double margin = .1);
 
+    /// Direct access to the packed points, kNPacked doubles per point
+    static const size_type kNPacked = 8;
+    const std::vector<double>& Packed() const;
+
+  private:
+
+    /// the view of all points, built if it is not there yet
+    const list_type& View() const;
+
 #endif
   };
 
@@ -138,46 +160,40 @@ namespace simb {
 
 #ifndef __GCCXML__
 
-inline double                 simb::MCTrajectory::X ( const size_type i ) const { return Position(i).X();      }
-inline double 		      simb::MCTrajectory::Y ( const size_type i ) const { return Position(i).Y();      }
-inline double 		      simb::MCTrajectory::Z ( const size_type i ) const { return Position(i).Z();      }
-inline double 		      simb::MCTrajectory::T ( const size_type i ) const { return Position(i).T();      }
-inline double 		      simb::MCTrajectory::Px( const size_type i ) const { return Momentum(i).Px();     }
-inline double 		      simb::MCTrajectory::Py( const size_type i ) const { return Momentum(i).Py();     }
-inline double 		      simb::MCTrajectory::Pz( const size_type i ) const { return Momentum(i).Pz();     }
-inline double 		      simb::MCTrajectory::E ( const size_type i ) const { return Momentum(i).E();      }
-
-inline simb::MCTrajectory::iterator               simb::MCTrajectory::begin()                   { return ftrajectory.begin();  }
-inline simb::MCTrajectory::const_iterator         simb::MCTrajectory::begin()  		  const { return ftrajectory.begin();  }
-inline simb::MCTrajectory::iterator               simb::MCTrajectory::end()    		        { return ftrajectory.end();    }
-inline simb::MCTrajectory::const_iterator         simb::MCTrajectory::end()    		  const { return ftrajectory.end();    }
-inline simb::MCTrajectory::reverse_iterator       simb::MCTrajectory::rbegin() 		        { return ftrajectory.rbegin(); }
-inline simb::MCTrajectory::const_reverse_iterator simb::MCTrajectory::rbegin() 		  const { return ftrajectory.rbegin(); }
-inline simb::MCTrajectory::reverse_iterator       simb::MCTrajectory::rend()   		        { return ftrajectory.rend();   }
-inline simb::MCTrajectory::const_reverse_iterator simb::MCTrajectory::rend()   		  const { return ftrajectory.rend();   }
-inline simb::MCTrajectory::size_type              simb::MCTrajectory::size()   		  const { return ftrajectory.size();   }
-inline bool                                       simb::MCTrajectory::empty()  		  const { return ftrajectory.empty();  }
-inline void                                       simb::MCTrajectory::clear()                   { ftrajectory.clear();         }
+inline double                 simb::MCTrajectory::X ( const size_type i ) const { return fPoints[kNPacked*i    ]; }
+inline double 		      simb::MCTrajectory::Y ( const size_type i ) const { return fPoints[kNPacked*i + 1]; }
+inline double 		      simb::MCTrajectory::Z ( const size_type i ) const { return fPoints[kNPacked*i + 2]; }
+inline double 		      simb::MCTrajectory::T ( const size_type i ) const { return fPoints[kNPacked*i + 3]; }
+inline double 		      simb::MCTrajectory::Px( const size_type i ) const { return fPoints[kNPacked*i + 4]; }
+inline double 		      simb::MCTrajectory::Py( const size_type i ) const { return fPoints[kNPacked*i + 5]; }
+inline double 		      simb::MCTrajectory::Pz( const size_type i ) const { return fPoints[kNPacked*i + 6]; }
+inline double 		      simb::MCTrajectory::E ( const size_type i ) const { return fPoints[kNPacked*i + 7]; }
+
+inline simb::MCTrajectory::const_iterator         simb::MCTrajectory::begin()  		  const { return View().begin();  }
+inline simb::MCTrajectory::const_iterator         simb::MCTrajectory::end()    		  const { return View().end();    }
+inline simb::MCTrajectory::const_reverse_iterator simb::MCTrajectory::rbegin() 		  const { return View().rbegin(); }
+inline simb::MCTrajectory::const_reverse_iterator simb::MCTrajectory::rend()   		  const { return View().rend();   }
+inline simb::MCTrajectory::size_type              simb::MCTrajectory::size()   		  const { return fPoints.size()/kNPacked; }
+inline bool                                       simb::MCTrajectory::empty()  		  const { return fPoints.empty();      }
+inline void                                       simb::MCTrajectory::clear()                   { fPoints.clear(); fView.clear(); }
 inline void                                       simb::MCTrajectory::swap(simb::MCTrajectory& other) 
-{ ftrajectory.swap( other.ftrajectory ); }
+{ fPoints.swap( other.fPoints ); fView.swap( other.fView ); }
 
 inline const simb::MCTrajectory::value_type&      simb::MCTrajectory::operator[](const simb::MCTrajectory::size_type i) const 
-{ return ftrajectory[i];}
+{ return View()[i];}
 
 inline const simb::MCTrajectory::value_type&      simb::MCTrajectory::at(const simb::MCTrajectory::size_type i)         const 
-{ return ftrajectory.at(i); }
+{ return View().at(i); }
 
 inline void                                       simb::MCTrajectory::push_back(const simb::MCTrajectory::value_type& v )     
-{ ftrajectory.push_back(v); }
-
-inline void                                       simb::MCTrajectory::push_back(const TLorentzVector& p, 
-										const TLorentzVector& m ) 
-{ ftrajectory.push_back( simb::MCTrajectory::value_type(p,m) ); }
+{ push_back(v.first, v.second); }
 
 inline void                                       simb::MCTrajectory::Add(const TLorentzVector& p, 
 									  const TLorentzVector& m )       
 { push_back(p,m);           }
 
+inline const std::vector<double>&                 simb::MCTrajectory::Packed()                  const { return fPoints; }
+
 #endif
 
 #endif // SIMB_MCTRAJECTORY_H
@@ -25,7 +25,9 @@
 #include "SimulationBase/MCParticle.h"
 #include "SimulationBase/MCNeutrino.h"
 #include "SimulationBase/MCFlux.h"
+#include "SimulationBase/MCFluxFiles.h"
 #include "SimulationBase/GTruth.h"
+#include "SimulationBase/GHEPRecord.h"
 #include <TLorentzVector.h>
 //
 // Only include objects that we would like to be able to put into the event.
@@ -38,11 +40,14 @@ template class std::vector<simb::MCParticle>;
 template class std::vector<simb::MCTruth>;
 template class std::vector<simb::MCFlux>;
 template class std::vector<simb::GTruth>;
+template class std::vector<simb::GHEPRecord>;
 
 template class std::pair< art::Ptr<simb::MCFlux>,     art::Ptr<simb::MCTruth>    >;
 template class std::pair< art::Ptr<simb::MCTruth>,    art::Ptr<simb::MCFlux>     >;
 template class std::pair< art::Ptr<simb::GTruth>,     art::Ptr<simb::MCTruth>    >;
 template class std::pair< art::Ptr<simb::MCTruth>,    art::Ptr<simb::GTruth>     >;
+template class std::pair< art::Ptr<simb::GHEPRecord>, art::Ptr<simb::MCTruth>    >;
+template class std::pair< art::Ptr<simb::MCTruth>,    art::Ptr<simb::GHEPRecord> >;
 template class std::pair< art::Ptr<simb::MCParticle>, art::Ptr<simb::MCTruth>    >;
 template class std::pair< art::Ptr<simb::MCTruth>,    art::Ptr<simb::MCParticle> >;
 
@@ -51,6 +56,8 @@ template class art::Assns<simb::MCFlux,     simb::MCTruth,    void>;
 template class art::Assns<simb::MCTruth,    simb::MCFlux,     void>;
 template class art::Assns<simb::GTruth,     simb::MCTruth,    void>;
 template class art::Assns<simb::MCTruth,    simb::GTruth,     void>;
+template class art::Assns<simb::GHEPRecord, simb::MCTruth,    void>;
+template class art::Assns<simb::MCTruth,    simb::GHEPRecord, void>;
 template class art::Assns<simb::MCParticle, simb::MCTruth,    void>;
 template class art::Assns<simb::MCTruth,    simb::MCParticle, void>;
 
@@ -59,7 +66,9 @@ template class art::Wrapper< std::vector<simb::MCTrajectory> >;
 template class art::Wrapper< std::vector<simb::MCParticle> >;
 template class art::Wrapper< std::vector<simb::MCTruth> >;
 template class art::Wrapper< std::vector<simb::MCFlux> >;
+template class art::Wrapper< simb::MCFluxFiles >;
 template class art::Wrapper< std::vector<simb::GTruth> >;
+template class art::Wrapper< std::vector<simb::GHEPRecord> >;
 
 template class art::Wrapper< art::Assns<simb::MCParticle, simb::MCTruth,    void> >;
 template class art::Wrapper< art::Assns<simb::MCTruth,    simb::MCParticle, void> >;
@@ -67,4 +76,6 @@ template class art::Wrapper< art::Assns<simb::MCFlux,     simb::MCTruth,    void
 template class art::Wrapper< art::Assns<simb::MCTruth,    simb::MCFlux,     void> >;
 template class art::Wrapper< art::Assns<simb::GTruth,     simb::MCTruth,    void> >;
 template class art::Wrapper< art::Assns<simb::MCTruth,    simb::GTruth,     void> >;
+template class art::Wrapper< art::Assns<simb::GHEPRecord, simb::MCTruth,    void> >;
+template class art::Wrapper< art::Assns<simb::MCTruth,    simb::GHEPRecord, void> >;
 
@@ -51,6 +51,7 @@
 #include "tree/dkmeta.h"
 #include "tree/NuChoice.h"
 #include "tree/calcLocationWeights.h"
+#include "tree/dk2nuIndex.h"
 
 #include <vector>
 #include <algorithm>
@@ -212,21 +213,27 @@ bool GDk2NuFlux::GenerateNext_weighted(void)
   } else {
     // Reset previously generated neutrino code / 4-p / 4-x
     this->ResetCurrent();
-    // Move on, read next flux ntuple entry
-    fIEntry++;
-    if ( fIEntry >= fNEntries ) {
-      // Ran out of entries @ the current cycle of this flux file
-      // Check whether more (or infinite) number of cycles is requested
-      if (fICycle < fNCycles || fNCycles == 0 ) {
-        fICycle++;
-        fIEntry=0;
-      } else {
-        LOG("Flux", pWARN)
-          << "No more entries in input flux neutrino ntuple, cycle "
-          << fICycle << " of " << fNCycles;
-        fEnd = true;
-        //assert(0);
-        return false;	
+    if ( fRandomEntries ) {
+      if ( ! this->DrawEntry() ) return false;
+    } else {
+      // Move on, read next flux ntuple entry
+      fIEntry++;
+      if ( fUseIndex ) fIEntry = this->SkipUnselected(fIEntry);
+      if ( fIEntry >= fNEntries ) {
+        // Ran out of entries @ the current cycle of this flux file
+        // Check whether more (or infinite) number of cycles is requested
+        if (fICycle < fNCycles || fNCycles == 0 ) {
+          fICycle++;
+          fIEntry=0;
+          if ( fUseIndex ) fIEntry = this->SkipUnselected(fIEntry);
+        } else {
+          LOG("Flux", pWARN)
+            << "No more entries in input flux neutrino ntuple, cycle "
+            << fICycle << " of " << fNCycles;
+          fEnd = true;
+          //assert(0);
+          return false;	
+        }
       }
     }
     
@@ -372,6 +379,58 @@ bool GDk2NuFlux::GenerateNext_weighted(void)
   return true;
 }
 //___________________________________________________________________________
+Long64_t GDk2NuFlux::SkipUnselected(Long64_t ientry)
+{
+// Return the first entry selected by the index at or after ientry
+// (fNEntries if there is none).  The entries passed over are counted
+// as thrown, exactly as if they had been read and rejected, so the POT
+// accounting is the same as reading every entry.
+
+  std::vector<Long64_t>::const_iterator next =
+    std::lower_bound(fSelEntries.begin(),fSelEntries.end(),ientry);
+  Long64_t jentry = ( next == fSelEntries.end() ) ? fNEntries : *next;
+  Long64_t nskip  = ( jentry - ientry ) * fNUse;  // each entry is thrown fNUse times
+  fAccumPOTs  += nskip * fEffPOTsPerNu / fMaxWeight;
+  fNNeutrinos += nskip;
+  return jentry;
+}
+//___________________________________________________________________________
+bool GDk2NuFlux::DrawEntry(void)
+{
+// Pick the next entry with RandomGen::RndFlux(), among the entries
+// selected by the index files if there is a selection.  The entries an
+// event reads then depend only on the state of RandomGen when it
+// starts, so a generator that reseeds RandomGen per event (e.g. from an
+// evgb::RNGStream) reproduces each event whatever the order.  A draw
+// from a selection of n entries stands for fNEntries/n entries of a
+// full read; the others are counted as thrown, so the POT accounting
+// agrees with a full read on average rather than exactly.  With
+// fNCycles > 0 at most fNCycles times the available entries are drawn.
+
+  const Long64_t navail = ( fUseIndex ) ? (Long64_t)fSelEntries.size() : fNEntries;
+  if ( navail == 0 || ( fNCycles > 0 && fNDrawn >= fNCycles*navail ) ) {
+    LOG("Flux", pWARN)
+      << "No more entries to draw from input flux neutrino ntuple, "
+      << fNDrawn << " drawn of " << navail;
+    fEnd = true;
+    return false;
+  }
+
+  RandomGen* rnd = RandomGen::Instance();
+  Long64_t k = (Long64_t)( rnd->RndFlux().Rndm() * navail );
+  if ( k >= navail ) k = navail - 1;
+
+  fIEntry = ( fUseIndex ) ? fSelEntries[k] : k;
+  fICycle = fNDrawn / navail;
+  fNDrawn++;
+
+  if ( navail < fNEntries ) {
+    double nskip = ( (double)fNEntries / navail - 1. ) * fNUse;
+    fAccumPOTs  += nskip * fEffPOTsPerNu / fMaxWeight;
+  }
+  return true;
+}
+//___________________________________________________________________________
 double GDk2NuFlux::GetDecayDist() const
 {
   // return distance (user units) between dk point and start position
@@ -636,6 +695,18 @@ void GDk2NuFlux::LoadBeamSimData(std::vector<string> patterns, string config )
     }
   }
 
+  if ( fUseIndex ) {
+    if ( fSelEntries.empty() ) {
+      LOG("Flux", pFATAL)
+        << "LoadBeamSimData: the index selection left no entries";
+      exit(1);
+    }
+    LOG("Flux", pNOTICE)
+      << "Index selection (location " << fIdxLocation << ", E ["
+      << fIdxEmin << "," << fIdxEmax << ")) reads "
+      << fSelEntries.size() << " of " << fNEntries << " entries";
+  }
+
   // we have a file we can work with
   if (!fDetLocIsSet) {
      LOG("Flux", pERROR)
@@ -654,6 +725,7 @@ void GDk2NuFlux::LoadBeamSimData(std::vector<string> patterns, string config )
   RandomGen* rnd = RandomGen::Instance();
   fIUse   =  9999999;
   fIEntry = rnd->RndFlux().Integer(fNEntries) - 1;
+  fNDrawn = 0;
   
   // don't count things we used to estimate max weight
   fSumWeight  = 0;
@@ -757,6 +829,28 @@ void GDk2NuFlux::SetEntryReuse(long int nuse)
   fNUse    = TMath::Max(1L, nuse);
 }
 
+//___________________________________________________________________________
+void GDk2NuFlux::SetIndexSelection(std::vector<int> pdgs, int iloc,
+                                   double emin, double emax)
+{
+// Read only the entries that the index file of each flux file (see
+// bsim::buildDk2NuIndex) puts in the buckets of location iloc for the
+// flavors pdgs (empty = all) and energy bins overlapping [emin,emax).
+// Files without a (matching) index are read in full.  Must be called
+// before LoadBeamSimData().
+
+  if ( fNuFluxTree ) {
+    LOG("Flux", pERROR)
+      << "SetIndexSelection must be called before LoadBeamSimData";
+    return;
+  }
+  fUseIndex    = true;
+  fIdxPdgs     = pdgs;
+  fIdxLocation = iloc;
+  fIdxEmin     = emin;
+  fIdxEmax     = emax;
+}
+
 //___________________________________________________________________________
 void GDk2NuFlux::SetFluxWindow(TVector3 p0, TVector3 p1, TVector3 p2)
                              // bool inDetCoord)  future extension
@@ -991,6 +1085,14 @@ void GDk2NuFlux::Initialize(void)
   fNuTot           = 0;
   fFilePOTs        = 0;
 
+  fRandomEntries   = false;
+  fNDrawn          = 0;
+
+  fUseIndex        = false;
+  fIdxLocation     = 0;
+  fIdxEmin         = 0;
+  fIdxEmax         = 1.0e30;
+
   fMaxWeight       = -1;
   fMaxWgtFudge     =  1.05;
   fMaxWgtEntries   = 2500000;
@@ -1114,6 +1216,28 @@ void GDk2NuFlux::AddFile(TTree* ftree, TTree* mtree, string fname)
     SLOG("GDk2NuFlux", pFATAL) << "Add: \"" << fname << "\" failed";
   }
 
+  if ( fUseIndex ) {
+    // entries of this file selected by its index, as chain entries
+    std::string idxname = bsim::dk2nuIndexFileName(fname);
+    std::vector<Long64_t> sel;
+    Long64_t nidx = -1;
+    if ( ! gSystem->AccessPathName(idxname.c_str()) )
+      nidx = bsim::readDk2NuIndex(idxname,fIdxPdgs,fIdxLocation,
+                                  fIdxEmin,fIdxEmax,sel);
+    if ( nidx != (Long64_t)nentries ) {
+      LOG("Flux", pWARN)
+        << "No usable index \"" << idxname << "\" (" << nidx
+        << " entries), reading all of " << fname;
+      sel.clear();
+      for ( Long64_t i = 0; i < (Long64_t)nentries; ++i ) sel.push_back(i);
+    }
+    for ( size_t i = 0; i < sel.size(); ++i )
+      fSelEntries.push_back(fNuTot + sel[i]);
+    LOG("Flux", pINFO)
+      << "index selects " << sel.size() << " of " << nentries
+      << " entries in file: " << fname;
+  }
+
   fNuTot    += nentries;
   fFilePOTs += potsum;
   fNFiles++;
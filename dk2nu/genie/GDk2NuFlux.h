@@ -119,6 +119,11 @@ public :
 
   void      SetNumOfCycles(long int ncycle);                      ///< set how many times to cycle through the ntuple (default: 1 / n=0 means 'infinite')
   void      SetEntryReuse(long int nuse=1);                       ///<  # of times to use entry before moving to next
+  void      SetRandomEntries(bool random=true) { fRandomEntries = random; } ///< draw each entry with RandomGen::RndFlux() instead of reading in order
+
+  void      SetIndexSelection(std::vector<int> pdgs, int iloc,
+                              double emin = 0, double emax = 1.0e30);   ///< read only entries selected by the index files (bsim::buildDk2NuIndex), call before LoadBeamSimData
+  Long64_t  NSelectedEntries() const { return fSelEntries.size(); }        ///< # of chain entries selected by the index files
 
   void      ScanForMaxWeight(void);                               ///< scan for max flux weight (before generating unweighted flux neutrinos)
   void      SetMaxWgtScan(double fudge = 1.05, long int nentries = 2500000)      ///< configuration when estimating max weight
@@ -194,6 +199,8 @@ private:
   void AddFile               (TTree* fluxtree, TTree* metatree, string fname);
   void CalcEffPOTsPerNu      (void);
   void LoadDkMeta            (void);
+  Long64_t SkipUnselected    (Long64_t ientry);
+  bool     DrawEntry         (void);
 
   // Private data members
   //
@@ -221,6 +228,16 @@ private:
 
   std:: map<int,int>  fJobToMetaIndex;  ///< quick lookup from job# to meta chain
 
+  bool                  fUseIndex;      ///< read only the entries selected by the index files
+  std::vector<int>      fIdxPdgs;       ///< index selection: flavors (empty=all)
+  int                   fIdxLocation;   ///< index selection: DkMeta::location index
+  double                fIdxEmin;       ///< index selection: energy range at the location
+  double                fIdxEmax;
+  std::vector<Long64_t> fSelEntries;    ///< sorted chain entries selected by the index files
+
+  bool      fRandomEntries;       ///< draw entries at random rather than in order
+  Long64_t  fNDrawn;              ///< # of entries drawn so far with fRandomEntries
+
   double    fWeight;              ///< current neutrino weight, =1 if generating unweighted entries
   double    fMaxWeight;           ///< max flux neutrino weight in input file
   double    fMaxWgtFudge;         ///< fudge factor for estimating max wgt
@@ -28,6 +28,13 @@
 #pragma link C++ function bsim::printWeightLocations;
 #pragma link C++ function bsim::calcLocationWeights;
 #pragma link C++ function bsim::calcEnuWgt;
+#pragma link C++ function bsim::tuneDk2NuTree;
+#pragma link C++ function bsim::setBranchCompression;
+#pragma link C++ function bsim::compressionSettings;
+#pragma link C++ function bsim::reportTreeCompression;
+#pragma link C++ function bsim::dk2nuIndexFileName;
+#pragma link C++ function bsim::buildDk2NuIndex;
+#pragma link C++ function bsim::readDk2NuIndex;
 
 #pragma link C++ function bsim::IsDefault;
 
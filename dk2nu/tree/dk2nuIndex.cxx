@@ -0,0 +1,221 @@
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <cfloat>
+
+#include "tree/dk2nuIndex.h"
+#include "tree/dk2nu.h"
+#include "tree/dkmeta.h"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TStopwatch.h"
+
+namespace {
+
+  /// (pdg, location, energy bin) of a bucket, ordered in that sequence
+  struct BucketKey {
+    int pdg;
+    int iloc;
+    int ebin;
+    bool operator<(const BucketKey& other) const {
+      if ( pdg  != other.pdg  ) return pdg  < other.pdg;
+      if ( iloc != other.iloc ) return iloc < other.iloc;
+      return ebin < other.ebin;
+    }
+  };
+
+  struct Bucket {
+    std::vector<Int_t> entries;   ///< filled in entry order, so sorted
+    double             sumwgt;
+    Bucket() : sumwgt(0) { }
+  };
+
+}
+
+namespace bsim {
+
+  std::string dk2nuIndexFileName(std::string fluxfile)
+  {
+    const std::string ext = ".root";
+    if ( fluxfile.size() > ext.size() &&
+         fluxfile.compare(fluxfile.size()-ext.size(),ext.size(),ext) == 0 )
+      fluxfile.erase(fluxfile.size()-ext.size());
+    return fluxfile + ".idx.root";
+  }
+
+  //__________________________________________________________________________
+  int buildDk2NuIndex(std::string fluxfile, std::string indexfile,
+                      int nbins, double emin, double emax,
+                      std::string treename, std::string metaname)
+  {
+    if ( indexfile == "" ) indexfile = dk2nuIndexFileName(fluxfile);
+    if ( nbins < 1 || emax <= emin ) {
+      std::cerr << "buildDk2NuIndex: bad energy binning " << nbins
+                << " [" << emin << "," << emax << ")" << std::endl;
+      return -1;
+    }
+
+    TFile fin(fluxfile.c_str(),"READ");
+    TTree* tree = (TTree*)fin.Get(treename.c_str());
+    TTree* meta = (TTree*)fin.Get(metaname.c_str());
+    if ( fin.IsZombie() || ! tree || ! meta ) {
+      std::cerr << "buildDk2NuIndex: \"" << fluxfile << "\" lacks \""
+                << treename << "\" or \"" << metaname << "\"" << std::endl;
+      return -1;
+    }
+
+    // POTs and number of locations from the metadata
+    Double_t pots = 0;
+    Int_t    nloc = 0;
+    bsim::DkMeta* dkmeta = new bsim::DkMeta;
+    meta->SetBranchAddress("dkmeta",&dkmeta);
+    for ( Long64_t imeta = 0; imeta < meta->GetEntries(); ++imeta ) {
+      meta->GetEntry(imeta);
+      pots += dkmeta->pots;
+      nloc  = dkmeta->location.size();
+    }
+    delete dkmeta;
+
+    // only the flavor, importance weight and rays are needed
+    bsim::Dk2Nu* dk2nu = new bsim::Dk2Nu;
+    tree->SetBranchAddress("dk2nu",&dk2nu);
+    tree->SetBranchStatus("*",0);
+    tree->SetBranchStatus("*decay*",1);
+    tree->SetBranchStatus("*nuray*",1);
+
+    TStopwatch sw;
+    sw.Start();
+    const double width = ( emax - emin ) / nbins;
+    std::map<BucketKey,Bucket> buckets;
+    Long64_t nentries = tree->GetEntries();
+    for ( Long64_t ientry = 0; ientry < nentries; ++ientry ) {
+      tree->GetEntry(ientry);
+      BucketKey key;
+      key.pdg = dk2nu->decay.ntype;
+      size_t nray = dk2nu->nuray.size();
+      if ( nloc > 0 && nray > (size_t)nloc ) nray = nloc;
+      for ( size_t iloc = 0; iloc < nray; ++iloc ) {
+        const bsim::NuRay& ray = dk2nu->nuray[iloc];
+        key.iloc = iloc;
+        if      ( ray.E <  emin ) key.ebin = -1;
+        else if ( ray.E >= emax ) key.ebin = nbins;
+        else key.ebin = std::min(int((ray.E-emin)/width),nbins-1);
+        Bucket& bucket = buckets[key];
+        bucket.entries.push_back((Int_t)ientry);
+        bucket.sumwgt += dk2nu->decay.nimpwt * ray.wgt;
+      }
+    }
+    delete dk2nu;
+    fin.Close();
+
+    TFile fout(indexfile.c_str(),"RECREATE");
+    if ( fout.IsZombie() ) {
+      std::cerr << "buildDk2NuIndex: could not create \"" << indexfile
+                << "\"" << std::endl;
+      return -1;
+    }
+
+    Int_t nedges = nbins + 1;
+    std::vector<Double_t> edges(nedges);
+    for ( int i = 0; i < nedges; ++i ) edges[i] = emin + i*width;
+    TTree* head = new TTree("dk2nuIndexHead","dk2nu index header");
+    head->Branch("nentries",&nentries,"nentries/L");
+    head->Branch("pots",&pots,"pots/D");
+    head->Branch("nloc",&nloc,"nloc/I");
+    head->Branch("nedges",&nedges,"nedges/I");
+    head->Branch("edges",&edges[0],"edges[nedges]/D");
+    head->Fill();
+
+    size_t maxn = 1;
+    std::map<BucketKey,Bucket>::const_iterator bitr = buckets.begin();
+    for ( ; bitr != buckets.end(); ++bitr )
+      maxn = std::max(maxn,bitr->second.entries.size());
+    std::vector<Int_t> entry(maxn);
+    Int_t pdg, iloc, ebin, n;
+    Double_t sumwgt;
+    TTree* index = new TTree("dk2nuIndex","dk2nu entries by pdg, location, energy bin");
+    index->Branch("pdg",&pdg,"pdg/I");
+    index->Branch("iloc",&iloc,"iloc/I");
+    index->Branch("ebin",&ebin,"ebin/I");
+    index->Branch("sumwgt",&sumwgt,"sumwgt/D");
+    index->Branch("n",&n,"n/I");
+    index->Branch("entry",&entry[0],"entry[n]/I");
+    for ( bitr = buckets.begin(); bitr != buckets.end(); ++bitr ) {
+      pdg    = bitr->first.pdg;
+      iloc   = bitr->first.iloc;
+      ebin   = bitr->first.ebin;
+      sumwgt = bitr->second.sumwgt;
+      n      = bitr->second.entries.size();
+      std::copy(bitr->second.entries.begin(),bitr->second.entries.end(),
+                entry.begin());
+      index->Fill();
+    }
+    fout.Write();
+    fout.Close();
+    sw.Stop();
+
+    std::cout << "buildDk2NuIndex: " << nentries << " entries of \""
+              << fluxfile << "\" in " << buckets.size() << " buckets -> \""
+              << indexfile << "\" (" << sw.RealTime() << " s)" << std::endl;
+    return buckets.size();
+  }
+
+  //__________________________________________________________________________
+  Long64_t readDk2NuIndex(std::string indexfile, const std::vector<int>& pdgs,
+                          int iloc, double emin, double emax,
+                          std::vector<Long64_t>& entries, double* sumwgt)
+  {
+    TFile fidx(indexfile.c_str(),"READ");
+    TTree* head  = (TTree*)fidx.Get("dk2nuIndexHead");
+    TTree* index = (TTree*)fidx.Get("dk2nuIndex");
+    if ( fidx.IsZombie() || ! head || ! index || head->GetEntries() < 1 ) {
+      std::cerr << "readDk2NuIndex: \"" << indexfile
+                << "\" is not a dk2nu index" << std::endl;
+      return -1;
+    }
+
+    Long64_t nentries = 0;
+    Int_t    nedges   = 0;
+    head->SetBranchAddress("nentries",&nentries);
+    head->SetBranchAddress("nedges",&nedges);
+    head->GetBranch("nedges")->GetEntry(0);
+    std::vector<Double_t> edges(nedges+1);
+    head->SetBranchAddress("edges",&edges[0]);
+    head->GetEntry(0);
+
+    Int_t pdg, loc, ebin, n;
+    Double_t wgt;
+    std::vector<Int_t> entry((size_t)index->GetMaximum("n")+1);
+    index->SetBranchAddress("pdg",&pdg);
+    index->SetBranchAddress("iloc",&loc);
+    index->SetBranchAddress("ebin",&ebin);
+    index->SetBranchAddress("sumwgt",&wgt);
+    index->SetBranchAddress("n",&n);
+    index->SetBranchAddress("entry",&entry[0]);
+
+    size_t nbefore = entries.size();
+    for ( Long64_t ibucket = 0; ibucket < index->GetEntries(); ++ibucket ) {
+      // look at the key before reading the entry list
+      index->GetBranch("pdg")->GetEntry(ibucket);
+      index->GetBranch("iloc")->GetEntry(ibucket);
+      index->GetBranch("ebin")->GetEntry(ibucket);
+      if ( loc != iloc ) continue;
+      if ( ! pdgs.empty() &&
+           std::find(pdgs.begin(),pdgs.end(),pdg) == pdgs.end() ) continue;
+      double elo = ( ebin < 0 )        ? -DBL_MAX : edges[ebin];
+      double ehi = ( ebin >= nedges-1 ) ?  DBL_MAX : edges[ebin+1];
+      if ( elo >= emax || ehi <= emin ) continue;
+      index->GetEntry(ibucket);
+      entries.insert(entries.end(),entry.begin(),entry.begin()+n);
+      if ( sumwgt ) *sumwgt += wgt;
+    }
+    // each entry is in one bucket per location, so sorting is enough
+    std::sort(entries.begin()+nbefore,entries.end());
+
+    fidx.Close();
+    return nentries;
+  }
+
+} // end-of-namespace "bsim"
@@ -0,0 +1,41 @@
+#include <string>
+#include <vector>
+
+#include "Rtypes.h"
+
+/// bsim namespace for beam simulation classes and functions
+namespace bsim {
+
+  /// Name of the index ("sidecar") file that goes with a dk2nu file:
+  /// "xyz.root" --> "xyz.idx.root"
+  std::string dk2nuIndexFileName(std::string fluxfile);
+
+  /// Write an index of a dk2nu file.  For every location in the
+  /// DkMeta::location list the entries are bucketed by (neutrino pdg,
+  /// energy bin of nuray[iloc].E); each bucket holds the sorted entry
+  /// numbers and the sum of decay.nimpwt*nuray[iloc].wgt.  The energy
+  /// bins are nbins uniform bins in [emin,emax) (GeV) plus an underflow
+  /// (-1) and overflow (nbins) bin.  Only the decay and nuray branches
+  /// are read.  The index file (default dk2nuIndexFileName(fluxfile))
+  /// holds two trees:
+  ///   "dk2nuIndexHead" : nentries pots nloc nedges edges[nedges]
+  ///   "dk2nuIndex"     : pdg iloc ebin sumwgt n entry[n]
+  /// Returns the number of buckets written, -1 on failure.
+  int buildDk2NuIndex(std::string fluxfile, std::string indexfile = "",
+                      int nbins = 240, double emin = 0., double emax = 120.,
+                      std::string treename = "dk2nuTree",
+                      std::string metaname = "dkmetaTree");
+
+  /// Append to entries the (sorted) entry numbers of the buckets of
+  /// location iloc whose pdg is in pdgs (empty = all) and whose energy
+  /// bin overlaps [emin,emax).  Bins are only partially covered at the
+  /// edges of the range, so the selection is a superset; apply the exact
+  /// cut to the entries read.  If sumwgt is given the bucket weight sums
+  /// are added to it.  Returns the number of entries in the indexed
+  /// file (to check the index against it), -1 on failure.
+  Long64_t readDk2NuIndex(std::string indexfile, const std::vector<int>& pdgs,
+                          int iloc, double emin, double emax,
+                          std::vector<Long64_t>& entries,
+                          double* sumwgt = 0);
+
+} // end-of-namespace "bsim"
@@ -0,0 +1,204 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+#include <vector>
+
+#include "tree/tuneTreeWriter.h"
+
+#include "TTree.h"
+#include "TBranch.h"
+#include "TObjArray.h"
+#include "TStopwatch.h"
+#include "Compression.h"
+#include "RVersion.h"
+
+namespace {
+
+  // top-level dk2nu members in each group, blank separated with a
+  // leading and trailing blank so " name " can be searched for
+  const std::string kHotMembers  = " job potnum decay nuray ppvx ppvy ppvz flagbits ";
+  const std::string kColdMembers = " ancestor tgtexit traj vint vdbl ";
+
+  /// is any "."-separated component of the branch name in members
+  bool inMembers(const std::string& bname, const std::string& members)
+  {
+    size_t start = 0;
+    while ( start < bname.size() ) {
+      size_t end = bname.find('.',start);
+      if ( end == std::string::npos ) end = bname.size();
+      std::string part = bname.substr(start,end-start);
+      size_t ibrk = part.find('[');
+      if ( ibrk != std::string::npos ) part.erase(ibrk);
+      if ( ! part.empty() &&
+           members.find(" " + part + " ") != std::string::npos ) return true;
+      start = end + 1;
+    }
+    return false;
+  }
+
+  void setBasketSizeAll(TBranch* branch, Int_t basketsize)
+  {
+    branch->SetBasketSize(basketsize);
+    TObjArray* sub = branch->GetListOfBranches();
+    for ( int i = 0; i < sub->GetEntriesFast(); ++i )
+      setBasketSizeAll((TBranch*)sub->At(i),basketsize);
+  }
+
+  int configure(TObjArray* branches, const std::string& members,
+                int settings, Int_t basketsize)
+  {
+    int nchanged = 0;
+    for ( int i = 0; i < branches->GetEntriesFast(); ++i ) {
+      TBranch* branch = (TBranch*)branches->At(i);
+      if ( inMembers(branch->GetName(),members) ) {
+        // recurses into the sub-branches
+        branch->SetCompressionSettings(settings);
+        if ( basketsize > 0 ) setBasketSizeAll(branch,basketsize);
+        ++nchanged;
+      } else {
+        nchanged += configure(branch->GetListOfBranches(),members,
+                              settings,basketsize);
+      }
+    }
+    return nchanged;
+  }
+
+  /// the branches that hold data (no sub-branches), by group
+  void collectLeaves(TObjArray* branches, std::vector<TBranch*> groups[3])
+  {
+    for ( int i = 0; i < branches->GetEntriesFast(); ++i ) {
+      TBranch* branch = (TBranch*)branches->At(i);
+      if ( branch->GetListOfBranches()->GetEntriesFast() > 0 ) {
+        collectLeaves(branch->GetListOfBranches(),groups);
+        continue;
+      }
+      if      ( inMembers(branch->GetName(),kHotMembers)  ) groups[0].push_back(branch);
+      else if ( inMembers(branch->GetName(),kColdMembers) ) groups[1].push_back(branch);
+      else                                                  groups[2].push_back(branch);
+    }
+  }
+
+} // end of anonymous namespace
+
+/// convert "algorithm:level" to ROOT compression settings
+int bsim::compressionSettings(std::string compression)
+{
+  std::string algname = compression;
+  int         level   = 1;
+  size_t icolon = compression.find(':');
+  if ( icolon != std::string::npos ) {
+    algname = compression.substr(0,icolon);
+    level   = atoi(compression.substr(icolon+1).c_str());
+  }
+
+  int alg = ROOT::kZLIB;
+  if      ( algname == "zlib" ) alg = ROOT::kZLIB;
+  else if ( algname == "lzma" ) alg = ROOT::kLZMA;
+  else if ( algname == "lz4"  ) {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,8,0)
+    alg = ROOT::kLZ4;
+#else
+    std::cerr << "bsim::compressionSettings lz4 needs ROOT 6.08, using zlib"
+              << std::endl;
+#endif
+  }
+  else if ( algname == "zstd" ) {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,20,0)
+    alg = ROOT::kZSTD;
+#else
+    std::cerr << "bsim::compressionSettings zstd needs ROOT 6.20, using lzma"
+              << std::endl;
+    alg = ROOT::kLZMA;
+#endif
+  }
+  else {
+    std::cerr << "bsim::compressionSettings unknown algorithm \"" << algname
+              << "\", using zlib" << std::endl;
+  }
+  if ( level < 0 ) level = 0;
+  if ( level > 9 ) level = 9;
+  return 100*alg + level;
+}
+
+/// Set the compression and basket size of the named top-level members
+int bsim::setBranchCompression(TTree* tree, std::string members,
+                               std::string compression, Int_t basketsize)
+{
+  return configure(tree->GetListOfBranches()," " + members + " ",
+                   bsim::compressionSettings(compression),basketsize);
+}
+
+/// Set compression, basket size and auto-flush of a dk2nuTree
+void bsim::tuneDk2NuTree(TTree* tree, std::string hot, std::string cold,
+                         Int_t hotBasket, Int_t coldBasket, Long64_t autoflush)
+{
+  int nhot  = configure(tree->GetListOfBranches(),kHotMembers,
+                        bsim::compressionSettings(hot),hotBasket);
+  int ncold = configure(tree->GetListOfBranches(),kColdMembers,
+                        bsim::compressionSettings(cold),coldBasket);
+  tree->SetAutoFlush(autoflush);
+
+  std::cout << "tuneDk2NuTree " << tree->GetName()
+            << ": " << nhot  << " hot branches (" << hot
+            << ", basket " << hotBasket << "), "
+            << ncold << " cold branches (" << cold
+            << ", basket " << coldBasket << "), autoflush "
+            << autoflush << std::endl;
+}
+
+/// Print size and read time of the hot, cold and remaining branches
+void bsim::reportTreeCompression(TTree* tree, bool timeReads, std::ostream& os)
+{
+  std::vector<TBranch*> groups[3];
+  collectLeaves(tree->GetListOfBranches(),groups);
+  const char* names[3] = { "hot", "cold", "other" };
+
+  const Long64_t nentries = tree->GetEntries();
+  const double   mb       = 1024.*1024.;
+
+  os << "reportTreeCompression " << tree->GetName() << " "
+     << nentries << " entries\n"
+     << "  group  branches     raw(MB)     zip(MB)   factor";
+  if ( timeReads ) os << "    read(s)  raw MB/s";
+  os << "\n";
+
+  double rawall = 0, zipall = 0;
+  for ( int g = 0; g < 3; ++g ) {
+    double raw = 0, zip = 0;
+    for ( size_t i = 0; i < groups[g].size(); ++i ) {
+      raw += groups[g][i]->GetTotBytes();
+      zip += groups[g][i]->GetZipBytes();
+    }
+    rawall += raw;
+    zipall += zip;
+
+    os << "  " << std::setw(5)  << names[g]
+       << " "  << std::setw(9)  << groups[g].size()
+       << std::fixed << std::setprecision(3)
+       << " "  << std::setw(11) << raw/mb
+       << " "  << std::setw(11) << zip/mb
+       << std::setprecision(2)
+       << " "  << std::setw(8)  << ( ( zip > 0 ) ? raw/zip : 0 );
+
+    if ( timeReads ) {
+      // read the group on its own, basket by basket from the file
+      TStopwatch timer;
+      timer.Start();
+      for ( Long64_t ientry = 0; ientry < nentries; ++ientry )
+        for ( size_t i = 0; i < groups[g].size(); ++i )
+          groups[g][i]->GetEntry(ientry);
+      timer.Stop();
+      double t = timer.RealTime();
+      os << std::setprecision(3)
+         << " " << std::setw(10) << t
+         << std::setprecision(1)
+         << " " << std::setw(9)  << ( ( t > 0 ) ? raw/mb/t : 0 );
+    }
+    os << "\n";
+    os.unsetf(std::ios::floatfield);
+  }
+  os << "  total on disk " << std::setprecision(4) << zipall/mb
+     << " MB, compression factor "
+     << ( ( zipall > 0 ) ? rawall/zipall : 0 ) << std::endl;
+}
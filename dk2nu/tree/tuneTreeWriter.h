@@ -0,0 +1,45 @@
+#include <string>
+#include <iostream>
+
+class TTree;
+
+#include "Rtypes.h"
+
+/// bsim namespace for beam simulation classes and functions
+namespace bsim {
+
+  /// Set compression, basket size and auto-flush of a dk2nuTree before
+  /// it is filled.  Branches are configured in two groups:
+  ///   "hot"  : job potnum decay nuray ppvx ppvy ppvz flagbits
+  ///            read for every entry by flux drivers; fast to decompress
+  ///   "cold" : ancestor tgtexit traj vint vdbl
+  ///            rarely read; compressed as tightly as possible
+  /// Compression is given as "algorithm:level" where algorithm is one of
+  /// zlib, lzma, lz4 or zstd (lz4 and zstd need ROOT >= 6.08 and 6.20
+  /// and fall back to zlib and lzma otherwise).  Auto-flush is per tree,
+  /// following TTree::SetAutoFlush (negative = bytes, positive = entries).
+  void tuneDk2NuTree(TTree* tree,
+                     std::string hot      = "zlib:1",
+                     std::string cold     = "lzma:8",
+                     Int_t       hotBasket  = 256000,
+                     Int_t       coldBasket = 64000,
+                     Long64_t    autoflush  = -30000000);
+
+  /// Set the compression ("algorithm:level") and basket size of the
+  /// named top-level members ("decay nuray ...") of the branches of
+  /// tree, including all of their sub-branches.  Returns the number of
+  /// branches changed.
+  int setBranchCompression(TTree* tree, std::string members,
+                           std::string compression, Int_t basketsize = 0);
+
+  /// convert "algorithm:level" to ROOT compression settings
+  int compressionSettings(std::string compression);
+
+  /// Print the uncompressed and compressed size of the hot, cold and
+  /// remaining branch groups and, if timeReads, the time to read each
+  /// group back.  Call after the tree has been written (or on a tree
+  /// read from a file) so the baskets come from disk.
+  void reportTreeCompression(TTree* tree, bool timeReads = true,
+                             std::ostream& os = std::cout);
+
+} // end-of-namespace "bsim"